@@ -0,0 +1,68 @@
+#define MODE_TEXTURED 0u
+#define MODE_TEXT 1u
+#define MODE_SOLID 2u
+#define MODE_BLUR 3u
+
+#if defined VERT
+
+#include "worldinfo.glsl"
+
+layout(location = 0) in vec2 attrPosition;
+layout(location = 1) in vec2 attrTexCoord;
+layout(location = 2) in vec4 attrColor;
+layout(location = 3) in uint attrMode;
+layout(location = 4) in float attrAlpha;
+
+layout(location = 0) out vec2 outTexCoord;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) out vec2 outScreenTexCoord;
+layout(location = 3) flat out uint outMode;
+layout(location = 4) out float outAlpha;
+
+void main()
+{
+    gl_Position = orthoProjection * vec4(attrPosition, 0.0, 1.0);
+    outScreenTexCoord = (gl_Position.xy + 1.0) * 0.5;
+    outTexCoord = attrTexCoord;
+    outColor = attrColor;
+    outMode = attrMode;
+    outAlpha = attrAlpha;
+}
+
+#elif defined FRAG
+
+layout(binding = 0) uniform sampler2D texBlurBg;
+layout(binding = 1) uniform sampler2D tex;
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec2 inScreenTexCoord;
+layout(location = 3) flat in uint inMode;
+layout(location = 4) in float inAlpha;
+
+void main()
+{
+    vec4 texColor = texture(tex, inTexCoord);
+    if (inMode == MODE_SOLID)
+    {
+        outColor = inColor;
+    }
+    else if (inMode == MODE_TEXT)
+    {
+        outColor = inColor * vec4(1.0, 1.0, 1.0, texColor.r);
+    }
+    else if (inMode == MODE_BLUR)
+    {
+        vec4 c = inColor * texColor;
+        outColor = vec4(mix(texture(texBlurBg, inScreenTexCoord).rgb, c.rgb, c.a),
+                texColor.a * inAlpha);
+    }
+    else
+    {
+        outColor = inColor * texColor;
+    }
+}
+
+#endif
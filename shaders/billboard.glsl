@@ -8,9 +8,16 @@ layout(location = 1) out vec3 outWorldPos;
 layout(location = 2) out vec3 outShadowCoord;
 #endif
 
+#if defined PARTICLE
+layout(location = 0) in vec4 attrPositionScale;
+layout(location = 1) in vec4 attrColor;
+layout(location = 2) in float attrAngle;
+layout(location = 3) out vec4 outColor;
+#else
 layout(location = 1) uniform mat4 translation;
 layout(location = 2) uniform vec3 scale;
 layout(location = 3) uniform mat4 rotation;
+#endif
 
 const vec2 vertices[6] = vec2[](
     vec2(-1, -1),
@@ -34,6 +41,20 @@ const vec2 uvs[6] = vec2[](
 
 void main()
 {
+#if defined PARTICLE
+    mat4 translation = mat4(1.0);
+    translation[3] = vec4(attrPositionScale.xyz, 1.0);
+    vec3 scale = vec3(attrPositionScale.w);
+    float c = cos(attrAngle);
+    float s = sin(attrAngle);
+    mat4 rotation = mat4(1.0);
+    rotation[0][0] = c;
+    rotation[0][1] = s;
+    rotation[1][0] = -s;
+    rotation[1][1] = c;
+    outColor = attrColor;
+#endif
+
     mat4 modelView = cameraView * translation;
     modelView[0][0] = scale.x;
     modelView[0][1] = 0;
@@ -73,7 +94,11 @@ layout(location = 0) out vec4 outColor;
 layout(binding = 0) uniform sampler2D texSampler;
 layout(binding = 1) uniform sampler2D depthSampler;
 
+#if defined PARTICLE
+layout(location = 3) in vec4 color;
+#else
 layout(location = 0) uniform vec4 color;
+#endif
 
 void main()
 {
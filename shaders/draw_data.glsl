@@ -0,0 +1,21 @@
+struct DrawData
+{
+    mat4 worldMatrix;
+    mat3 normalMatrix;
+    vec4 color;      // w: alpha cutoff
+    vec4 emit;       // w: wind amount
+    vec4 fresnel;    // x: bias, y: scale, z: power
+    vec4 specular;   // x: power, y: strength
+    vec4 reflection; // x: strength, y: lod, z: bias
+    uint pickValue;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(std430, binding = 1) readonly buffer DrawDataBuffer
+{
+    DrawData drawData[];
+};
+
+layout(location = 20) uniform uint drawIndex;
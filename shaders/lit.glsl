@@ -1,4 +1,5 @@
 #include "worldinfo.glsl"
+#include "draw_data.glsl"
 
 #if defined VERT
 
@@ -8,10 +9,6 @@ layout(location = 2) in vec4 attrTangent;
 layout(location = 3) in vec2 attrTexCoord;
 layout(location = 4) in vec3 attrColor;
 
-layout(location = 0) uniform mat4 worldMatrix;
-layout(location = 1) uniform mat3 normalMatrix;
-layout(location = 8) uniform float windAmount;
-
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out vec3 outWorldPosition;
@@ -26,9 +23,10 @@ layout(location = 6) out mat3 outTBN;
 
 void main()
 {
+    mat4 worldMatrix = drawData[drawIndex].worldMatrix;
     outWorldPosition = (worldMatrix * vec4(attrPosition, 1.0)).xyz;
 #if !defined VEHICLE
-    outWorldPosition.x += sin(outWorldPosition.x + outWorldPosition.y * 0.5f + outWorldPosition.z * 0.2f + time * 0.8f) * windAmount * attrTexCoord.y;
+    outWorldPosition.x += sin(outWorldPosition.x + outWorldPosition.y * 0.5f + outWorldPosition.z * 0.2f + time * 0.8f) * drawData[drawIndex].emit.w * attrTexCoord.y;
 #endif
     //outWorldPosition.x += sin(outWorldPosition.x * 0.5f + outWorldPosition.y * 0.1f + outWorldPosition.z * 0.25f + time * 0.2f) * 0.15f * windAmount * attrTexCoord.y;
     gl_Position = cameraViewProjection * vec4(outWorldPosition, 1.0);
@@ -38,6 +36,7 @@ void main()
 #endif
 
 #if !defined DEPTH_ONLY
+    mat3 normalMatrix = drawData[drawIndex].normalMatrix;
     outNormal = normalize(normalMatrix * attrNormal);
     outShadowCoord = (shadowViewProjectionBias * vec4(outWorldPosition, 1.0)).xyz;
     outColor = attrColor;
@@ -59,7 +58,6 @@ void main()
 
 #if defined OUT_ID
 layout(location = 0) out uint outID;
-layout(location = 9) uniform uint highlightID;
 #else
 layout(location = 0) out vec4 outColor;
 #endif
@@ -76,13 +74,6 @@ layout(location = 5) in vec3 inLocalPosition;
 layout(location = 6) in mat3 inTBN;
 #endif
 
-layout(location = 2) uniform vec3 color;
-layout(location = 3) uniform vec3 fresnel; // x: bias, y: scale, z: power
-layout(location = 4) uniform vec3 specular; // x: power, y: strength
-layout(location = 5) uniform float minAlpha;
-layout(location = 6) uniform vec3 emit;
-layout(location = 7) uniform vec3 reflection;
-
 #if defined VEHICLE
 layout(location = 10) uniform vec4 shield;
 layout(location = 11) uniform vec4 wrapColor[3];
@@ -104,7 +95,7 @@ void main()
 #endif
 
 #if defined ALPHA_DISCARD
-    if (tex.a < minAlpha) { discard; }
+    if (tex.a < drawData[drawIndex].color.w) { discard; }
 #endif
 #endif
 
@@ -114,9 +105,14 @@ void main()
 #else
     vec3 normal = inNormal;
 #endif
+    vec3 color = drawData[drawIndex].color.rgb;
+    vec3 fresnel = drawData[drawIndex].fresnel.xyz;
+    vec3 specular = drawData[drawIndex].specular.xyz;
+    vec3 emit = drawData[drawIndex].emit.rgb;
+    vec3 reflection = drawData[drawIndex].reflection.xyz;
 
 #if defined OUT_ID
-    outID = highlightID;
+    outID = drawData[drawIndex].pickValue;
 #else
 #if defined VEHICLE
     /*
@@ -155,11 +151,16 @@ void main()
     vec4 baseColor = vec4(mix(color, patternColor.rgb, patternColor.a), 1.0);
     */
 
+#if defined VINYL_BAKED
+    // paint and vinyls composited by VinylBaker
+    vec4 baseColor = vec4(texture(wrapSampler1, inTexCoord).rgb, 1.0);
+#else
     vec4 wrap1 = texture(wrapSampler1, inTexCoord) * wrapColor[0];
     vec4 wrap2 = texture(wrapSampler2, inTexCoord) * wrapColor[1];
     vec4 wrap3 = texture(wrapSampler3, inTexCoord) * wrapColor[2];
     vec4 baseColor =
         vec4(mix(mix(mix(color, wrap1.rgb, wrap1.a), wrap2.rgb, wrap2.a), wrap3.rgb, wrap3.a), 1.0);
+#endif
 #else
     vec4 baseColor = tex * vec4(inColor * color, 1.0);
 #endif
@@ -0,0 +1,31 @@
+#if defined VERT
+
+layout(location = 0) out vec2 outTexCoord;
+
+void main()
+{
+    gl_Position = vec4(-1.0 + float((gl_VertexID & 1) << 2), -1.0 + float((gl_VertexID & 2) << 1), 0.0, 1.0);
+    outTexCoord = vec2((gl_Position.x + 1.0) * 0.5, (gl_Position.y + 1.0) * 0.5);
+}
+
+#elif defined FRAG
+
+layout(location = 0) in vec2 inTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) uniform vec3 color;
+layout(location = 1) uniform vec4 wrapColor[3];
+layout(binding = 6) uniform sampler2D wrapSampler1;
+layout(binding = 7) uniform sampler2D wrapSampler2;
+layout(binding = 8) uniform sampler2D wrapSampler3;
+
+void main()
+{
+    // same blend as the layered vehicle paint in lit.glsl
+    vec4 wrap1 = texture(wrapSampler1, inTexCoord) * wrapColor[0];
+    vec4 wrap2 = texture(wrapSampler2, inTexCoord) * wrapColor[1];
+    vec4 wrap3 = texture(wrapSampler3, inTexCoord) * wrapColor[2];
+    outColor = vec4(mix(mix(mix(color, wrap1.rgb, wrap1.a), wrap2.rgb, wrap2.a), wrap3.rgb, wrap3.a), 1.0);
+}
+#endif
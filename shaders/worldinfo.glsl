@@ -1,17 +1,3 @@
-struct PointLight
-{
-    vec3 position;
-    float radius;
-    vec3 color;
-    float falloff;
-};
-
-struct LightPartition
-{
-    PointLight pointLights[MAX_POINT_LIGHTS];
-    uint pointLightCount;
-};
-
 layout (std140, binding = 0) uniform WorldInfo
 {
     mat4 orthoProjection;
@@ -24,7 +10,9 @@ layout (std140, binding = 0) uniform WorldInfo
     mat4 cameraView;
     vec3 cameraPosition;
     mat4 shadowViewProjectionBias;
-    LightPartition lightPartitions[LIGHT_SPLITS][LIGHT_SPLITS];
+    float clusterDepthScale;
+    float clusterDepthBias;
+    vec2 pad2;
     vec3 fogColor;
     float fogDensity;
     vec2 invResolution;
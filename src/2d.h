@@ -2,6 +2,7 @@
 
 #include "game.h"
 #include "font.h"
+#include "batcher_2d.h"
 
 namespace ui
 {
@@ -20,14 +21,21 @@ namespace ui
         f32 alpha = 1.f;
     };
 
-    void drawQuad(Quad const& q)
+    void addQuad(i32 priority, Quad const& q, u32 mode)
     {
-        glBindTextureUnit(1, q.tex->handle);
-        glUniform4fv(0, 4, (GLfloat*)&q.points);
-        glUniform4fv(4, 1, (GLfloat*)&q.color1);
-        glUniform4fv(6, 1, (GLfloat*)&q.color2);
-        glUniform1f(5, q.alpha);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        Vec2 positions[4], texCoords[4];
+        for (u32 i=0; i<4; ++i)
+        {
+            positions[i] = q.points[i].xy;
+            texCoords[i] = q.points[i].uv;
+        }
+        // the white texture doesn't need to be sampled, so it can share a draw with anything
+        if (mode == Quad2DMode::TEXTURED && q.tex == &g_res.white)
+        {
+            mode = Quad2DMode::SOLID;
+        }
+        g_game.renderer->getBatcher2D().add(priority, q.tex->handle, mode, positions, texCoords,
+                q.color1, q.color2, q.alpha);
     }
 
     Mat4 transform(1.f);
@@ -98,7 +106,6 @@ namespace ui
     void rect(i32 priority, Texture* tex, Vec2 pos, Vec2 size,
             Vec3 const& color=Vec3(1.f), f32 alpha=1.f)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", { {"GRADIENT"}, {"COLOR"} });
         Vec2 t1(0.f);
         Vec2 t2(1.f);
         Vec2 p1 = pos;
@@ -116,14 +123,13 @@ namespace ui
 
         if (transformQuad(q, transform, scissorPos, scissorSize))
         {
-            g_game.renderer->add2D(shader, priority, [q]{ drawQuad(q); });
+            addQuad(priority, q, Quad2DMode::TEXTURED);
         }
     }
 
     void rectUV(i32 priority, Texture* tex, Vec2 pos, Vec2 size,
             Vec2 t1, Vec2 t2, Vec3 const& color=Vec3(1.f), f32 alpha=1.f)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", { {"GRADIENT"}, {"COLOR"} });
         Vec2 p1 = pos;
         Vec2 p2 = p1 + size;
 
@@ -139,14 +145,13 @@ namespace ui
 
         if (transformQuad(q, transform, scissorPos, scissorSize))
         {
-            g_game.renderer->add2D(shader, priority, [q]{ drawQuad(q); });
+            addQuad(priority, q, Quad2DMode::TEXTURED);
         }
     }
 
     void rectBlur(i32 priority, Texture* tex, Vec2 pos, Vec2 size,
             Vec4 const& color=Vec4(1.f), f32 alpha=1.f)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", { {"GRADIENT"}, {"BLUR"} });
         Vec2 t1(0.f);
         Vec2 t2(1.f);
         Vec2 p1 = pos;
@@ -164,14 +169,13 @@ namespace ui
 
         if (transformQuad(q, transform, scissorPos, scissorSize))
         {
-            g_game.renderer->add2D(shader, priority, [q]{ drawQuad(q); });
+            addQuad(priority, q, Quad2DMode::BLUR);
         }
     }
 
     void rectBlur(i32 priority, Texture* tex, Vec2 pos, Vec2 size,
             Vec4 const& color1, Vec4 const& color2, f32 alpha=1.f)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", { {"GRADIENT"}, {"BLUR"} });
         Vec2 t1(0.f);
         Vec2 t2(1.f);
         Vec2 p1 = pos;
@@ -189,14 +193,13 @@ namespace ui
 
         if (transformQuad(q, transform, scissorPos, scissorSize))
         {
-            g_game.renderer->add2D(shader, priority, [q]{ drawQuad(q); });
+            addQuad(priority, q, Quad2DMode::BLUR);
         }
     }
 
     void rectUVBlur(i32 priority, Texture* tex, Vec2 pos, Vec2 size,
             Vec2 t1, Vec2 t2, Vec4 const& color=Vec4(1.f), f32 alpha=1.f)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", { {"GRADIENT"}, {"BLUR"} });
         Vec2 p1 = pos;
         Vec2 p2 = p1 + size;
 
@@ -212,46 +215,14 @@ namespace ui
 
         if (transformQuad(q, transform, scissorPos, scissorSize))
         {
-            g_game.renderer->add2D(shader, priority, [q]{ drawQuad(q); });
+            addQuad(priority, q, Quad2DMode::BLUR);
         }
     }
 
-    struct Text
-    {
-        Font* font;
-        const char* text;
-        Vec2 pos;
-        Vec3 color;
-        f32 alpha = 1.f;
-        f32 scale = 1.f;
-        HAlign halign;
-        VAlign valign;
-        Mat4 transform;
-        Vec2 scissorPos;
-        Vec2 scissorSize;
-    };
-
     void text(i32 priority, Font* font, const char* s, Vec2 pos, Vec3 color, f32 alpha=1.f,
             f32 scale=1.f, HAlign halign=HAlign::LEFT, VAlign valign=VAlign::TOP)
     {
-        static ShaderHandle shader = getShaderHandle("quad2D", {});
-
-        Text text;
-        text.font = font;
-        text.text = s;
-        text.pos = pos;
-        text.color = color;
-        text.alpha = alpha;
-        text.scale = scale;
-        text.halign = halign;
-        text.valign = valign;
-        text.transform = transform;
-        text.scissorPos = scissorPos;
-        text.scissorSize = scissorSize;
-
-        g_game.renderer->add2D(shader, priority, [text]{
-            text.font->draw(text.text, text.pos, text.color, text.alpha, text.scale,
-                    text.halign, text.valign, text.transform, text.scissorPos, text.scissorSize);
-        });
+        font->draw(priority, s, pos, color, alpha, scale, halign, valign, transform, scissorPos,
+                scissorSize);
     }
 };
@@ -50,7 +50,7 @@ public:
     {
         for (auto& batch : batches)
         {
-            batch.material->draw(rw, transform, &batch.mesh);
+            batch.material->draw(rw, transform, &batch.mesh, 0, true);
         }
     }
 
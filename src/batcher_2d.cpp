@@ -0,0 +1,151 @@
+#include "batcher_2d.h"
+#include "imgui.h"
+
+void Batcher2D::add(i32 priority, GLuint texture, u32 mode, Vec2 const positions[4],
+        Vec2 const texCoords[4], Vec4 const& color1, Vec4 const& color2, f32 alpha)
+{
+    if (quads.size() == MAX_QUADS)
+    {
+        ++droppedCount;
+        return;
+    }
+
+    Quad2D q;
+    q.texture = texture;
+    q.priority = priority;
+    for (u32 i=0; i<4; ++i)
+    {
+        Vertex2D& v = q.vertices[i];
+        v.position = positions[i];
+        v.texCoord = texCoords[i];
+        v.color = lerp(color1, color2, texCoords[i].x);
+        v.mode = mode;
+        v.alpha = alpha;
+    }
+    quads.push(q);
+}
+
+void Batcher2D::build(GLuint whiteTexture, bool mergePriorities)
+{
+    batches.clear();
+    lastQuadCount = quads.size();
+    lastDrawCount = 0;
+    if (quads.empty())
+    {
+        return;
+    }
+
+    if (!vao)
+    {
+        glCreateVertexArrays(1, &vao);
+
+        glEnableVertexArrayAttrib(vao, 0);
+        glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex2D, position));
+        glVertexArrayAttribBinding(vao, 0, 0);
+
+        glEnableVertexArrayAttrib(vao, 1);
+        glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex2D, texCoord));
+        glVertexArrayAttribBinding(vao, 1, 0);
+
+        glEnableVertexArrayAttrib(vao, 2);
+        glVertexArrayAttribFormat(vao, 2, 4, GL_FLOAT, GL_FALSE, offsetof(Vertex2D, color));
+        glVertexArrayAttribBinding(vao, 2, 0);
+
+        glEnableVertexArrayAttrib(vao, 3);
+        glVertexArrayAttribIFormat(vao, 3, 1, GL_UNSIGNED_INT, offsetof(Vertex2D, mode));
+        glVertexArrayAttribBinding(vao, 3, 0);
+
+        glEnableVertexArrayAttrib(vao, 4);
+        glVertexArrayAttribFormat(vao, 4, 1, GL_FLOAT, GL_FALSE, offsetof(Vertex2D, alpha));
+        glVertexArrayAttribBinding(vao, 4, 0);
+
+        // same triangles as a strip of the four points, the indices never change
+        Array<u32> indices(MAX_QUADS * 6);
+        for (u32 i=0; i<MAX_QUADS; ++i)
+        {
+            u32 v = i * 4;
+            u32* index = indices.data() + i * 6;
+            index[0] = v + 0;
+            index[1] = v + 1;
+            index[2] = v + 2;
+            index[3] = v + 2;
+            index[4] = v + 1;
+            index[5] = v + 3;
+        }
+        glCreateBuffers(1, &indexBuffer);
+        glNamedBufferStorage(indexBuffer, indices.size() * sizeof(u32), indices.data(), 0);
+        glVertexArrayElementBuffer(vao, indexBuffer);
+    }
+
+    // the index makes every key unique, so the order within a priority is kept
+    sortKeys.resize(quads.size());
+    for (u32 i=0; i<quads.size(); ++i)
+    {
+        sortKeys[i] = ((u64)((u32)quads[i].priority ^ 0x80000000u) << 32) | i;
+    }
+    sortKeys.sort();
+
+    assert(quads.size() <= MAX_QUADS);
+    size_t size = quads.size() * 4 * sizeof(Vertex2D);
+    Vertex2D* vertices = (Vertex2D*)vertexBuffer.map(size, &vertexOffset);
+    Batch* batch = nullptr;
+    for (u32 i=0; i<sortKeys.size(); ++i)
+    {
+        Quad2D const& q = quads[(u32)sortKeys[i]];
+        memcpy(vertices + i * 4, q.vertices, sizeof(q.vertices));
+
+        bool isSolid = q.vertices[0].mode == Quad2DMode::SOLID;
+        bool canMerge = batch && isBatchingEnabled
+            && (mergePriorities || batch->priority == q.priority)
+            && (isSolid || batch->texture == 0 || batch->texture == q.texture);
+        if (canMerge)
+        {
+            if (!isSolid)
+            {
+                batch->texture = q.texture;
+            }
+            ++batch->quadCount;
+        }
+        else
+        {
+            batches.push({ this, isSolid ? 0 : q.texture, q.priority, i, 1 });
+            batch = &batches.back();
+        }
+    }
+    vertexBuffer.unmap();
+
+    for (auto& b : batches)
+    {
+        if (b.texture == 0)
+        {
+            b.texture = whiteTexture;
+        }
+    }
+    lastDrawCount = batches.size();
+}
+
+void Batcher2D::drawBatch(void* renderData)
+{
+    Batch const* b = (Batch const*)renderData;
+    Batcher2D* batcher = b->batcher;
+    glVertexArrayVertexBuffer(batcher->vao, 0, batcher->vertexBuffer.getBuffer(),
+            batcher->vertexOffset, sizeof(Vertex2D));
+    glBindVertexArray(batcher->vao);
+    glBindTextureUnit(1, b->texture);
+    glDrawElements(GL_TRIANGLES, b->quadCount * 6, GL_UNSIGNED_INT,
+            (void*)(b->firstQuad * 6 * sizeof(u32)));
+}
+
+void Batcher2D::clear()
+{
+    quads.clear();
+    batches.clear();
+}
+
+void Batcher2D::showDebugInfo()
+{
+    ImGui::Checkbox("2D Batching", &isBatchingEnabled);
+    // with batching turned off every quad is its own draw, so compare with it off to see the saving
+    ImGui::Text("2D: %u draws for %u quads, %u dropped", lastDrawCount, lastQuadCount,
+            droppedCount);
+}
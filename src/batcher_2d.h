@@ -0,0 +1,83 @@
+#pragma once
+
+#include "misc.h"
+#include "math.h"
+#include "gl.h"
+#include "dynamic_buffer.h"
+
+namespace Quad2DMode
+{
+    enum
+    {
+        TEXTURED, // color * texture
+        TEXT,     // color with the alpha from the red channel of the texture
+        SOLID,    // color only, so it can be drawn with any texture bound
+        BLUR,     // blended with the blurred background
+    };
+};
+
+struct Vertex2D
+{
+    Vec2 position;
+    Vec2 texCoord;
+    Vec4 color;
+    u32 mode;
+    f32 alpha;
+};
+
+// Collects the 2D quads and glyphs of a frame and draws them in as few draw calls as possible.
+// The quads are sorted by priority (keeping the order they were added in within a priority),
+// written to one vertex buffer, and consecutive quads with the same texture are drawn together.
+// Solid quads don't sample their texture, so they never start a new draw.
+class Batcher2D
+{
+public:
+    static constexpr u32 MAX_QUADS = 16384;
+
+    struct Batch
+    {
+        Batcher2D* batcher;
+        GLuint texture;
+        i32 priority;
+        u32 firstQuad;
+        u32 quadCount;
+    };
+
+private:
+    struct Quad2D
+    {
+        GLuint texture;
+        i32 priority;
+        Vertex2D vertices[4];
+    };
+
+    Array<Quad2D> quads;
+    Array<u64> sortKeys;
+    Array<Batch> batches;
+    // holds exactly MAX_QUADS, so a full frame maps the whole buffer
+    DynamicBuffer vertexBuffer = DynamicBuffer(sizeof(Vertex2D) * 4 * MAX_QUADS);
+    size_t vertexOffset = 0;
+    GLuint vao = 0;
+    GLuint indexBuffer = 0;
+    u32 droppedCount = 0;
+    u32 lastQuadCount = 0;
+    u32 lastDrawCount = 0;
+
+public:
+    bool isBatchingEnabled = true;
+
+    // points are in the order top left, top right, bottom left, bottom right and the color goes
+    // from color1 to color2 along the u texture coordinate
+    void add(i32 priority, GLuint texture, u32 mode, Vec2 const positions[4],
+            Vec2 const texCoords[4], Vec4 const& color1, Vec4 const& color2, f32 alpha=1.f);
+
+    // Sorts the quads and uploads their vertices. With mergePriorities, quads of different
+    // priorities can share a draw, which is only safe when nothing else is drawn in between.
+    void build(GLuint whiteTexture, bool mergePriorities);
+    Array<Batch> const& getBatches() const { return batches; }
+    // render function of the 2D render items, the render data is a Batch
+    static void drawBatch(void* renderData);
+    void clear();
+
+    void showDebugInfo();
+};
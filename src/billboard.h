@@ -32,5 +32,5 @@ void drawBillboard(RenderWorld* rw, Texture* texture, Vec3 const& position, Vec4
         glUniform3f(2, rd->scale, rd->scale, rd->scale);
         glUniformMatrix4fv(3, 1, GL_FALSE, rd->rotation.valuePtr());
         glDrawArrays(GL_TRIANGLES, 0, 6);
-    } });
+    }, { position, scale * 1.5f } });
 }
@@ -220,3 +220,64 @@ BoundingBox computeCameraFrustumBoundingBox(Mat4 const& inverseViewProj)
 
     return BoundingBox{ { minx, miny, minz }, { maxx, maxy, maxz } };
 }
+
+// a negative radius means the bounds are unknown and the sphere is never culled
+struct BoundingSphere
+{
+    Vec3 center = Vec3(0.f);
+    f32 radius = -1.f;
+};
+
+inline BoundingSphere computeBoundingSphere(BoundingBox const& bb, Mat4 const& transform)
+{
+    f32 scale = sqrtf(max(max(lengthSquared(transform.xAxis()), lengthSquared(transform.yAxis())),
+                lengthSquared(transform.zAxis())));
+    return {
+        (transform * Vec4((bb.min + bb.max) * 0.5f, 1.f)).xyz,
+        length(bb.max - bb.min) * 0.5f * scale
+    };
+}
+
+struct Frustum
+{
+    // xyz is the inward facing normal, w is the distance
+    Vec4 planes[6];
+
+    Frustum() {}
+    Frustum(Mat4 const& viewProjection)
+    {
+        Mat4 const& m = viewProjection;
+        Vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        Vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        Vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        Vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[0] = row3 + row0;
+        planes[1] = row3 - row0;
+        planes[2] = row3 + row1;
+        planes[3] = row3 - row1;
+        planes[4] = row3 - row2;
+        planes[5] = row3 + row2;
+        for (auto& p : planes)
+        {
+            p = p / length(p.xyz);
+        }
+    }
+
+    // the near plane is last so that it can be skipped when depth clamping is enabled
+    bool intersects(BoundingSphere const& sphere, bool ignoreNearPlane=false) const
+    {
+        if (sphere.radius < 0.f)
+        {
+            return true;
+        }
+        u32 planeCount = ignoreNearPlane ? 5 : 6;
+        for (u32 i=0; i<planeCount; ++i)
+        {
+            if (dot(planes[i].xyz, sphere.center) + planes[i].w < -sphere.radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -85,6 +85,11 @@ struct Config
         bool forceFeedbackEnabled = true;
         bool thirdPersonCameraEnabled = false;
         u32 aiDriverCameraCount = 0;
+        u32 aiDecisionInterval = 3;
+        u32 aiFarDecisionInterval = 8;
+        f32 aiFarDistance = 120.f;
+        bool parallelVehicleUpdates = true;
+        u32 maxDebrisActors = 128;
 
         void serialize(Serializer& s)
         {
@@ -93,6 +98,11 @@ struct Config
             s.field(forceFeedbackEnabled);
             s.field(thirdPersonCameraEnabled);
             s.field(aiDriverCameraCount);
+            s.field(aiDecisionInterval);
+            s.field(aiFarDecisionInterval);
+            s.field(aiFarDistance);
+            s.field(parallelVehicleUpdates);
+            s.field(maxDebrisActors);
         }
     } gameplay;
 
@@ -0,0 +1,123 @@
+#include "debris_pool.h"
+#include "game.h"
+#include "imgui.h"
+
+static const PxTransform PARKED_POSE(PxVec3(0.f, 0.f, -10000.f));
+
+void DebrisPool::setup(PxScene* physicsScene, u32 capacity)
+{
+    release();
+
+    this->physicsScene = physicsScene;
+    slots.resize(capacity);
+    freeSlots.reserve(capacity);
+    for (u32 i=0; i<capacity; ++i)
+    {
+        Slot& slot = slots[i];
+        slot.body = g_game.physx.physics->createRigidDynamic(PARKED_POSE);
+        slot.body->setActorFlag(PxActorFlag::eDISABLE_SIMULATION, true);
+        physicsScene->addActor(*slot.body);
+        freeSlots.push(capacity - i - 1);
+    }
+}
+
+void DebrisPool::release()
+{
+    for (auto& slot : slots)
+    {
+        slot.body->release();
+    }
+    slots.clear();
+    freeSlots.clear();
+    recycledCount = 0;
+}
+
+void DebrisPool::park(Slot& slot)
+{
+    slot.body->setLinearVelocity(PxVec3(0.f));
+    slot.body->setAngularVelocity(PxVec3(0.f));
+    slot.body->setActorFlag(PxActorFlag::eDISABLE_SIMULATION, true);
+    slot.body->setGlobalPose(PARKED_POSE);
+    slot.active = false;
+    ++slot.generation;
+}
+
+DebrisHandle DebrisPool::spawn(PxShape* shape, PxTransform const& pose, f32 density,
+        PxVec3 const& linearVelocity, PxVec3 const& angularVelocity, f64 time)
+{
+    // the pool is empty when debris is turned off in the config
+    if (slots.size() == 0)
+    {
+        return {};
+    }
+
+    u32 slotIndex;
+    if (freeSlots.size() > 0)
+    {
+        slotIndex = freeSlots.back();
+        freeSlots.pop();
+    }
+    else
+    {
+        // recycle the oldest debris
+        slotIndex = 0;
+        for (u32 i=1; i<slots.size(); ++i)
+        {
+            if (slots[i].spawnTime < slots[slotIndex].spawnTime)
+            {
+                slotIndex = i;
+            }
+        }
+        park(slots[slotIndex]);
+        ++recycledCount;
+    }
+
+    Slot& slot = slots[slotIndex];
+    if (slot.shape != shape)
+    {
+        if (slot.shape)
+        {
+            slot.body->detachShape(*slot.shape);
+        }
+        slot.body->attachShape(*shape);
+        PxRigidBodyExt::updateMassAndInertia(*slot.body, density);
+        slot.shape = shape;
+    }
+    slot.body->setGlobalPose(pose);
+    slot.body->setActorFlag(PxActorFlag::eDISABLE_SIMULATION, false);
+    slot.body->setLinearVelocity(linearVelocity);
+    slot.body->setAngularVelocity(angularVelocity);
+    slot.spawnTime = time;
+    slot.active = true;
+
+    return { slotIndex, slot.generation };
+}
+
+void DebrisPool::despawn(DebrisHandle handle)
+{
+    if (!get(handle))
+    {
+        return;
+    }
+    park(slots[handle.slot]);
+    freeSlots.push(handle.slot);
+}
+
+void DebrisPool::despawnAll()
+{
+    freeSlots.clear();
+    for (u32 i=0; i<slots.size(); ++i)
+    {
+        if (slots[i].active)
+        {
+            park(slots[i]);
+        }
+        freeSlots.push(slots.size() - i - 1);
+    }
+}
+
+void DebrisPool::showDebugInfo()
+{
+    ImGui::Text("Debris Pool: %u / %u active (%u recycled)",
+            slots.size() - freeSlots.size(), slots.size(), recycledCount);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "math.h"
+
+struct DebrisHandle
+{
+    u32 slot = 0;
+    u32 generation = 0;
+};
+
+// Rigid bodies for debris are created up front and parked with simulation disabled until they
+// are needed. When every body is in use the oldest one is recycled, so handles must be checked
+// with get() before they are used.
+class DebrisPool
+{
+    struct Slot
+    {
+        PxRigidDynamic* body = nullptr;
+        PxShape* shape = nullptr;
+        f64 spawnTime = 0.0;
+        // starts at 1 so that a default constructed handle is never valid
+        u32 generation = 1;
+        bool active = false;
+    };
+
+    PxScene* physicsScene = nullptr;
+    Array<Slot> slots;
+    Array<u32> freeSlots;
+    u32 recycledCount = 0;
+
+    void park(Slot& slot);
+
+public:
+    ~DebrisPool() { release(); }
+
+    void setup(PxScene* physicsScene, u32 capacity);
+    void release();
+
+    // the shape is shared between bodies, so it must not be exclusive. The returned handle is
+    // invalid if the pool has no capacity.
+    DebrisHandle spawn(PxShape* shape, PxTransform const& pose, f32 density,
+            PxVec3 const& linearVelocity, PxVec3 const& angularVelocity, f64 time);
+    void despawn(DebrisHandle handle);
+    void despawnAll();
+
+    // returns null if the body has been despawned or recycled
+    PxRigidDynamic* get(DebrisHandle handle) const
+    {
+        if (handle.slot >= slots.size())
+        {
+            return nullptr;
+        }
+        Slot const& slot = slots[handle.slot];
+        return (slot.active && slot.generation == handle.generation) ? slot.body : nullptr;
+    }
+
+    void showDebugInfo();
+};
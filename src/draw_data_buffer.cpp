@@ -0,0 +1,55 @@
+#include "draw_data_buffer.h"
+#include "game.h"
+#include "imgui.h"
+
+void DrawDataBuffer::init()
+{
+    GLsizeiptr size = sizeof(DrawData) * MAX_DRAWS_PER_FRAME * MAX_BUFFERED_FRAMES;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, nullptr, flags);
+    mapped = (DrawData*)glMapNamedBufferRange(buffer, 0, size, flags);
+    assert(mapped);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, buffer);
+}
+
+void DrawDataBuffer::beginFrame()
+{
+    lastCount = count;
+    if (count > peakCount)
+    {
+        peakCount = count;
+    }
+    count = 0;
+    region = g_game.frameIndex;
+
+    lastWaitTime = 0.0;
+    if (fences[region])
+    {
+        if (glClientWaitSync(fences[region], 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            // the GPU is more than MAX_BUFFERED_FRAMES behind
+            ++stallCount;
+            f64 t = getTime();
+            while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT,
+                        1000000000) == GL_TIMEOUT_EXPIRED) {}
+            lastWaitTime = getTime() - t;
+        }
+        glDeleteSync(fences[region]);
+        fences[region] = 0;
+    }
+}
+
+void DrawDataBuffer::endFrame()
+{
+    assert(!fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void DrawDataBuffer::showDebugInfo()
+{
+    ImGui::Text("Draw Data: %u/%u (peak %u, %.1fkb), dropped: %u", lastCount,
+            MAX_DRAWS_PER_FRAME, peakCount, lastCount * sizeof(DrawData) / 1024.0, droppedCount);
+    ImGui::Text("Draw Data Fence Stalls: %u (last wait %.3fms)", stallCount,
+            lastWaitTime * 1000.0);
+}
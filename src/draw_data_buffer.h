@@ -0,0 +1,77 @@
+#pragma once
+
+#include "misc.h"
+#include "math.h"
+#include "gl.h"
+
+// Per-draw constants of the lit shader, read from a storage buffer indexed by the draw index
+// uniform (see shaders/draw_data.glsl). The layout has to match std430.
+struct DrawData
+{
+    Mat4 worldTransform;
+    Vec4 normalTransform[3];
+    Vec4 color;      // w: alpha cutoff
+    Vec4 emission;   // w: wind amount
+    Vec4 fresnel;    // x: bias, y: scale, z: power
+    Vec4 specular;   // x: power, y: strength
+    Vec4 reflection; // x: strength, y: lod, z: bias
+    u32 pickValue;
+    u32 pad[3];
+
+    void setNormalTransform(Mat3 const& m)
+    {
+        normalTransform[0] = Vec4(m.value[0], 0.f);
+        normalTransform[1] = Vec4(m.value[1], 0.f);
+        normalTransform[2] = Vec4(m.value[2], 0.f);
+    }
+};
+static_assert(sizeof(DrawData) == 208);
+
+const u32 DRAW_DATA_BINDING = 1;
+const u32 DRAW_INDEX_LOCATION = 20;
+
+// A persistently mapped buffer with one region of draw data per buffered frame. Draws write their
+// constants into the region of the current frame when they are submitted, so rendering them only
+// needs the draw index uniform. A fence placed after each frame's commands keeps the CPU from
+// writing to a region that the GPU is still reading from. DynamicBuffer relies on the same
+// fences for its mapped memory.
+class DrawDataBuffer
+{
+    GLuint buffer = 0;
+    DrawData* mapped = nullptr;
+    GLsync fences[MAX_BUFFERED_FRAMES] = {};
+    u32 region = 0;
+    u32 count = 0;
+    u32 lastCount = 0;
+    u32 peakCount = 0;
+    u32 droppedCount = 0;
+    u32 stallCount = 0;
+    f64 lastWaitTime = 0.0;
+
+public:
+    static constexpr u32 MAX_DRAWS_PER_FRAME = 16384;
+
+    void init();
+    void beginFrame();
+    void endFrame();
+
+    // returns false when the region for this frame is full, in which case the draw is skipped
+    bool push(DrawData const& data, u32& drawIndex)
+    {
+        if (count == MAX_DRAWS_PER_FRAME)
+        {
+            if (droppedCount == 0)
+            {
+                error("Draw data buffer is full (%u draws), skipping draws", MAX_DRAWS_PER_FRAME);
+            }
+            ++droppedCount;
+            return false;
+        }
+        drawIndex = region * MAX_DRAWS_PER_FRAME + count++;
+        // the mapped memory is write-combined, so copy the whole thing in one go
+        mapped[drawIndex] = data;
+        return true;
+    }
+
+    void showDebugInfo();
+};
@@ -7,7 +7,7 @@ GLuint DynamicBuffer::getBuffer()
     return buffers[g_game.frameIndex];
 }
 
-void* DynamicBuffer::map(size_t dataSize)
+void* DynamicBuffer::map(size_t dataSize, size_t* mappedOffset)
 {
     if (bufferIndex != g_game.frameIndex)
     {
@@ -15,9 +15,16 @@ void* DynamicBuffer::map(size_t dataSize)
         bufferIndex = g_game.frameIndex;
     }
 
-    assert(offset + dataSize < size);
+    // the last mapping of a frame may fill the buffer exactly
+    assert(offset + dataSize <= size);
+    g_renderStats.addUpload(dataSize);
 
-    void* ptr = glMapNamedBufferRange(getBuffer(), offset, dataSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    checkBuffers();
+    void* ptr = mapped[bufferIndex] + offset;
+    if (mappedOffset)
+    {
+        *mappedOffset = offset;
+    }
     offset += dataSize;
     return ptr;
 }
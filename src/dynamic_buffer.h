@@ -1,12 +1,16 @@
 #pragma once
 
 #include "gl.h"
+#include "render_stats.h"
 
+// One buffer per buffered frame. The buffers stay mapped, and the frame fences in DrawDataBuffer
+// make sure the GPU is done with the current frame's buffer before it is written to again.
 class DynamicBuffer
 {
 private:
     size_t size = 0;
     GLuint buffers[MAX_BUFFERED_FRAMES];
+    u8* mapped[MAX_BUFFERED_FRAMES];
     bool created = false;
     size_t offset = 0;
     u32 bufferIndex = 0;
@@ -18,6 +22,10 @@ public:
     {
         if (created)
         {
+            for (u32 i=0; i<MAX_BUFFERED_FRAMES; ++i)
+            {
+                glUnmapNamedBuffer(buffers[i]);
+            }
             glDeleteBuffers(3, buffers);
             created = false;
         }
@@ -28,9 +36,11 @@ public:
         if (!created)
         {
             glCreateBuffers(3, buffers);
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
             for (u32 i=0; i<MAX_BUFFERED_FRAMES; ++i)
             {
-                glNamedBufferData(buffers[i], size, nullptr, GL_DYNAMIC_DRAW);
+                glNamedBufferStorage(buffers[i], size, nullptr, flags | GL_DYNAMIC_STORAGE_BIT);
+                mapped[i] = (u8*)glMapNamedBufferRange(buffers[i], 0, size, flags);
             }
             created = true;
         }
@@ -41,14 +51,13 @@ public:
     void updateData(void* data, size_t range = 0)
     {
         checkBuffers();
+        g_renderStats.addUpload(range == 0 ? size : range);
         glNamedBufferSubData(getBuffer(), 0, range == 0 ? size : range, data);
     }
 
-    void* map(size_t dataSize);
+    void* map(size_t dataSize, size_t* mappedOffset = nullptr);
 
-    void unmap()
-    {
-        glUnmapNamedBuffer(getBuffer());
-    }
+    // nothing to do, the memory returned by map() is coherent
+    void unmap() {}
 };
 
@@ -184,6 +184,20 @@ public:
 
         ImGui::Gap();
         ImGui::Text("Mouse Position: %.3f, %.3f, %.3f", mousePosition.x, mousePosition.y, mousePosition.z);
+        ImGui::Text("Last Mesh Update: %u vertices, %.3fms", scene->terrain->lastMeshUpdateVertexCount,
+                scene->terrain->lastMeshUpdateTime * 1000.0);
+        ImGui::Text("Last Collision Update: %u samples, %.3fms",
+                scene->terrain->lastCollisionUpdateSampleCount,
+                scene->terrain->lastCollisionUpdateTime * 1000.0);
+
+        ImGui::Gap();
+        Terrain* t = scene->terrain;
+        ImGui::Checkbox("Terrain LOD", &t->isLodEnabled);
+        ImGui::SliderFloat("LOD Screen Error", &t->maxLodScreenError, 0.25f, 16.f, "%.2f px");
+        ImGui::Text("Terrain Chunks: %u full detail, %u / %u / %u coarser", t->lastLodChunkCount[0],
+                t->lastLodChunkCount[1], t->lastLodChunkCount[2], t->lastLodChunkCount[3]);
+        ImGui::Text("Terrain Triangles: %u of %u", t->lastTriangleCount,
+                t->lastFullDetailTriangleCount);
     }
 
     void onBeginTest(Scene* scene) override
@@ -41,6 +41,7 @@ void Oil::updateTransform(Scene* scene)
         actor->getShapes(&shape, 1);
         shape->setGeometry(PxBoxGeometry(convert(
                         absolute(max(Vec3(0.01f), scale) * 0.5f))));
+        scene->getGroundSpotGrid().set(this, GroundSpot::OIL, position, scale);
     }
     decal.setTexture(g_res.getTexture("icon_oil"), g_res.getTexture("oil_normal"));
     decal.setPriority(TransparentDepth::OIL_GLUE);
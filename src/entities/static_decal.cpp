@@ -44,10 +44,12 @@ void StaticDecal::updateTransform(Scene* scene)
         {
             shape->setQueryFilterData(PxFilterData(
                         COLLISION_FLAG_SELECTABLE | COLLISION_FLAG_DUST, 0, 0, 0));
+            scene->getGroundSpotGrid().set(this, GroundSpot::DUST, position, scale);
         }
         else
         {
             shape->setQueryFilterData(PxFilterData(COLLISION_FLAG_SELECTABLE, 0, 0, 0));
+            scene->getGroundSpotGrid().remove(this);
         }
     }
 
@@ -114,7 +114,7 @@ Vec2 Font::stringDimensions(const char* str, bool onlyFirstLine) const
     return { max(currentWidth, maxWidth), currentHeight };
 }
 
-void Font::draw(const char* text, Vec2 pos, Vec3 color, f32 alpha, f32 scale,
+void Font::draw(i32 priority, const char* text, Vec2 pos, Vec3 color, f32 alpha, f32 scale,
         HAlign halign, VAlign valign, Mat4 const& transform, Vec2 scissorPos, Vec2 scissorSize)
 {
     char* str = (char*)text;
@@ -148,8 +148,7 @@ void Font::draw(const char* text, Vec2 pos, Vec3 color, f32 alpha, f32 scale,
         }
     }
 
-    glBindTextureUnit(1, textureAtlas.handle);
-
+    Vec4 col(color, alpha);
     while (*str)
     {
         if (*str == '\n')
@@ -187,16 +186,16 @@ void Font::draw(const char* text, Vec2 pos, Vec3 color, f32 alpha, f32 scale,
         Vec2 t1 = { g.x0, g.y0 };
         Vec2 t2 = { g.x1, g.y1 };
         ui::Quad q;
+        q.tex = &textureAtlas;
         q.points[0] = { p1, t1 };
         q.points[1] = { { p2.x, p1.y }, { t2.x, t1.y } };
         q.points[2] = { { p1.x, p2.y }, { t1.x, t2.y } };
         q.points[3] = { p2, t2 };
+        q.color1 = col;
+        q.color2 = col;
         if (ui::transformQuad(q, transform, scissorPos, scissorSize))
         {
-            Vec4 col(color, alpha);
-            glUniform4fv(0, 4, (GLfloat*)&q.points);
-            glUniform4fv(4, 1, (GLfloat*)&col);
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            ui::addQuad(priority, q, Quad2DMode::TEXT);
         }
 
         p.x += g.advance * scale;
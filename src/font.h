@@ -43,7 +43,9 @@ public:
     f32 getHeight() const { return height; }
     f32 getLineHeight() const { return lineHeight; }
 
-    void draw(const char* text, Vec2 pos, Vec3 color, f32 alpha=1.f, f32 scale=1.f,
-            HAlign halign=HAlign::LEFT, VAlign valign=VAlign::TOP, Mat4 const& t=Mat4(1.f),
-            Vec2 scissorPos={0,0}, Vec2 scissorSize={INFINITY, INFINITY});
+    // adds a quad for each glyph to the 2D batcher
+    void draw(i32 priority, const char* text, Vec2 pos, Vec3 color, f32 alpha=1.f,
+            f32 scale=1.f, HAlign halign=HAlign::LEFT, VAlign valign=VAlign::TOP,
+            Mat4 const& t=Mat4(1.f), Vec2 scissorPos={0,0},
+            Vec2 scissorSize={INFINITY, INFINITY});
 };
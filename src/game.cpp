@@ -7,6 +7,7 @@
 #include "resources.h"
 #include "audio.h"
 #include "weapon.h"
+#include "null_gl.h"
 #include "imgui.h"
 #include "gui.h"
 #include "widgets.h"
@@ -23,6 +24,7 @@ void Game::initPhysX()
     } errorCallback;
 
     physx.foundation = PxCreateFoundation(PX_PHYSICS_VERSION, physx.allocator, errorCallback);
+    physx.foundation->setReportAllocationNames(true);
     physx.pvd = PxCreatePvd(*physx.foundation);
     PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate("127.0.0.1", 5425, 10);
     physx.pvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
@@ -90,6 +92,11 @@ void Game::run()
 
     g_game.config.load();
 
+    if (isNullRendererEnabled)
+    {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+    }
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) != 0)
     {
         FATAL_ERROR("SDL_Init Error: %s", SDL_GetError())
@@ -105,8 +112,8 @@ void Game::run()
     //SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR);
 #endif
 
-    u32 flags = SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
-    if (config.graphics.fullscreen)
+    u32 flags = isNullRendererEnabled ? SDL_WINDOW_HIDDEN : SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
+    if (config.graphics.fullscreen && !isNullRendererEnabled)
     {
         flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
     }
@@ -117,13 +124,22 @@ void Game::run()
         FATAL_ERROR("Failed to create SDL window: %s", SDL_GetError())
     }
 
-    SDL_GLContext context = SDL_GL_CreateContext(window);
-    if (!context)
+    SDL_GLContext context = nullptr;
+    if (isNullRendererEnabled)
     {
-        FATAL_ERROR("Failed to create OpenGL context: %s", SDL_GetError())
+        println("Using null renderer");
+        gladLoadGLLoader(NullGL::getProcAddress);
     }
-
-    gladLoadGLLoader(SDL_GL_GetProcAddress);
+    else
+    {
+        context = SDL_GL_CreateContext(window);
+        if (!context)
+        {
+            FATAL_ERROR("Failed to create OpenGL context: %s", SDL_GetError())
+        }
+        gladLoadGLLoader(SDL_GL_GetProcAddress);
+    }
+    g_renderStats.installHooks();
 
 #ifndef NDEBUG
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
@@ -131,7 +147,10 @@ void Game::run()
     glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 #endif
 
-    SDL_GL_SetSwapInterval(g_game.config.graphics.vsync ? 1 : 0);
+    if (context)
+    {
+        SDL_GL_SetSwapInterval(g_game.config.graphics.vsync ? 1 : 0);
+    }
 
     i32 w, h;
     SDL_GL_GetDrawableSize(window, &w, &h);
@@ -162,6 +181,11 @@ void Game::run()
     deltaTime = 1.f / (f32)config.graphics.maxFPS;
     SDL_Event event;
 
+    if (frameLimit > 0)
+    {
+        g_renderStats.record(frameLimit);
+    }
+
     g_tmpMem.clear();
     while (true)
     {
@@ -183,6 +207,11 @@ void Game::run()
             SDL_SetWindowFullscreen(window, config.graphics.fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
         }
 
+        if (frameLimit > 0 && frameCount > frameLimit)
+        {
+            // one extra frame so that the stats of the last one are written
+            shouldExit = true;
+        }
         if (shouldExit)
         {
             break;
@@ -217,7 +246,12 @@ void Game::run()
             //menu.showRaceResults();
         }
 
-        ImGui_ImplOpenGL3_NewFrame();
+        renderer->beginFrame();
+
+        if (context)
+        {
+            ImGui_ImplOpenGL3_NewFrame();
+        }
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
         gui::onBeginUpdate(deltaTime);
@@ -244,7 +278,10 @@ void Game::run()
         frameIndex = (frameIndex + 1) % MAX_BUFFERED_FRAMES;
         ++frameCount;
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (context)
+        {
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         cpuTime = getTime() - frameStartTime;
         if (!isTimedBlockTrackingPaused)
@@ -254,9 +291,12 @@ void Game::run()
         }
         timedBlocks.clear();
 
-        SDL_GL_SwapWindow(g_game.window);
+        if (context)
+        {
+            SDL_GL_SwapWindow(g_game.window);
+        }
 
-        if (!config.graphics.vsync)
+        if (!config.graphics.vsync && !isNullRendererEnabled)
         {
             f64 minFrameTime = 1.0 / (f64)config.graphics.maxFPS;
             auto frameEndTime = frameStartTime + minFrameTime;
@@ -302,11 +342,17 @@ void Game::run()
     g_threadPool.signalCompletion();
     g_threadPool.join();
 
-    ImGui_ImplOpenGL3_Shutdown();
+    if (context)
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+    }
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
 
-    SDL_GL_DeleteContext(context);
+    if (context)
+    {
+        SDL_GL_DeleteContext(context);
+    }
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
@@ -439,10 +485,20 @@ void Game::checkDebugKeys()
         ImGui::PlotLines("Frame Times", g_game.deltaTimeHistory, ARRAY_SIZE(g_game.deltaTimeHistory),
                 0, nullptr, 0.f, 0.04f, { 0, 80 });
         ImGui::Text("Frame Temp-Memory Usage: %.3fkb", g_tmpMem.pos / 1024.f);
+        g_game.physx.allocator.showDebugInfo();
         ImGui::Text("Resolution: %ix%i", g_game.config.graphics.resolutionX, g_game.config.graphics.resolutionY);
         ImGui::Text("Time Dilation: %f", g_game.timeDilation);
-        // TODO: count draw calls
-        //ImGui::Text("Renderables: %i", renderer->getRenderablesCount());
+        g_game.renderer->getRenderWorld()->showDebugInfo();
+        g_renderStats.showDebugInfo();
+        g_game.renderer->getDrawDataBuffer().showDebugInfo();
+        g_game.renderer->showDebugInfo();
+        g_game.renderer->getBatcher2D().showDebugInfo();
+        g_game.renderer->getVinylBaker().showDebugInfo();
+        g_game.menu.vehiclePreviews.showDebugInfo();
+        if (isNullRendererEnabled)
+        {
+            g_nullGL.showDebugInfo();
+        }
 
         ImGui::Gap();
 
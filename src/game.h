@@ -6,6 +6,7 @@
 #include "config.h"
 #include "buffer.h"
 #include "threadpool.h"
+#include "physx_allocator.h"
 #include "editor/resource_manager.h"
 
 namespace GameMode
@@ -44,7 +45,7 @@ public:
 
     struct
     {
-        PxDefaultAllocator allocator;
+        TrackingAllocator allocator;
         PxFoundation* foundation;
         PxPhysics* physics;
         PxDefaultCpuDispatcher* dispatcher;
@@ -74,6 +75,11 @@ public:
     bool shouldExit = false;
     bool isEditing = false;
 
+    // --null-renderer: run without a window or GL context (see NullGL)
+    bool isNullRendererEnabled = false;
+    // --frames: exit after this many frames and write their render stats to a CSV file
+    u32 frameLimit = 0;
+
     f32 recentHighestDeltaTime = FLT_MIN;
     f32 allTimeHighestDeltaTime = FLT_MIN;
     f32 allTimeLowestDeltaTime = FLT_MAX;
@@ -0,0 +1,101 @@
+#include "ground_spot_grid.h"
+
+void GroundSpotGrid::insertSpot(u32 spotIndex)
+{
+    GroundSpot const& s = spots[spotIndex].spot;
+    i32 minX = cellCoord(s.p.x - s.radius);
+    i32 maxX = cellCoord(s.p.x + s.radius);
+    i32 minY = cellCoord(s.p.y - s.radius);
+    i32 maxY = cellCoord(s.p.y + s.radius);
+    for (i32 y=minY; y<=maxY; ++y)
+    {
+        for (i32 x=minX; x<=maxX; ++x)
+        {
+            buckets[bucketIndex(x, y)].push(spotIndex);
+        }
+    }
+}
+
+void GroundSpotGrid::removeSpot(u32 spotIndex)
+{
+    GroundSpot const& s = spots[spotIndex].spot;
+    i32 minX = cellCoord(s.p.x - s.radius);
+    i32 maxX = cellCoord(s.p.x + s.radius);
+    i32 minY = cellCoord(s.p.y - s.radius);
+    i32 maxY = cellCoord(s.p.y + s.radius);
+    for (i32 y=minY; y<=maxY; ++y)
+    {
+        for (i32 x=minX; x<=maxX; ++x)
+        {
+            // cells that hash to the same bucket add the spot more than once, so only remove one
+            Array<u32>& bucket = buckets[bucketIndex(x, y)];
+            for (u32 i=0; i<bucket.size(); ++i)
+            {
+                if (bucket[i] == spotIndex)
+                {
+                    bucket[i] = bucket.back();
+                    bucket.pop();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void GroundSpotGrid::set(Entity* entity, u32 groundType, Vec3 const& position, Vec3 const& scale)
+{
+    u32* existingSpot = entitySpots.get(entity);
+    u32 spotIndex;
+    if (existingSpot)
+    {
+        spotIndex = *existingSpot;
+        removeSpot(spotIndex);
+    }
+    else if (freeSpots.size() > 0)
+    {
+        spotIndex = freeSpots.back();
+        freeSpots.pop();
+        entitySpots.set(entity, spotIndex);
+    }
+    else
+    {
+        spotIndex = spots.size();
+        spots.push({});
+        entitySpots.set(entity, spotIndex);
+    }
+
+    Spot& s = spots[spotIndex];
+    s.spot.groundType = groundType;
+    s.spot.p = position;
+    s.spot.radius = max(absolute(scale.x), max(absolute(scale.y), absolute(scale.z))) * 0.48f;
+    // the same height as the box the spots used to have for physics overlap queries
+    s.halfHeight = absolute(scale.z) * 0.5f;
+    s.entity = entity;
+    s.queryIndex = queryIndex;
+    insertSpot(spotIndex);
+}
+
+void GroundSpotGrid::remove(Entity* entity)
+{
+    u32* existingSpot = entitySpots.get(entity);
+    if (!existingSpot)
+    {
+        return;
+    }
+    u32 spotIndex = *existingSpot;
+    removeSpot(spotIndex);
+    spots[spotIndex].entity = nullptr;
+    freeSpots.push(spotIndex);
+    entitySpots.erase(entity);
+}
+
+void GroundSpotGrid::clear()
+{
+    spots.clear();
+    freeSpots.clear();
+    entitySpots.clear();
+    for (auto& bucket : buckets)
+    {
+        bucket.clear();
+    }
+}
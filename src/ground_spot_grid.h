@@ -0,0 +1,92 @@
+#pragma once
+
+#include "math.h"
+#include "map.h"
+
+class Entity;
+
+struct GroundSpot
+{
+    enum GroundType
+    {
+        DUST,
+        OIL,
+        GLUE,
+    };
+    u32 groundType;
+    Vec3 p;
+    f32 radius;
+};
+
+// 2D spatial hash of the ground spots (oil, glue, dust) in a scene so that vehicles can find the
+// spots under their wheels without doing a physics query. Spots are inserted into every cell their
+// radius overlaps and cells are hashed into a fixed number of buckets. Queries also check the
+// height of the spots, so that a spot under a bridge doesn't affect the vehicles on it.
+class GroundSpotGrid
+{
+public:
+    static constexpr f32 CELL_SIZE = 8.f;
+    static constexpr u32 BUCKET_COUNT = 1024;
+
+private:
+    struct Spot
+    {
+        GroundSpot spot;
+        f32 halfHeight;
+        Entity* entity;
+        u32 queryIndex;
+    };
+
+    Array<Spot> spots;
+    Array<u32> freeSpots;
+    Map<Entity*, u32, 256> entitySpots;
+    Array<u32> buckets[BUCKET_COUNT];
+    u32 queryIndex = 0;
+
+    static i32 cellCoord(f32 v) { return (i32)floorf(v / CELL_SIZE); }
+    static u32 bucketIndex(i32 x, i32 y)
+    {
+        return ((u32)x * 73856093u ^ (u32)y * 19349663u) % BUCKET_COUNT;
+    }
+    void insertSpot(u32 spotIndex);
+    void removeSpot(u32 spotIndex);
+
+public:
+    // adds the entity to the grid or moves it if it was already added
+    void set(Entity* entity, u32 groundType, Vec3 const& position, Vec3 const& scale);
+    void remove(Entity* entity);
+    void clear();
+    u32 getSpotCount() const { return entitySpots.size(); }
+
+    // calls the callback once for each spot whose radius overlaps the sphere
+    template <typename F>
+    void query(Vec3 const& p, f32 radius, F const& callback)
+    {
+        ++queryIndex;
+        i32 minX = cellCoord(p.x - radius);
+        i32 maxX = cellCoord(p.x + radius);
+        i32 minY = cellCoord(p.y - radius);
+        i32 maxY = cellCoord(p.y + radius);
+        for (i32 y=minY; y<=maxY; ++y)
+        {
+            for (i32 x=minX; x<=maxX; ++x)
+            {
+                for (u32 spotIndex : buckets[bucketIndex(x, y)])
+                {
+                    Spot& s = spots[spotIndex];
+                    if (s.queryIndex == queryIndex)
+                    {
+                        continue;
+                    }
+                    s.queryIndex = queryIndex;
+                    if (lengthSquared(Vec2(s.spot.p.x - p.x, s.spot.p.y - p.y))
+                            < square(s.spot.radius + radius)
+                            && absolute(s.spot.p.z - p.z) < s.halfHeight + radius)
+                    {
+                        callback(s.spot, s.entity);
+                    }
+                }
+            }
+        }
+    }
+};
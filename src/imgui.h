@@ -26,8 +26,16 @@ namespace ImGui
         //io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
         ImGui::StyleColorsDark();
         ImGui_ImplSDL2_InitForOpenGL(window, context);
-        ImGui_ImplOpenGL3_Init("#version 130");
+        if (context)
+        {
+            ImGui_ImplOpenGL3_Init("#version 130");
+        }
         io.Fonts->AddFontFromFileTTF("font.ttf", 16.f);
+        if (!context)
+        {
+            // the OpenGL backend normally builds the font atlas when it creates the font texture
+            io.Fonts->Build();
+        }
         ImGuiStyle& style = ImGui::GetStyle();
         style.WindowBorderSize = 1.f;
         style.FrameBorderSize = 0.f;
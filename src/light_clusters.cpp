@@ -0,0 +1,250 @@
+#include "light_clusters.h"
+#include "renderer.h"
+#include "threadpool.h"
+#include "imgui.h"
+
+static u8 getTile(f32 ndc, u32 tiles)
+{
+    return (u8)clamp((i32)((ndc * 0.5f + 0.5f) * tiles), 0, (i32)tiles - 1);
+}
+
+void LightClusters::build(Camera const& camera, PointLight const* lights, u32 count,
+        bool multithreaded)
+{
+    lightCount = min(count, MAX_POINT_LIGHTS);
+    droppedCount = count - lightCount;
+    overflowCount = 0;
+    viewLights.clear();
+    lightIndices.clear();
+    clusters.resize(CLUSTER_COUNT);
+
+    f32 nearPlane = camera.nearPlane;
+    f32 farPlane = camera.farPlane;
+    if (lightCount == 0 || nearPlane <= 0.f || farPlane <= nearPlane)
+    {
+        memset(clusters.data(), 0, clusters.size() * sizeof(LightCluster));
+        depthScale = 0.f;
+        depthBias = 0.f;
+        return;
+    }
+
+    // slice = log(depth) * depthScale + depthBias
+    f32 logRatio = logf(farPlane / nearPlane);
+    depthScale = CLUSTER_Z / logRatio;
+    depthBias = -(f32)CLUSTER_Z * logf(nearPlane) / logRatio;
+
+    f32 px = camera.projection[0][0];
+    f32 py = camera.projection[1][1];
+    for (u32 i=0; i<lightCount; ++i)
+    {
+        PointLight const& light = lights[i];
+        Vec3 center = Vec3(camera.view * Vec4(light.position, 1.f));
+        f32 radius = light.radius;
+        f32 depth = -center.z;
+        if (depth + radius <= nearPlane || depth - radius >= farPlane)
+        {
+            continue;
+        }
+
+        // conservative screen bounds of the light's view space box, lights that touch the near
+        // plane cover the whole screen
+        f32 minX = -1.f, maxX = 1.f, minY = -1.f, maxY = 1.f;
+        if (depth - radius > nearPlane)
+        {
+            f32 d0 = 1.f / (depth - radius);
+            f32 d1 = 1.f / (depth + radius);
+            f32 x0 = center.x - radius, x1 = center.x + radius;
+            f32 y0 = center.y - radius, y1 = center.y + radius;
+            minX = px * min(x0 * d0, x0 * d1);
+            maxX = px * max(x1 * d0, x1 * d1);
+            minY = py * min(y0 * d0, y0 * d1);
+            maxY = py * max(y1 * d0, y1 * d1);
+            if (maxX < -1.f || minX > 1.f || maxY < -1.f || minY > 1.f)
+            {
+                continue;
+            }
+        }
+
+        f32 minZ = logf(max(depth - radius, nearPlane)) * depthScale + depthBias;
+        f32 maxZ = logf(min(depth + radius, farPlane)) * depthScale + depthBias;
+
+        ViewLight l;
+        l.center = center;
+        l.radius = radius;
+        l.index = i;
+        l.minX = getTile(minX, CLUSTER_X);
+        l.maxX = getTile(maxX, CLUSTER_X);
+        l.minY = getTile(minY, CLUSTER_Y);
+        l.maxY = getTile(maxY, CLUSTER_Y);
+        l.minZ = (u8)clamp((i32)minZ, 0, (i32)CLUSTER_Z - 1);
+        l.maxZ = (u8)clamp((i32)maxZ, 0, (i32)CLUSTER_Z - 1);
+        viewLights.push(l);
+    }
+
+    auto buildSlices = [&](u32 begin, u32 end) {
+        for (u32 z=begin; z<end; ++z)
+        {
+            buildSlice(z, px, py);
+        }
+    };
+    if (multithreaded)
+    {
+        g_threadPool.parallelFor(CLUSTER_Z, 1, buildSlices);
+    }
+    else
+    {
+        buildSlices(0, CLUSTER_Z);
+    }
+
+    for (u32 z=0; z<CLUSTER_Z; ++z)
+    {
+        u32 base = lightIndices.size();
+        Array<u32> const& indices = sliceIndices[z];
+        u32 copyCount = min(indices.size(), MAX_LIGHT_INDICES - base);
+        overflowCount += indices.size() - copyCount;
+
+        LightCluster* sliceClusters = clusters.data() + z * CLUSTER_X * CLUSTER_Y;
+        for (u32 i=0; i<CLUSTER_X * CLUSTER_Y; ++i)
+        {
+            LightCluster& c = sliceClusters[i];
+            c.offset = min(c.offset, copyCount);
+            c.count = min(c.count, copyCount - c.offset);
+            c.offset += base;
+        }
+
+        lightIndices.resize(base + copyCount);
+        memcpy(lightIndices.data() + base, indices.data(), copyCount * sizeof(u32));
+    }
+}
+
+void LightClusters::buildSlice(u32 z, f32 px, f32 py)
+{
+    Array<u32>& indices = sliceIndices[z];
+    indices.clear();
+
+    u16 sliceLights[MAX_POINT_LIGHTS];
+    u32 sliceLightCount = 0;
+    for (u32 i=0; i<viewLights.size(); ++i)
+    {
+        if (viewLights[i].minZ <= z && viewLights[i].maxZ >= z)
+        {
+            sliceLights[sliceLightCount++] = (u16)i;
+        }
+    }
+
+    f32 sliceNear = expf(((f32)z - depthBias) / depthScale);
+    f32 sliceFar = expf(((f32)z + 1.f - depthBias) / depthScale);
+    LightCluster* sliceClusters = clusters.data() + z * CLUSTER_X * CLUSTER_Y;
+    for (u32 y=0; y<CLUSTER_Y; ++y)
+    {
+        f32 y0 = ((f32)y / CLUSTER_Y * 2.f - 1.f) / py;
+        f32 y1 = ((f32)(y + 1) / CLUSTER_Y * 2.f - 1.f) / py;
+        f32 minY = min(y0 * sliceNear, y0 * sliceFar);
+        f32 maxY = max(y1 * sliceNear, y1 * sliceFar);
+        for (u32 x=0; x<CLUSTER_X; ++x)
+        {
+            f32 x0 = ((f32)x / CLUSTER_X * 2.f - 1.f) / px;
+            f32 x1 = ((f32)(x + 1) / CLUSTER_X * 2.f - 1.f) / px;
+            Vec3 boxMin(min(x0 * sliceNear, x0 * sliceFar), minY, -sliceFar);
+            Vec3 boxMax(max(x1 * sliceNear, x1 * sliceFar), maxY, -sliceNear);
+
+            LightCluster& c = sliceClusters[y * CLUSTER_X + x];
+            c.offset = indices.size();
+            for (u32 i=0; i<sliceLightCount; ++i)
+            {
+                ViewLight const& l = viewLights[sliceLights[i]];
+                if (x < l.minX || x > l.maxX || y < l.minY || y > l.maxY)
+                {
+                    continue;
+                }
+                Vec3 closest = min(max(l.center, boxMin), boxMax);
+                if (lengthSquared(closest - l.center) <= l.radius * l.radius)
+                {
+                    indices.push(l.index);
+                }
+            }
+            c.count = indices.size() - c.offset;
+        }
+    }
+}
+
+void LightClusters::upload(PointLight const* lights)
+{
+    if (lightCount > 0)
+    {
+        lightBuffer.updateData((void*)lights, lightCount * sizeof(PointLight));
+    }
+    clusterBuffer.updateData(clusters.data());
+    if (lightIndices.size() > 0)
+    {
+        indexBuffer.updateData(lightIndices.data(), lightIndices.size() * sizeof(u32));
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lightBuffer.getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, clusterBuffer.getBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, indexBuffer.getBuffer());
+}
+
+void LightClusters::destroy()
+{
+    lightBuffer.destroy();
+    clusterBuffer.destroy();
+    indexBuffer.destroy();
+}
+
+void LightClusters::showDebugInfo()
+{
+    ImGui::Text("Light Clusters: %u lights (%u dropped), %u light indices (%u dropped)",
+            lightCount, droppedCount, lightIndices.size(), overflowCount);
+}
+
+void LightClusters::showBenchmark()
+{
+    static f64 serialTime = 0.0;
+    static f64 parallelTime = 0.0;
+    static u32 indexCount = 0;
+    const u32 LIGHT_COUNT = 500;
+    const u32 ITERATIONS = 20;
+
+    if (ImGui::Button("Light Cluster Benchmark"))
+    {
+        Camera camera;
+        camera.position = Vec3(0, 0, 5);
+        camera.nearPlane = 0.5f;
+        camera.farPlane = 500.f;
+        camera.fov = 80.f;
+        camera.aspectRatio = 16.f / 9.f;
+        camera.view = Mat4::lookAt(camera.position, Vec3(100, 0, 0), Vec3(0, 0, 1));
+        camera.projection = Mat4::perspective(radians(camera.fov), camera.aspectRatio,
+                camera.nearPlane, camera.farPlane);
+        camera.viewProjection = camera.projection * camera.view;
+
+        RandomSeries series{ 1234 };
+        Array<PointLight> lights(LIGHT_COUNT);
+        for (auto& light : lights)
+        {
+            light.position = Vec3(random(series, 0.f, 200.f), random(series, -60.f, 60.f),
+                    random(series, 0.f, 10.f));
+            light.radius = random(series, 2.f, 20.f);
+            light.color = Vec3(1.f);
+            light.falloff = 2.f;
+        }
+
+        LightClusters clusters;
+        f64 t = getTime();
+        for (u32 i=0; i<ITERATIONS; ++i)
+        {
+            clusters.build(camera, lights.data(), lights.size(), false);
+        }
+        serialTime = (getTime() - t) / ITERATIONS;
+
+        t = getTime();
+        for (u32 i=0; i<ITERATIONS; ++i)
+        {
+            clusters.build(camera, lights.data(), lights.size(), true);
+        }
+        parallelTime = (getTime() - t) / ITERATIONS;
+        indexCount = clusters.getIndexCount();
+    }
+    ImGui::Text("%u lights: %.3fms single threaded, %.3fms multithreaded, %u light indices",
+            LIGHT_COUNT, serialTime * 1000.0, parallelTime * 1000.0, indexCount);
+}
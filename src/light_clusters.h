@@ -0,0 +1,72 @@
+#pragma once
+
+#include "misc.h"
+#include "math.h"
+#include "dynamic_buffer.h"
+
+const u32 MAX_POINT_LIGHTS = 1024;
+const u32 CLUSTER_X = 16;
+const u32 CLUSTER_Y = 9;
+const u32 CLUSTER_Z = 24;
+const u32 CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const u32 MAX_LIGHT_INDICES = 65536;
+
+struct PointLight
+{
+    Vec3 position;
+    f32 radius;
+    Vec3 color;
+    f32 falloff;
+};
+
+struct LightCluster
+{
+    u32 offset;
+    u32 count;
+};
+
+// Assigns point lights to the froxels of a camera: CLUSTER_X by CLUSTER_Y screen tiles, each
+// split into CLUSTER_Z exponentially spaced view depth slices. Each slice is built on its own
+// worker thread and the slices are then concatenated in order, so the result doesn't depend on
+// the number of threads. The lights, clusters and light indices are read by lighting.glsl from
+// storage buffers.
+class LightClusters
+{
+    struct ViewLight
+    {
+        Vec3 center;
+        f32 radius;
+        u32 index;
+        u8 minX, maxX, minY, maxY, minZ, maxZ;
+    };
+
+    Array<ViewLight> viewLights;
+    Array<u32> sliceIndices[CLUSTER_Z];
+    Array<LightCluster> clusters;
+    Array<u32> lightIndices;
+    u32 lightCount = 0;
+    u32 droppedCount = 0;
+    u32 overflowCount = 0;
+    f32 depthScale = 0.f;
+    f32 depthBias = 0.f;
+
+    DynamicBuffer lightBuffer = DynamicBuffer(sizeof(PointLight) * MAX_POINT_LIGHTS);
+    DynamicBuffer clusterBuffer = DynamicBuffer(sizeof(LightCluster) * CLUSTER_COUNT);
+    DynamicBuffer indexBuffer = DynamicBuffer(sizeof(u32) * MAX_LIGHT_INDICES);
+
+    void buildSlice(u32 z, f32 px, f32 py);
+
+public:
+    void build(struct Camera const& camera, PointLight const* lights, u32 count,
+            bool multithreaded=true);
+    // uploads the lights and light lists and binds them to the storage buffer bindings 2, 3 and 4
+    void upload(PointLight const* lights);
+    void destroy();
+
+    f32 getDepthScale() const { return depthScale; }
+    f32 getDepthBias() const { return depthBias; }
+    u32 getIndexCount() const { return lightIndices.size(); }
+
+    void showDebugInfo();
+    static void showBenchmark();
+};
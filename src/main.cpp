@@ -2,10 +2,19 @@
 
 #include "math.cpp"
 #include "game.cpp"
+#include "physx_allocator.cpp"
 #include "threadpool.cpp"
 #include "scene.cpp"
+#include "query_batch.cpp"
 #include "renderer.cpp"
+#include "render_queue.cpp"
+#include "render_stats.cpp"
+#include "null_gl.cpp"
+#include "draw_data_buffer.cpp"
+#include "light_clusters.cpp"
 #include "batcher.cpp"
+#include "batcher_2d.cpp"
+#include "vinyl_baker.cpp"
 #include "datafile.cpp"
 #include "resources.cpp"
 #include "material.cpp"
@@ -13,10 +22,13 @@
 #include "vehicle.cpp"
 #include "vehicle_data.cpp"
 #include "vehicle_physics.cpp"
+#include "ground_spot_grid.cpp"
+#include "debris_pool.cpp"
 #include "font.cpp"
 #include "track_graph.cpp"
 //#include "motion_grid.cpp"
 #include "particle_system.cpp"
+#include "projectile_system.cpp"
 #include "audio.cpp"
 #include "driver.cpp"
 #include "mesh.cpp"
@@ -26,10 +38,10 @@
 #include "spline.cpp"
 #include "dynamic_buffer.cpp"
 #include "decal.cpp"
+#include "vehicle_preview.cpp"
 #include "menu.cpp"
 #include "gui.cpp"
 #include "weapon.cpp"
-#include "entities/projectile.cpp"
 #include "entities/mine.cpp"
 #include "entities/flash.cpp"
 #include "entities/static_mesh.cpp"
@@ -61,6 +73,26 @@
 
 int main(int argc, char** argv)
 {
+    for (i32 i=1; i<argc; ++i)
+    {
+        if (strcmp(argv[i], "--null-renderer") == 0)
+        {
+            g_game.isNullRendererEnabled = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            g_game.frameLimit = (u32)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--particle-benchmark") == 0)
+        {
+            // print the timings of the particle benchmark and exit, without creating a window
+            ParticleSystem::BenchmarkResult r = ParticleSystem::runBenchmark();
+            println("%u particles: update %.3fms, build instances %.3fms (erase update %.3fms)",
+                    r.particleCount, r.updateTime * 1000.0, r.buildTime * 1000.0,
+                    r.eraseUpdateTime * 1000.0);
+            return EXIT_SUCCESS;
+        }
+    }
     g_game.run();
     return EXIT_SUCCESS;
 }
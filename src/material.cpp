@@ -50,151 +50,158 @@ struct MaterialRenderData
 #endif
     GLuint vao;
     u32 indexCount;
-    Mat4 worldTransform;
-    Mat3 normalTransform;
     GLuint textureColor;
     GLuint textureNormal;
-    Vec3 color;
-    Vec3 emission;
-    f32 fresnelBias, fresnelScale, fresnelPower;
-    f32 specularPower, specularStrength;
-    f32 reflectionStrength, reflectionLod, reflectionBias;
-    f32 alphaCutoff, shadowAlphaCutoff;
-    f32 windAmount;
-    u32 pickValue;
+    f32 alphaCutoff;
+    u32 drawIndex;
 };
 
-void Material::draw(RenderWorld* rw, Mat4 const& transform, Mesh* mesh, u8 stencil)
+static bool pushDrawData(DrawData const& data, u32& drawIndex)
 {
+    return g_game.renderer->getDrawDataBuffer().push(data, drawIndex);
+}
+
+void Material::draw(RenderWorld* rw, Mat4 const& transform, Mesh* mesh, u8 stencil,
+        bool isStaticShadowCaster)
+{
+    DrawData data;
+    data.worldTransform = transform;
+    data.setNormalTransform(inverseTranspose(Mat3(transform)));
+    data.color = Vec4(color, alphaCutoff);
+    data.emission = Vec4(emit * emitPower, windAmount);
+    data.fresnel = Vec4(fresnelBias, fresnelScale, fresnelPower, 0.f);
+    data.specular = Vec4(specularPower, specularStrength, 0.f, 0.f);
+    data.reflection = Vec4(reflectionStrength, reflectionLod, reflectionBias, 0.f);
+    data.pickValue = 0;
+
     MaterialRenderData* d = g_tmpMem.bump<MaterialRenderData>();
+    if (!pushDrawData(data, d->drawIndex))
+    {
+        return;
+    }
 #ifndef NDEBUG
     d->material = this;
 #endif
     d->vao = mesh->vao;
     d->indexCount = mesh->numIndices;
-    d->worldTransform = transform;
-    d->normalTransform = inverseTranspose(Mat3(transform));
     d->textureColor = textureColorHandle;
     d->textureNormal = textureNormalHandle;
-    d->color = color;
-    d->emission = emit * emitPower;
-    d->fresnelBias = fresnelBias;
-    d->fresnelPower = fresnelPower;
-    d->fresnelScale = fresnelScale;
-    d->specularPower = specularPower;
-    d->specularStrength = specularStrength;
-    d->reflectionStrength = reflectionStrength;
-    d->reflectionLod = reflectionLod;
-    d->reflectionBias = reflectionBias;
     d->alphaCutoff = alphaCutoff;
-    d->shadowAlphaCutoff = shadowAlphaCutoff;
-    d->windAmount = windAmount;
+    BoundingSphere bounds = computeBoundingSphere(mesh->aabb, transform);
 
     auto renderColor = [](void* renderData) {
         MaterialRenderData* d = (MaterialRenderData*)renderData;
-        glBindTextureUnit(0, d->textureColor);
+        bindTextureUnitCached(0, d->textureColor);
         if (d->textureNormal)
         {
             // TODO: Perhaps it would be better to just bind the identityNormal texture instead
-            glBindTextureUnit(5, d->textureNormal);
+            bindTextureUnitCached(5, d->textureNormal);
         }
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniformMatrix3fv(1, 1, GL_FALSE, d->normalTransform.valuePtr());
-        glUniform3fv(2, 1, (GLfloat*)&d->color);
-        glUniform3f(3, d->fresnelBias, d->fresnelScale, d->fresnelPower);
-        glUniform3f(4, d->specularPower, d->specularStrength, 0.f);
-        if (d->alphaCutoff > 0.f) { glUniform1f(5, d->alphaCutoff); }
-        glUniform3fv(6, 1, (GLfloat*)&d->emission);
-        glUniform3f(7, d->reflectionStrength, d->reflectionLod, d->reflectionBias);
-        glUniform1f(8, d->windAmount);
-        glBindVertexArray(d->vao);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
 
     auto renderDepth = [](void* renderData) {
         MaterialRenderData* d = (MaterialRenderData*)renderData;
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
         if (d->alphaCutoff > 0.f)
         {
-            glBindTextureUnit(0, d->textureColor);
-            glUniform1f(5, d->alphaCutoff);
+            bindTextureUnitCached(0, d->textureColor);
         }
-        glUniform1f(8, d->windAmount);
-        glBindVertexArray(d->vao);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
 
     if (isTransparent || depthOffset > 0.f || !isDepthWriteEnabled || !isDepthReadEnabled)
     {
         i32 priority = depthOffset > 0.f ? TransparentDepth::FLAT_SPLINE : 0;
-        rw->transparentPass({ colorShaderHandle, priority, d, renderColor });
+        rw->transparentPass({ colorShaderHandle, priority, d, renderColor, bounds });
     }
     else
     {
-        rw->depthPrepass(depthShaderHandle, { d, renderDepth });
-        rw->opaqueColorPass(colorShaderHandle, { d, renderColor, stencil });
+        rw->depthPrepass(depthShaderHandle, { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) });
+        rw->opaqueColorPass(colorShaderHandle,
+                { d, renderColor, stencil, bounds, makeStateKey(d->textureColor, d->vao) });
     }
 
     if (castsShadow)
     {
-        rw->shadowPass(shadowShaderHandle, { d, renderDepth });
+        RenderItem shadowItem = { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) };
+        // wind moves the vertices in the shader every frame, so the shadow can't be cached
+        if (isStaticShadowCaster && windAmount <= 0.f)
+        {
+            rw->staticShadowPass(shadowShaderHandle, shadowItem);
+        }
+        else
+        {
+            rw->shadowPass(shadowShaderHandle, shadowItem);
+        }
     }
 }
 
 void Material::drawPick(RenderWorld* rw, Mat4 const& transform, Mesh* mesh, u32 pickValue)
 {
+    DrawData data = {};
+    data.worldTransform = transform;
+    data.setNormalTransform(inverseTranspose(Mat3(transform)));
+    data.color = Vec4(color, alphaCutoff);
+    data.emission = Vec4(Vec3(0.f), windAmount);
+    data.pickValue = pickValue;
+
     MaterialRenderData* d = g_tmpMem.bump<MaterialRenderData>();
+    if (!pushDrawData(data, d->drawIndex))
+    {
+        return;
+    }
 #ifndef NDEBUG
     d->material = this;
 #endif
     d->vao = mesh->vao;
     d->indexCount = mesh->numIndices;
-    d->worldTransform = transform;
     d->textureColor = textureColorHandle;
     d->alphaCutoff = alphaCutoff;
-    d->windAmount = windAmount;
-    d->pickValue = pickValue;
 
     auto render = [](void* renderData) {
         MaterialRenderData* d = (MaterialRenderData*)renderData;
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniformMatrix3fv(1, 1, GL_FALSE, d->normalTransform.valuePtr());
         if (d->alphaCutoff > 0.f)
         {
-            glBindTextureUnit(0, d->textureColor);
-            glUniform1f(5, d->alphaCutoff);
+            bindTextureUnitCached(0, d->textureColor);
         }
-        glUniform1f(8, d->windAmount);
-        glUniform1ui(9, d->pickValue);
-        glBindVertexArray(d->vao);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
-    rw->pickPass(pickShaderHandle, { d, render });
+    rw->pickPass(pickShaderHandle, { d, render, 0, {}, makeStateKey(0, d->vao) });
 }
 
 void Material::drawHighlight(RenderWorld* rw, Mat4 const& transform, Mesh* mesh, u8 stencil, u8 cameraIndex)
 {
+    DrawData data = {};
+    data.worldTransform = transform;
+    data.color = Vec4(color, alphaCutoff);
+    data.emission = Vec4(Vec3(0.f), windAmount);
+
     MaterialRenderData* d = g_tmpMem.bump<MaterialRenderData>();
+    if (!pushDrawData(data, d->drawIndex))
+    {
+        return;
+    }
 #ifndef NDEBUG
     d->material = this;
 #endif
-    d->textureColor = textureColorHandle;
     d->vao = mesh->vao;
     d->indexCount = mesh->numIndices;
-    d->worldTransform = transform;
     d->textureColor = textureColorHandle;
     d->alphaCutoff = alphaCutoff;
-    d->windAmount = windAmount;
 
     auto render = [](void* renderData) {
         MaterialRenderData* d = (MaterialRenderData*)renderData;
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
         if (d->alphaCutoff > 0.f)
         {
             glBindTextureUnit(0, d->textureColor);
-            glUniform1f(5, d->alphaCutoff);
         }
-        glUniform1f(8, d->windAmount);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
         glBindVertexArray(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
@@ -209,40 +216,72 @@ struct VehicleRenderData
 #endif
     GLuint vao;
     u32 indexCount;
-    Mat4 worldTransform;
-    Mat3 normalTransform;
-    Vec3 color;
-    Vec3 emission;
-    f32 fresnelBias, fresnelScale, fresnelPower;
-    f32 specularPower, specularStrength;
-    f32 reflectionStrength, reflectionLod, reflectionBias;
+    u32 drawIndex;
     Vec4 shield;
     GLuint vinylTexture[3];
     Vec4 vinylColor[3];
 };
 
 void Material::drawVehicle(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh,
-        u8 stencil, Vec4 const& shield, i64 vinylTextureGuids[3], Vec4 vinylColor[3])
+        u8 stencil, Vec4 const& shield, i64 vinylTextureGuids[3], Vec4 vinylColor[3],
+        GLuint bakedPaintTexture)
 {
+    DrawData data;
+    data.worldTransform = transform;
+    data.setNormalTransform(inverseTranspose(Mat3(transform)));
+    data.color = Vec4(color, 0.f);
+    data.emission = Vec4(emit * emitPower, 0.f);
+    data.fresnel = Vec4(fresnelBias, fresnelScale, fresnelPower, 0.f);
+    data.specular = Vec4(specularPower, specularStrength, 0.f, 0.f);
+    data.reflection = Vec4(reflectionStrength, reflectionLod, reflectionBias, 0.f);
+    data.pickValue = 0;
+
     VehicleRenderData* d = g_tmpMem.bump<VehicleRenderData>();
+    if (!pushDrawData(data, d->drawIndex))
+    {
+        return;
+    }
 #ifndef NDEBUG
     d->material = this;
 #endif
     d->vao = mesh->vao;
     d->indexCount = mesh->numIndices;
-    d->worldTransform = transform;
-    d->normalTransform = inverseTranspose(Mat3(transform));
-    d->color = color;
-    d->emission = emit * emitPower;
-    d->fresnelBias = fresnelBias;
-    d->fresnelPower = fresnelPower;
-    d->fresnelScale = fresnelScale;
-    d->specularPower = specularPower;
-    d->specularStrength = specularStrength;
-    d->reflectionStrength = reflectionStrength;
-    d->reflectionLod = reflectionLod;
-    d->reflectionBias = reflectionBias;
     d->shield = shield;
+
+    auto renderDepth = [](void* renderData) {
+        VehicleRenderData* d = (VehicleRenderData*)renderData;
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
+        glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
+    };
+
+    BoundingSphere bounds = computeBoundingSphere(mesh->aabb, transform);
+    rw->depthPrepass(depthShaderHandle, { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) });
+    rw->shadowPass(shadowShaderHandle, { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) });
+
+    if (bakedPaintTexture)
+    {
+        // the paint material uses the default depth state
+        static ShaderHandle bakedColorShaderHandle =
+            getShaderHandle("lit", { { "VEHICLE" }, { "VINYL_BAKED" } });
+
+        d->vinylTexture[0] = bakedPaintTexture;
+        auto renderOpaqueBaked = [](void* renderData) {
+            VehicleRenderData* d = (VehicleRenderData*)renderData;
+            bindTextureUnitCached(6, d->vinylTexture[0]);
+            glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+            glUniform4fv(10, 1, (GLfloat*)&d->shield);
+            bindVertexArrayCached(d->vao);
+            VinylBaker& baker = g_game.renderer->getVinylBaker();
+            i32 timer = baker.beginDrawTimer(true);
+            glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
+            baker.endDrawTimer(timer);
+        };
+        rw->opaqueColorPass(bakedColorShaderHandle,
+                { d, renderOpaqueBaked, stencil, bounds, makeStateKey(bakedPaintTexture, d->vao) });
+        return;
+    }
+
     d->vinylTexture[0] = g_res.getTexture(vinylTextureGuids[0])->handle;
     d->vinylTexture[1] = g_res.getTexture(vinylTextureGuids[1])->handle;
     d->vinylTexture[2] = g_res.getTexture(vinylTextureGuids[2])->handle;
@@ -252,33 +291,21 @@ void Material::drawVehicle(class RenderWorld* rw, Mat4 const& transform, struct
 
     auto renderOpaque = [](void* renderData) {
         VehicleRenderData* d = (VehicleRenderData*)renderData;
-        glBindTextureUnit(6, d->vinylTexture[0]);
-        glBindTextureUnit(7, d->vinylTexture[1]);
-        glBindTextureUnit(8, d->vinylTexture[2]);
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniformMatrix3fv(1, 1, GL_FALSE, d->normalTransform.valuePtr());
-        glUniform3fv(2, 1, (GLfloat*)&d->color);
-        glUniform3f(3, d->fresnelBias, d->fresnelScale, d->fresnelPower);
-        glUniform3f(4, d->specularPower, d->specularStrength, 0.f);
-        glUniform3fv(6, 1, (GLfloat*)&d->emission);
-        glUniform3f(7, d->reflectionStrength, d->reflectionLod, d->reflectionBias);
+        bindTextureUnitCached(6, d->vinylTexture[0]);
+        bindTextureUnitCached(7, d->vinylTexture[1]);
+        bindTextureUnitCached(8, d->vinylTexture[2]);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
         glUniform4fv(10, 1, (GLfloat*)&d->shield);
         glUniform4fv(11, 3, (GLfloat*)&d->vinylColor);
-        glBindVertexArray(d->vao);
-        glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
-    };
-
-    auto renderDepth = [](void* renderData) {
-        VehicleRenderData* d = (VehicleRenderData*)renderData;
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniformMatrix3fv(1, 1, GL_FALSE, d->normalTransform.valuePtr());
-        glBindVertexArray(d->vao);
+        bindVertexArrayCached(d->vao);
+        VinylBaker& baker = g_game.renderer->getVinylBaker();
+        i32 timer = baker.beginDrawTimer(false);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
+        baker.endDrawTimer(timer);
     };
 
-    rw->depthPrepass(depthShaderHandle, { d, renderDepth });
-    rw->shadowPass(shadowShaderHandle, { d, renderDepth });
-    rw->opaqueColorPass(colorShaderHandle, { d, renderOpaque, stencil });
+    rw->opaqueColorPass(colorShaderHandle,
+            { d, renderOpaque, stencil, bounds, makeStateKey(d->vinylTexture[0], d->vao) });
 }
 
 struct SimpleRenderData
@@ -286,11 +313,7 @@ struct SimpleRenderData
     GLuint vao;
     GLuint tex;
     u32 indexCount;
-    Mat4 worldTransform;
-    Mat3 normalTransform;
-    Vec3 color;
-    Vec3 emit;
-    RenderWorld* rw;
+    u32 drawIndex;
 };
 
 void drawSimple(RenderWorld* rw, Mesh* mesh, Texture* tex, Mat4 const& transform,
@@ -299,60 +322,71 @@ void drawSimple(RenderWorld* rw, Mesh* mesh, Texture* tex, Mat4 const& transform
     static ShaderHandle shader = getShaderHandle("lit");
     static ShaderHandle depthShader = getShaderHandle("lit", { { "DEPTH_ONLY" } });
 
+    DrawData data;
+    data.worldTransform = transform;
+    data.setNormalTransform(inverseTranspose(Mat3(transform)));
+    data.color = Vec4(color, 0.f);
+    data.emission = Vec4(emit, 0.f);
+    data.fresnel = Vec4(0.f);
+    data.specular = Vec4(300.f, 0.1f, 0.f, 0.f);
+    data.reflection = Vec4(0.f);
+    data.pickValue = 0;
+
     SimpleRenderData* d = g_tmpMem.bump<SimpleRenderData>();
+    if (!pushDrawData(data, d->drawIndex))
+    {
+        return;
+    }
     d->vao = mesh->vao;
     d->tex = tex->handle;
     d->indexCount = mesh->numIndices;
-    d->worldTransform = transform;
-    d->normalTransform = inverseTranspose(Mat3(transform));
-    d->color = color;
-    d->emit = emit;
 
     auto renderOpaque = [](void* renderData) {
         SimpleRenderData* d = (SimpleRenderData*)renderData;
-        glBindTextureUnit(0, d->tex);
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniformMatrix3fv(1, 1, GL_FALSE, d->normalTransform.valuePtr());
-        glUniform3fv(2, 1, (GLfloat*)&d->color);
-        glUniform3f(3, 0.f, 0.f, 0.f);
-        glUniform3f(4, 300.f, 0.1f, 0.f);
-        glUniform3fv(6, 1, (GLfloat*)&d->emit);
-        glUniform3f(7, 0.f, 0.f, 0.f);
-        glUniform1f(8, 0.f);
-        glBindVertexArray(d->vao);
+        bindTextureUnitCached(0, d->tex);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
 
     auto renderDepth = [](void* renderData) {
         SimpleRenderData* d = (SimpleRenderData*)renderData;
-        glUniformMatrix4fv(0, 1, GL_FALSE, d->worldTransform.valuePtr());
-        glUniform1f(8, 0.f);
-        glBindVertexArray(d->vao);
+        glUniform1ui(DRAW_INDEX_LOCATION, d->drawIndex);
+        bindVertexArrayCached(d->vao);
         glDrawElements(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT, 0);
     };
 
-    rw->depthPrepass(depthShader, { d, renderDepth });
-    rw->shadowPass(depthShader, { d, renderDepth });
-    rw->opaqueColorPass(shader, { d, renderOpaque, 0 });
+    BoundingSphere bounds = computeBoundingSphere(mesh->aabb, transform);
+    rw->depthPrepass(depthShader, { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) });
+    rw->shadowPass(depthShader, { d, renderDepth, 0, bounds, makeStateKey(0, d->vao) });
+    rw->opaqueColorPass(shader, { d, renderOpaque, 0, bounds, makeStateKey(d->tex, d->vao) });
 }
 
 void drawWireframe(RenderWorld* rw, Mesh* mesh, Mat4 const& transform, Vec4 color)
 {
     static ShaderHandle shader = getShaderHandle("debug");
 
-    SimpleRenderData* d = g_tmpMem.bump<SimpleRenderData>();
+    struct WireframeRenderData
+    {
+        GLuint vao;
+        u32 indexCount;
+        Mat4 worldTransform;
+        Vec4 color;
+        RenderWorld* rw;
+    };
+
+    WireframeRenderData* d = g_tmpMem.bump<WireframeRenderData>();
     d->vao = mesh->vao;
     d->indexCount = mesh->numIndices;
     d->worldTransform = transform;
-    d->color = color.rgb;
-    d->emit.r = color.a;
+    d->color = color;
     d->rw = rw;
 
     auto renderOpaque = [](void* renderData) {
-        SimpleRenderData* d = (SimpleRenderData*)renderData;
+        WireframeRenderData* d = (WireframeRenderData*)renderData;
 
         Camera const& camera = d->rw->getCamera(0);
-        glUniform4f(2, d->color.x, d->color.y, d->color.z, d->emit.r);
+        glUniform4f(2, d->color.x, d->color.y, d->color.z, d->color.w);
         glUniform1i(3, 1);
         Mat4 t = camera.viewProjection * d->worldTransform;
         glUniformMatrix4fv(1, 1, GL_FALSE, t.valuePtr());
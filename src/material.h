@@ -133,12 +133,14 @@ public:
     GLuint textureNormalHandle = 0;
 
     void loadShaderHandles(SmallArray<ShaderDefine> additionalDefines={});
-    void draw(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh, u8 stencil=0);
+    void draw(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh, u8 stencil=0,
+            bool isStaticShadowCaster=false);
     void drawPick(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh, u32 pickValue);
     void drawHighlight(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh,
             u8 stencil, u8 cameraIndex=0);
     void drawVehicle(class RenderWorld* rw, Mat4 const& transform, struct Mesh* mesh, u8 stencil,
-            Vec4 const& shield, i64 wrapTextureGuids[3], Vec4 wrapColor[3]);
+            Vec4 const& shield, i64 wrapTextureGuids[3], Vec4 wrapColor[3],
+            GLuint bakedPaintTexture=0);
 };
 
 void drawSimple(RenderWorld* rw, Mesh* mesh, struct Texture* tex, Mat4 const& transform,
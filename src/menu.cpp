@@ -86,8 +86,7 @@ gui::Button* garageButton(Menu* menu, gui::Widget* parent, u32 driverIndex, cons
         ->add(gui::FadeAnimation(0.f, 1.f, animationLength, true, name))->size(0,0)
         ->add(gui::ScaleAnimation(0.7f, 1.f, animationLength, true))->size(0,0)
         ->add(gui::Button(0, name, 0.f))->size(size);
-    // TODO: do the vehicle previews better somehow
-    Texture* vehiclePreviewTex = menu->vehiclePreviews[driverIndex].getTexture();
+    Texture* vehiclePreviewTex = menu->getDriverVehiclePreview(driverIndex);
     auto row = btn->add(gui::Row());
     row->add(gui::Image(vehiclePreviewTex, false, false, true))->size(size.y, size.y);
     auto col = row->add(gui::Container(gui::Insets(15)))->size(0,0)->add(gui::Column(15))->size(0,0);
@@ -255,34 +254,17 @@ void Menu::beginChampionship()
     openInitialCarLotMenu(garage.playerIndex);
 }
 
-void Menu::updateVehiclePreviews()
+Texture* Menu::getDriverVehiclePreview(u32 driverIndex)
 {
-    Mesh* quadMesh = g_res.getModel("misc")->getMeshByName("Quad");
-    for (u32 driverIndex=0; driverIndex<10; ++driverIndex)
-    {
-        RenderWorld& rw = vehiclePreviews[driverIndex];
-        rw.setName(tmpStr("Vehicle Icon %i", driverIndex));
-        u32 vehicleIconSize = (u32)(120 * gui::guiScale);
-        rw.setSize(vehicleIconSize, vehicleIconSize);
-        drawSimple(&rw, quadMesh, &g_res.white, Mat4::scaling(Vec3(20.f)), Vec3(0.02f));
-        Driver& driver = g_game.state.drivers[driverIndex];
-        if (driver.getVehicleData())
-        {
-            VehicleTuning t = driver.getTuning();
-            driver.getVehicleData()->render(&rw, Mat4::translation(Vec3(0, 0, t.getRestOffset())),
-                nullptr, *driver.getVehicleConfig(), &t);
-        }
-        rw.setViewportCount(1);
-        rw.addDirectionalLight(Vec3(-0.5f, 0.2f, -1.f), Vec3(1.0));
-        rw.setViewportCamera(0, Vec3(8.f, -8.f, 10.f), Vec3(0.f, 0.f, 1.f), 1.f, 50.f, 30.f);
-        g_game.renderer->addRenderWorld(&rw);
-    }
+    Driver& driver = g_game.state.drivers[driverIndex];
+    u32 vehicleIconSize = (u32)(120 * gui::guiScale);
+    return vehiclePreviews.get(tmpStr("Vehicle Icon %i", driverIndex), vehicleIconSize,
+            vehicleIconSize, driver.getVehicleData(), *driver.getVehicleConfig(), nullptr);
 }
 
 void Menu::openRaceResults()
 {
     mode = RACE_RESULTS;
-    updateVehiclePreviews();
     // generate fake race results
 #if 0
     Scene* scene = g_game.currentScene.get();
@@ -313,7 +295,6 @@ void Menu::openRaceResults()
 void Menu::openChampionshipMenu()
 {
     mode = CHAMPIONSHIP_MENU;
-    updateVehiclePreviews();
 }
 
 void Menu::openVinylMenu(u32 layerIndex)
@@ -434,7 +415,7 @@ void Menu::displayRaceResults()
 
         row->add(Stack())->size(columnWidth[0], 0)
            ->add(Text(font, tmpStr("%i", results.placement + 1), color));
-        row->add(Image(vehiclePreviews[driverIndex].getTexture(), false, false, true))->size(iconSize);
+        row->add(Image(getDriverVehiclePreview(driverIndex), false, false, true))->size(iconSize);
         row->add(Stack())->size(columnWidth[1], 0)
            ->add(Text(font, results.driver->playerName.data(), color));
         row->add(Container({}, {}, Vec4(0), HAlign::RIGHT))->size(columnWidth[2], 0)
@@ -516,8 +497,8 @@ void Menu::displayStandings()
            ->add(Text(font, tmpStr("%i", i+1), color));
 
         Vec2 iconSize(64);
-        row->add(Image(vehiclePreviews[driver - g_game.state.drivers.begin()].getTexture(), false,
-                false, true))->size(iconSize);
+        row->add(Image(getDriverVehiclePreview(
+                        (u32)(driver - g_game.state.drivers.begin())), false, false, true))->size(iconSize);
 
         row->add(Stack())->size(200, 0)
            ->add(Text(font, driver->playerName.data(), color));
@@ -838,29 +819,44 @@ void Menu::onUpdate(Renderer* renderer, f32 deltaTime)
             ->add(Text(mediumFontBold,
                         tmpStr("CREDITS: %i", garage.driver->credits), COLOR_OUTLINE_SELECTED));
 
-        // vehicle preview
-        Mesh* quadMesh = g_res.getModel("misc")->getMeshByName("Quad");
-        RenderWorld& rw = garage.rw;
-        rw.setName("Garage");
-        rw.setSize(
-                (u32)VEHICLE_PREVIEW_SIZE.x * gui::guiScale,
-                (u32)VEHICLE_PREVIEW_SIZE.y * gui::guiScale);
-        drawSimple(&rw, quadMesh, &g_res.white, Mat4::scaling(Vec3(20.f)), Vec3(0.02f));
-
-        if (garage.previewVehicle)
+        // vehicle preview, turned by dragging with the right mouse button or with the right stick
+        f32 previousPreviewAngle = garage.previewAngle;
+        Vec2 mousePos = g_input.getMousePosition();
+        if (g_input.isMouseButtonDown(MOUSE_RIGHT))
         {
-            Mat4 vehicleTransform = Mat4::rotationZ((f32)getTime());
-            garage.previewVehicle->render(&rw, Mat4::translation(
-                    Vec3(0, 0, garage.previewTuning.getRestOffset())) *
-                vehicleTransform, nullptr, garage.previewVehicleConfig, &garage.previewTuning);
+            if (!g_input.isMouseButtonPressed(MOUSE_RIGHT))
+            {
+                f32 angleDelta = (mousePos.x - garage.previewDragMousePos.x) * 0.01f;
+                garage.previewAngle += angleDelta;
+                garage.previewAngularVelocity = angleDelta / max(deltaTime, 0.001f);
+            }
+            garage.previewDragMousePos = mousePos;
         }
-        rw.setViewportCount(1);
-        rw.addDirectionalLight(Vec3(-0.5f, 0.2f, -1.f), Vec3(1.0));
-        rw.setViewportCamera(0, Vec3(8.f, -8.f, 10.f), Vec3(0.f, 0.f, 1.f), 1.f, 50.f, 30.f);
-        g_game.renderer->addRenderWorld(&rw);
+        else
+        {
+            for (auto& pair : g_input.getControllers())
+            {
+                f32 axis = pair.value.getAxis(AXIS_RIGHT_X);
+                if (absolute(axis) > 0.1f)
+                {
+                    garage.previewAngularVelocity = axis * 3.f;
+                }
+            }
+            garage.previewAngle += garage.previewAngularVelocity * deltaTime;
+            garage.previewAngularVelocity *= max(1.f - deltaTime * 4.f, 0.f);
+            if (absolute(garage.previewAngularVelocity) < 0.05f)
+            {
+                garage.previewAngularVelocity = 0.f;
+            }
+        }
+        Texture* previewTexture = vehiclePreviews.get("Garage",
+                (u32)(VEHICLE_PREVIEW_SIZE.x * gui::guiScale),
+                (u32)(VEHICLE_PREVIEW_SIZE.y * gui::guiScale),
+                garage.previewVehicle, garage.previewVehicleConfig, &garage.previewTuning,
+                garage.previewAngle, garage.previewAngle != previousPreviewAngle);
 
         auto previewContainer = column->add(Container())->size(0,0);
-        previewContainer->add(Image(rw.getTexture(), true, false, true))->size(VEHICLE_PREVIEW_SIZE);
+        previewContainer->add(Image(previewTexture, true, false, true))->size(VEHICLE_PREVIEW_SIZE);
         if (mode == GARAGE_CAR_LOT)
         {
             auto column = previewContainer
@@ -1004,43 +1000,24 @@ void Menu::onUpdate(Renderer* renderer, f32 deltaTime)
             }
 
             auto grid = column->add(Grid(3, 4))->size(SIDE_MENU_WIDTH, 0);
-            static Array<RenderWorld> carLotRenderWorlds(vehicles.size());
-            static bool arePreviewsRendered = false;
             Vec2 size(SIDE_MENU_WIDTH / 3);
             for (i32 i=0; i<(i32)vehicles.size(); ++i)
             {
-                RenderWorld& rw = carLotRenderWorlds[i];
                 VehicleData* v = vehicles[i];
 
-                if (!arePreviewsRendered)
-                {
-                    Mesh* quadMesh = g_res.getModel("misc")->getMeshByName("Quad");
-                    rw.setName("Garage");
-                    rw.setBloomForceOff(true);
-                    rw.setSize((u32)size.x * gui::guiScale * 2, (u32)size.y * gui::guiScale * 2);
-                    drawSimple(&rw, quadMesh, &g_res.white, Mat4::scaling(Vec3(20.f)), Vec3(0.02f));
-
-                    VehicleConfiguration vehicleConfig;
-                    vehicleConfig.cosmetics.color =
-                        srgb(hsvToRgb(v->defaultColorHsv.x, v->defaultColorHsv.y, v->defaultColorHsv.z));
-                    vehicleConfig.cosmetics.hsv = v->defaultColorHsv;
-
-                    VehicleTuning tuning;
-                    v->initTuning(vehicleConfig, tuning);
-                    Mat4 vehicleTransform = Mat4::rotationZ(0.f);
-                    v->render(&rw, Mat4::translation(Vec3(0, 0, tuning.getRestOffset())) *
-                        vehicleTransform, nullptr, vehicleConfig, &tuning);
-                    rw.setViewportCount(1);
-                    rw.addDirectionalLight(Vec3(-0.5f, 0.2f, -1.f), Vec3(1.0));
-                    rw.setViewportCamera(0, Vec3(8.f, -8.f, 10.f), Vec3(0.f, 0.f, 1.f), 1.f, 50.f, 30.f);
-                    renderer->addRenderWorld(&rw);
-                }
+                VehicleConfiguration vehicleConfig;
+                vehicleConfig.cosmetics.color =
+                    srgb(hsvToRgb(v->defaultColorHsv.x, v->defaultColorHsv.y, v->defaultColorHsv.z));
+                vehicleConfig.cosmetics.hsv = v->defaultColorHsv;
+                Texture* previewTexture = vehiclePreviews.get(tmpStr("Car Lot %i", i),
+                        (u32)(size.x * gui::guiScale * 2), (u32)(size.y * gui::guiScale * 2),
+                        v, vehicleConfig, nullptr, 0.f, false, false);
 
                 i32 totalCost = v->price - garage.driver->getVehicleValue();
                 bool enabled = v->guid == garage.driver->vehicleGuid ||
                     garage.driver->credits >= totalCost;
 
-                auto btn = squareButton(grid, rw.getTexture(), v->name.data(),
+                auto btn = squareButton(grid, previewTexture, v->name.data(),
                         garage.driver->getVehicleData() == v ? "OWNED" : tmpStr("%i", v->price),
                         size, 0, 0, 0.f, true);
                 btn->addFlags(enabled ? 0 : WidgetFlags::FADED);
@@ -1070,7 +1047,6 @@ void Menu::onUpdate(Renderer* renderer, f32 deltaTime)
                 });
                 btn->onGainedSelect([v]{ helpMessage = v->description.data(); });
             }
-            arePreviewsRendered = true;
 
             column->add(Container())->size(0, 20);
 
@@ -4,17 +4,19 @@
 #include "config.h"
 #include "font.h"
 #include "vehicle_data.h"
+#include "vehicle_preview.h"
 #include "input.h"
 
 struct GarageData
 {
-    RenderWorld rw;
-
     Driver* driver = nullptr;
 
     VehicleData* previewVehicle = nullptr;
     VehicleConfiguration previewVehicleConfig;
     VehicleTuning previewTuning;
+    f32 previewAngle = 0.f;
+    f32 previewAngularVelocity = 0.f;
+    Vec2 previewDragMousePos;
 
     VehicleStats currentStats;
     VehicleStats upgradeStats;
@@ -71,7 +73,6 @@ class Menu
     void startQuickRace();
     void resetGarage();
     void openInitialCarLotMenu(u32 playerIndex);
-    void updateVehiclePreviews();
     void openChampionshipMenu();
     void openVinylMenu(u32 layerIndex);
 
@@ -92,6 +93,6 @@ public:
 
     void onUpdate(class Renderer* renderer, f32 deltaTime);
 
-    // TODO: don't do vehicle previews like this
-    RenderWorld vehiclePreviews[10];
+    VehiclePreviewCache vehiclePreviews;
+    Texture* getDriverVehiclePreview(u32 driverIndex);
 };
@@ -0,0 +1,379 @@
+#include "null_gl.h"
+#include "imgui.h"
+
+GLuint NullGL::create(u32 type)
+{
+    if (objects.empty())
+    {
+        // name 0 is never a valid object
+        objects.push({});
+    }
+    objects.push({});
+    objects.back().type = type;
+    ++liveCount[type];
+    return objects.size() - 1;
+}
+
+void NullGL::destroy(GLuint name)
+{
+    if (name > 0 && name < objects.size() && objects[name].type != NullGLObjectType::NONE)
+    {
+        --liveCount[objects[name].type];
+        objects[name] = {};
+    }
+}
+
+void NullGL::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_PIXEL_PACK_BUFFER)
+    {
+        pixelPackBuffer = buffer;
+    }
+}
+
+void NullGL::showDebugInfo()
+{
+    ImGui::Text("Null GL: %llu calls, %.1fmb written", (unsigned long long)callCount,
+            bytesWritten / (1024.0 * 1024.0));
+    ImGui::Text("Null GL Objects: %u buffers, %u textures, %u framebuffers, %u vertex arrays, "
+            "%u programs", liveCount[NullGLObjectType::BUFFER],
+            liveCount[NullGLObjectType::TEXTURE], liveCount[NullGLObjectType::FRAMEBUFFER],
+            liveCount[NullGLObjectType::VERTEX_ARRAY], liveCount[NullGLObjectType::PROGRAM]);
+}
+
+// Used for every function that has no effect on the caller. The real signatures differ, but the
+// 64 bit calling conventions leave the arguments to the caller, so ignoring them is safe.
+static_assert(sizeof(void*) == 8, "The null GL backend requires a 64 bit target");
+static void APIENTRY nullGLCall()
+{
+    ++g_nullGL.callCount;
+}
+
+template <u32 TYPE>
+static void APIENTRY nullGLGenObjects(GLsizei n, GLuint* names)
+{
+    ++g_nullGL.callCount;
+    for (GLsizei i=0; i<n; ++i)
+    {
+        names[i] = g_nullGL.create(TYPE);
+    }
+}
+
+template <u32 TYPE>
+static void APIENTRY nullGLCreateObjects(GLenum, GLsizei n, GLuint* names)
+{
+    nullGLGenObjects<TYPE>(n, names);
+}
+
+static void APIENTRY nullGLDeleteObjects(GLsizei n, const GLuint* names)
+{
+    ++g_nullGL.callCount;
+    for (GLsizei i=0; i<n; ++i)
+    {
+        g_nullGL.destroy(names[i]);
+    }
+}
+
+static void APIENTRY nullGLDeleteObject(GLuint name)
+{
+    ++g_nullGL.callCount;
+    g_nullGL.destroy(name);
+}
+
+static GLuint APIENTRY nullGLCreateShader(GLenum)
+{
+    ++g_nullGL.callCount;
+    return g_nullGL.create(NullGLObjectType::SHADER);
+}
+
+static GLuint APIENTRY nullGLCreateProgram()
+{
+    ++g_nullGL.callCount;
+    return g_nullGL.create(NullGLObjectType::PROGRAM);
+}
+
+static void APIENTRY nullGLNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data,
+        GLenum)
+{
+    ++g_nullGL.callCount;
+    NullGL::Object* b = g_nullGL.get(buffer, NullGLObjectType::BUFFER);
+    if (b)
+    {
+        b->data.resize((u32)size);
+        if (data)
+        {
+            memcpy(b->data.data(), data, size);
+            g_nullGL.bytesWritten += size;
+        }
+    }
+}
+
+static void APIENTRY nullGLNamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data,
+        GLbitfield)
+{
+    nullGLNamedBufferData(buffer, size, data, 0);
+}
+
+static void APIENTRY nullGLNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size,
+        const void* data)
+{
+    ++g_nullGL.callCount;
+    NullGL::Object* b = g_nullGL.get(buffer, NullGLObjectType::BUFFER);
+    if (b && offset + size <= (GLsizeiptr)b->data.size())
+    {
+        memcpy(b->data.data() + offset, data, size);
+        g_nullGL.bytesWritten += size;
+    }
+}
+
+static void APIENTRY nullGLGetNamedBufferSubData(GLuint buffer, GLintptr offset,
+        GLsizeiptr size, void* data)
+{
+    ++g_nullGL.callCount;
+    NullGL::Object* b = g_nullGL.get(buffer, NullGLObjectType::BUFFER);
+    if (b && offset + size <= (GLsizeiptr)b->data.size())
+    {
+        memcpy(data, b->data.data() + offset, size);
+    }
+}
+
+static void* APIENTRY nullGLMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr,
+        GLbitfield)
+{
+    ++g_nullGL.callCount;
+    NullGL::Object* b = g_nullGL.get(buffer, NullGLObjectType::BUFFER);
+    return b ? b->data.data() + offset : nullptr;
+}
+
+static GLboolean APIENTRY nullGLUnmapNamedBuffer(GLuint)
+{
+    ++g_nullGL.callCount;
+    return GL_TRUE;
+}
+
+static void APIENTRY nullGLBindBuffer(GLenum target, GLuint buffer)
+{
+    ++g_nullGL.callCount;
+    g_nullGL.bindBuffer(target, buffer);
+}
+
+static void APIENTRY nullGLTextureStorage2D(GLuint texture, GLsizei, GLenum internalFormat,
+        GLsizei width, GLsizei height)
+{
+    ++g_nullGL.callCount;
+    NullGL::Object* t = g_nullGL.get(texture, NullGLObjectType::TEXTURE);
+    if (t)
+    {
+        t->internalFormat = internalFormat;
+        t->width = width;
+        t->height = height;
+    }
+}
+
+static void APIENTRY nullGLGetTextureLevelParameteriv(GLuint texture, GLint level, GLenum pname,
+        GLint* params)
+{
+    ++g_nullGL.callCount;
+    *params = 0;
+    NullGL::Object* t = g_nullGL.get(texture, NullGLObjectType::TEXTURE);
+    if (!t)
+    {
+        return;
+    }
+    i32 width = max(t->width >> level, 1);
+    i32 height = max(t->height >> level, 1);
+    switch (pname)
+    {
+        case GL_TEXTURE_WIDTH:
+            *params = width;
+            break;
+        case GL_TEXTURE_HEIGHT:
+            *params = height;
+            break;
+        case GL_TEXTURE_COMPRESSED_IMAGE_SIZE:
+        {
+            bool isHalfBlock = t->internalFormat == GL_COMPRESSED_RED_RGTC1
+                || t->internalFormat == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                || t->internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                || t->internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            *params = ((width + 3) / 4) * ((height + 3) / 4) * (isHalfBlock ? 8 : 16);
+        } break;
+    }
+}
+
+static void APIENTRY nullGLReadPixels(GLint, GLint, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, void* pixels)
+{
+    ++g_nullGL.callCount;
+    if (g_nullGL.getPixelPackBuffer())
+    {
+        return;
+    }
+    u32 components = 4;
+    if (format == GL_RED || format == GL_RED_INTEGER || format == GL_DEPTH_COMPONENT
+            || format == GL_STENCIL_INDEX)
+    {
+        components = 1;
+    }
+    else if (format == GL_RG || format == GL_RG_INTEGER)
+    {
+        components = 2;
+    }
+    else if (format == GL_RGB || format == GL_RGB_INTEGER)
+    {
+        components = 3;
+    }
+    u32 componentSize = 4;
+    if (type == GL_UNSIGNED_BYTE || type == GL_BYTE)
+    {
+        componentSize = 1;
+    }
+    else if (type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT)
+    {
+        componentSize = 2;
+    }
+    memset(pixels, 0, (size_t)width * height * components * componentSize);
+}
+
+static void APIENTRY nullGLGetIntegerv(GLenum pname, GLint* data)
+{
+    ++g_nullGL.callCount;
+    switch (pname)
+    {
+        case GL_NUM_EXTENSIONS:
+            *data = 1;
+            break;
+        case GL_MAJOR_VERSION:
+            *data = 4;
+            break;
+        case GL_MINOR_VERSION:
+            *data = 5;
+            break;
+        case GL_MAX_TEXTURE_SIZE:
+            *data = 16384;
+            break;
+        default:
+            *data = 0;
+            break;
+    }
+}
+
+static void APIENTRY nullGLGetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+    ++g_nullGL.callCount;
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY nullGLGetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+    ++g_nullGL.callCount;
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static const GLubyte* APIENTRY nullGLGetString(GLenum name)
+{
+    ++g_nullGL.callCount;
+    switch (name)
+    {
+        case GL_VENDOR: return (const GLubyte*)"None";
+        case GL_RENDERER: return (const GLubyte*)"Null Renderer";
+        case GL_VERSION: return (const GLubyte*)"4.5.0 Null";
+        case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"4.50";
+    }
+    return (const GLubyte*)"";
+}
+
+static const GLubyte* APIENTRY nullGLGetStringi(GLenum, GLuint)
+{
+    ++g_nullGL.callCount;
+    // the debug output functions are used in debug builds
+    return (const GLubyte*)"GL_ARB_debug_output";
+}
+
+static GLenum APIENTRY nullGLGetError()
+{
+    ++g_nullGL.callCount;
+    return GL_NO_ERROR;
+}
+
+static GLenum APIENTRY nullGLCheckFramebufferStatus(GLenum)
+{
+    ++g_nullGL.callCount;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLenum APIENTRY nullGLCheckNamedFramebufferStatus(GLuint, GLenum)
+{
+    ++g_nullGL.callCount;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLsync APIENTRY nullGLFenceSync(GLenum, GLbitfield)
+{
+    ++g_nullGL.callCount;
+    // never dereferenced, it only has to be non-zero
+    return (GLsync)(uintptr_t)1;
+}
+
+static GLenum APIENTRY nullGLClientWaitSync(GLsync, GLbitfield, GLuint64)
+{
+    ++g_nullGL.callCount;
+    return GL_ALREADY_SIGNALED;
+}
+
+void* NullGL::getProcAddress(const char* name)
+{
+    static const struct
+    {
+        const char* name;
+        void* proc;
+    } procs[] = {
+        { "glGenBuffers", (void*)nullGLGenObjects<NullGLObjectType::BUFFER> },
+        { "glCreateBuffers", (void*)nullGLGenObjects<NullGLObjectType::BUFFER> },
+        { "glDeleteBuffers", (void*)nullGLDeleteObjects },
+        { "glGenTextures", (void*)nullGLGenObjects<NullGLObjectType::TEXTURE> },
+        { "glCreateTextures", (void*)nullGLCreateObjects<NullGLObjectType::TEXTURE> },
+        { "glDeleteTextures", (void*)nullGLDeleteObjects },
+        { "glGenFramebuffers", (void*)nullGLGenObjects<NullGLObjectType::FRAMEBUFFER> },
+        { "glCreateFramebuffers", (void*)nullGLGenObjects<NullGLObjectType::FRAMEBUFFER> },
+        { "glDeleteFramebuffers", (void*)nullGLDeleteObjects },
+        { "glGenRenderbuffers", (void*)nullGLGenObjects<NullGLObjectType::RENDERBUFFER> },
+        { "glCreateRenderbuffers", (void*)nullGLGenObjects<NullGLObjectType::RENDERBUFFER> },
+        { "glDeleteRenderbuffers", (void*)nullGLDeleteObjects },
+        { "glGenVertexArrays", (void*)nullGLGenObjects<NullGLObjectType::VERTEX_ARRAY> },
+        { "glCreateVertexArrays", (void*)nullGLGenObjects<NullGLObjectType::VERTEX_ARRAY> },
+        { "glDeleteVertexArrays", (void*)nullGLDeleteObjects },
+        { "glCreateShader", (void*)nullGLCreateShader },
+        { "glDeleteShader", (void*)nullGLDeleteObject },
+        { "glCreateProgram", (void*)nullGLCreateProgram },
+        { "glDeleteProgram", (void*)nullGLDeleteObject },
+        { "glNamedBufferData", (void*)nullGLNamedBufferData },
+        { "glNamedBufferStorage", (void*)nullGLNamedBufferStorage },
+        { "glNamedBufferSubData", (void*)nullGLNamedBufferSubData },
+        { "glGetNamedBufferSubData", (void*)nullGLGetNamedBufferSubData },
+        { "glMapNamedBufferRange", (void*)nullGLMapNamedBufferRange },
+        { "glUnmapNamedBuffer", (void*)nullGLUnmapNamedBuffer },
+        { "glBindBuffer", (void*)nullGLBindBuffer },
+        { "glTextureStorage2D", (void*)nullGLTextureStorage2D },
+        { "glGetTextureLevelParameteriv", (void*)nullGLGetTextureLevelParameteriv },
+        { "glReadPixels", (void*)nullGLReadPixels },
+        { "glGetIntegerv", (void*)nullGLGetIntegerv },
+        { "glGetShaderiv", (void*)nullGLGetShaderiv },
+        { "glGetProgramiv", (void*)nullGLGetProgramiv },
+        { "glGetString", (void*)nullGLGetString },
+        { "glGetStringi", (void*)nullGLGetStringi },
+        { "glGetError", (void*)nullGLGetError },
+        { "glCheckFramebufferStatus", (void*)nullGLCheckFramebufferStatus },
+        { "glCheckNamedFramebufferStatus", (void*)nullGLCheckNamedFramebufferStatus },
+        { "glFenceSync", (void*)nullGLFenceSync },
+        { "glClientWaitSync", (void*)nullGLClientWaitSync },
+    };
+    for (auto const& p : procs)
+    {
+        if (strcmp(p.name, name) == 0)
+        {
+            return p.proc;
+        }
+    }
+    return (void*)nullGLCall;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "misc.h"
+#include "gl.h"
+
+namespace NullGLObjectType
+{
+    enum
+    {
+        NONE,
+        BUFFER,
+        TEXTURE,
+        FRAMEBUFFER,
+        RENDERBUFFER,
+        VERTEX_ARRAY,
+        SHADER,
+        PROGRAM,
+        MAX
+    };
+};
+
+// A GL implementation that never touches a context, for measuring the CPU side of the renderer
+// on machines without a GPU or display (see Game::isNullRendererEnabled). It is installed as the
+// glad loader, so the rest of the code makes the same calls as usual. Object names are handed
+// out and tracked, buffers are backed by CPU memory so that mapping and reading them back works,
+// and queries return values that keep the renderer on its normal path (shaders always compile,
+// framebuffers are always complete, fences are always signaled). Every other function does
+// nothing except count the call.
+class NullGL
+{
+public:
+    struct Object
+    {
+        u32 type = NullGLObjectType::NONE;
+        Array<u8> data;
+        GLenum internalFormat = 0;
+        i32 width = 0;
+        i32 height = 0;
+    };
+
+private:
+    Array<Object> objects;
+    u32 liveCount[NullGLObjectType::MAX] = {};
+    GLuint pixelPackBuffer = 0;
+
+public:
+    u64 callCount = 0;
+    u64 bytesWritten = 0;
+
+    static void* getProcAddress(const char* name);
+
+    GLuint create(u32 type);
+    void destroy(GLuint name);
+    Object* get(GLuint name, u32 type)
+    {
+        return (name < objects.size() && objects[name].type == type) ? &objects[name] : nullptr;
+    }
+    void bindBuffer(GLenum target, GLuint buffer);
+    GLuint getPixelPackBuffer() const { return pixelPackBuffer; }
+
+    void showDebugInfo();
+};
+
+NullGL g_nullGL;
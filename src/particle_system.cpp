@@ -1,54 +1,251 @@
 #include "particle_system.h"
 #include "game.h"
 #include "renderer.h"
+#include "imgui.h"
+
+ParticleSystem::~ParticleSystem()
+{
+    instanceBuffer.destroy();
+    if (vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+    }
+}
+
+void ParticleSystem::remove(u32 index)
+{
+    u32 last = positions.size() - 1;
+    positions[index] = positions[last];
+    velocities[index] = velocities[last];
+    scales[index] = scales[last];
+    angles[index] = angles[last];
+    lives[index] = lives[last];
+    totalLives[index] = totalLives[last];
+    colors[index] = colors[last];
+    alphaMultipliers[index] = alphaMultipliers[last];
+    positions.pop();
+    velocities.pop();
+    scales.pop();
+    angles.pop();
+    lives.pop();
+    totalLives.pop();
+    colors.pop();
+    alphaMultipliers.pop();
+}
+
+void ParticleSystem::clear()
+{
+    positions.clear();
+    velocities.clear();
+    scales.clear();
+    angles.clear();
+    lives.clear();
+    totalLives.clear();
+    colors.clear();
+    alphaMultipliers.clear();
+}
 
 void ParticleSystem::update(f32 deltaTime)
 {
-    for (auto p = particles.begin(); p != particles.end();)
+    for (u32 i=0; i<lives.size();)
     {
-        f32 t = p->life / p->totalLife;
-        if (t >= 1.f)
+        if (lives[i] >= totalLives[i])
         {
-            p = particles.erase(p);
+            remove(i);
             continue;
         }
+        ++i;
+    }
 
-        p->scale += deltaTime * 0.5f;
-        p->position += p->velocity * deltaTime;
-        p->life += deltaTime;
+    u32 count = positions.size();
+    Vec3* position = positions.data();
+    Vec3* velocity = velocities.data();
+    f32* scale = scales.data();
+    f32* life = lives.data();
+    for (u32 i=0; i<count; ++i)
+    {
+        position[i] += velocity[i] * deltaTime;
+    }
+    for (u32 i=0; i<count; ++i)
+    {
+        scale[i] += deltaTime * 0.5f;
+        life[i] += deltaTime;
+    }
+}
 
-        ++p;
+BoundingBox ParticleSystem::buildInstances(Instance* instances) const
+{
+    BoundingBox bb = { Vec3(FLT_MAX), Vec3(-FLT_MAX) };
+    for (u32 i=0; i<positions.size(); ++i)
+    {
+        f32 t = lives[i] / totalLives[i];
+        f32 alphaCurveValue = getCurveValue(alphaCurve, t);
+        f32 scaleCurveValue = getCurveValue(scaleCurve, t);
+
+        Instance& instance = instances[i];
+        instance.position = positions[i];
+        instance.scale = scaleCurveValue * scales[i];
+        instance.color = colors[i] * Vec4(1, 1, 1, alphaCurveValue * alphaMultipliers[i]);
+        instance.angle = angles[i];
+
+        Vec3 extent(instance.scale * 1.5f);
+        bb.min = min(bb.min, positions[i] - extent);
+        bb.max = max(bb.max, positions[i] + extent);
     }
+    return bb;
 }
 
 void ParticleSystem::draw(RenderWorld* rw)
 {
-    static ShaderHandle shaderLit = getShaderHandle("billboard", { {"LIT"} });
-    static ShaderHandle shaderUnlit = getShaderHandle("billboard", {});
+    static ShaderHandle shaderLit = getShaderHandle("billboard", { {"LIT"}, {"PARTICLE"} });
+    static ShaderHandle shaderUnlit = getShaderHandle("billboard", { {"PARTICLE"} });
+
+    instanceCount = positions.size();
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    if (!vao)
+    {
+        glCreateVertexArrays(1, &vao);
+
+        glEnableVertexArrayAttrib(vao, 0);
+        glVertexArrayAttribFormat(vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, position));
+        glVertexArrayAttribBinding(vao, 0, 0);
+
+        glEnableVertexArrayAttrib(vao, 1);
+        glVertexArrayAttribFormat(vao, 1, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, color));
+        glVertexArrayAttribBinding(vao, 1, 0);
+
+        glEnableVertexArrayAttrib(vao, 2);
+        glVertexArrayAttribFormat(vao, 2, 1, GL_FLOAT, GL_FALSE, offsetof(Instance, angle));
+        glVertexArrayAttribBinding(vao, 2, 0);
+
+        glVertexArrayBindingDivisor(vao, 0, 1);
+    }
+
+    size_t size = instanceCount * sizeof(Instance);
+    Instance* instances = (Instance*)instanceBuffer.map(size, &instanceOffset);
+    BoundingBox bb = buildInstances(instances);
+    instanceBuffer.unmap();
 
     auto render = [](void* renderData){
         ParticleSystem* ps = (ParticleSystem*)renderData;
-
-        glBindVertexArray(emptyVAO);
         glBindTextureUnit(0, ps->texture->handle);
+        glVertexArrayVertexBuffer(ps->vao, 0, ps->instanceBuffer.getBuffer(), ps->instanceOffset,
+                sizeof(Instance));
+        glBindVertexArray(ps->vao);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, ps->instanceCount);
+    };
+    BoundingSphere bounds = { (bb.min + bb.max) * 0.5f, length(bb.max - bb.min) * 0.5f };
+    rw->transparentPass({ lit ? shaderLit : shaderUnlit, TransparentDepth::PARTICLE_SYSTEM, this,
+            render, bounds });
+}
+
+ParticleSystem::BenchmarkResult ParticleSystem::runBenchmark()
+{
+    const u32 PARTICLE_COUNT = 100000;
+    const u32 STEPS = 30;
+    const f32 deltaTime = 1.f / 60.f;
 
-        for (auto& p : ps->particles)
+    BenchmarkResult result;
+    result.particleCount = PARTICLE_COUNT;
+
+    ParticleSystem ps(PARTICLE_COUNT);
+    ps.minLife = 0.25f;
+    ps.maxLife = 2.f;
+    RandomSeries series{ 1234 };
+    auto refill = [&] {
+        while (ps.size() < PARTICLE_COUNT)
         {
-            f32 t = p.life / p.totalLife;
-            f32 alphaCurveValue = getCurveValue(ps->alphaCurve, t);
-            f32 scaleCurveValue = getCurveValue(ps->scaleCurve, t);
-
-            auto scale = Vec3(scaleCurveValue * p.scale);
-            auto color = p.color * Vec4(1, 1, 1, alphaCurveValue * p.alphaMultiplier);
-
-            glUniform4fv(0, 1, (GLfloat*)&color);
-            Mat4 translation = Mat4::translation(p.position);
-            Mat4 rotation = Mat4::rotationZ(p.angle);
-            glUniformMatrix4fv(1, 1, GL_FALSE, translation.valuePtr());
-            glUniform3f(2, scale.x, scale.y, scale.z);
-            glUniformMatrix4fv(3, 1, GL_FALSE, rotation.valuePtr());
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            ps.spawn(Vec3(random(series, -100.f, 100.f), random(series, -100.f, 100.f), 0.f),
+                    Vec3(random(series, -5.f, 5.f), random(series, -5.f, 5.f), 5.f), 1.f);
         }
     };
-    rw->transparentPass({ lit ? shaderLit : shaderUnlit, TransparentDepth::PARTICLE_SYSTEM, this, render });
+    refill();
+
+    // mimics the old array of structs that erased dead particles in place
+    struct Particle
+    {
+        Vec3 position;
+        Vec3 velocity;
+        f32 scale;
+        f32 angle;
+        f32 life;
+        f32 totalLife;
+        Vec4 color;
+        f32 alphaMultiplier;
+    };
+    Array<Particle> particles;
+    particles.reserve(PARTICLE_COUNT);
+    for (u32 i=0; i<PARTICLE_COUNT; ++i)
+    {
+        ps.lives[i] = random(series, 0.f, ps.totalLives[i]);
+        particles.push({ ps.positions[i], ps.velocities[i], ps.scales[i], ps.angles[i],
+                ps.lives[i], ps.totalLives[i], ps.colors[i], ps.alphaMultipliers[i] });
+    }
+
+    f64 t = getTime();
+    for (auto p = particles.begin(); p != particles.end();)
+    {
+        if (p->life >= p->totalLife)
+        {
+            p = particles.erase(p);
+            continue;
+        }
+        p->scale += deltaTime * 0.5f;
+        p->position += p->velocity * deltaTime;
+        p->life += deltaTime;
+        ++p;
+    }
+    result.eraseUpdateTime = getTime() - t;
+
+    Array<Instance> instances(PARTICLE_COUNT);
+    for (u32 i=0; i<STEPS; ++i)
+    {
+        t = getTime();
+        ps.update(deltaTime);
+        result.updateTime += getTime() - t;
+
+        t = getTime();
+        ps.buildInstances(instances.data());
+        result.buildTime += getTime() - t;
+
+        refill();
+    }
+    result.updateTime /= STEPS;
+    result.buildTime /= STEPS;
+
+    return result;
+}
+
+void ParticleSystem::showBenchmark()
+{
+    static BenchmarkResult result;
+    static f64 fullDrawTime = 0.0;
+    static u32 fullDrawCount = 0;
+    if (ImGui::Button("Particle Benchmark"))
+    {
+        result = runBenchmark();
+
+        // A system at its cap maps its instance buffer exactly full, like a big burst of
+        // explosion smoke does. This needs the renderer, so it isn't part of runBenchmark().
+        ParticleSystem full;
+        while (full.size() < full.maxParticles)
+        {
+            full.spawn(Vec3(0.f), Vec3(0.f, 0.f, 1.f), 1.f);
+        }
+        f64 t = getTime();
+        size_t size = full.size() * sizeof(Instance);
+        full.buildInstances((Instance*)full.instanceBuffer.map(size, &full.instanceOffset));
+        full.instanceBuffer.unmap();
+        fullDrawTime = getTime() - t;
+        fullDrawCount = full.size();
+    }
+    ImGui::Text("%uk particles: update %.3fms, build instances %.3fms (erase update %.3fms)",
+            result.particleCount / 1000, result.updateTime * 1000.0, result.buildTime * 1000.0,
+            result.eraseUpdateTime * 1000.0);
+    ImGui::Text("Full system (%u particles): mapped and built in %.3fms", fullDrawCount,
+            fullDrawTime * 1000.0);
 }
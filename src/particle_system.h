@@ -1,6 +1,10 @@
 #pragma once
 
 #include "misc.h"
+#include "math.h"
+#include "gl.h"
+#include "dynamic_buffer.h"
+#include "bounding_box.h"
 
 template <typename T>
 f32 getCurveValue(T const& curve, f32 t)
@@ -21,23 +25,41 @@ f32 getCurveValue(T const& curve, f32 t)
 class ParticleSystem
 {
 private:
-    struct Particle
+    // Particles are stored as a struct of arrays, and dead particles are swapped with the last one
+    // instead of shifting the rest of the arrays down.
+    Array<Vec3> positions;
+    Array<Vec3> velocities;
+    Array<f32> scales;
+    Array<f32> angles;
+    Array<f32> lives;
+    Array<f32> totalLives;
+    Array<Vec4> colors;
+    Array<f32> alphaMultipliers;
+
+    RandomSeries series;
+
+    // per-instance data of the billboard shader when PARTICLE is defined
+    struct Instance
     {
         Vec3 position;
-        Vec3 velocity;
-        f32 scale = 1.f;
-        f32 angle = 0.f;
-        f32 life = 0.f;
-        f32 totalLife = 0.f;
-        Vec4 color = Vec4(1.f);
-        f32 alphaMultiplier = 1.f;
+        f32 scale;
+        Vec4 color;
+        f32 angle;
     };
 
-    Array<Particle> particles;
+    DynamicBuffer instanceBuffer;
+    GLuint vao = 0;
+    size_t instanceOffset = 0;
+    u32 instanceCount = 0;
 
-    RandomSeries series;
+    u32 maxParticles;
+    u32 droppedCount = 0;
+
+    void remove(u32 index);
+    BoundingBox buildInstances(Instance* instances) const;
 
 public:
+
     f32 minLife = 1.5f;
     f32 maxLife = 1.8f;
     f32 minAngle = 0.f;
@@ -62,24 +84,47 @@ public:
         { 1.f, 1.f },
     };
 
+    ParticleSystem(u32 maxParticles = 16384)
+        : instanceBuffer(sizeof(Instance) * maxParticles), maxParticles(maxParticles) {}
+    ~ParticleSystem();
+
+    // The instance buffer is sized for maxParticles, so particles spawned past it are dropped and
+    // counted instead. Explosions spawn into the scene's smoke and sparks systems, so those have
+    // to be sized for the worst case of the whole scene.
     void spawn(Vec3 const& position, Vec3 const& velocity, f32 alpha,
             Vec4 const& color = Vec4(1.f), f32 scale = 1.f)
     {
-        particles.push({
-            position,
-            velocity,
-            random(series, minScale, maxScale) * scale,
-            random(series, minAngle, maxAngle) * scale,
-            0.f,
-            random(series, minLife, maxLife),
-            color,
-            alpha
-        });
+        if (positions.size() == maxParticles)
+        {
+            ++droppedCount;
+            return;
+        }
+        positions.push(position);
+        velocities.push(velocity);
+        scales.push(random(series, minScale, maxScale) * scale);
+        angles.push(random(series, minAngle, maxAngle) * scale);
+        lives.push(0.f);
+        totalLives.push(random(series, minLife, maxLife));
+        colors.push(color);
+        alphaMultipliers.push(alpha);
     }
 
     void update(f32 deltaTime);
-    void clear() { particles.clear(); }
+    void clear();
     void draw(class RenderWorld* rw);
+    u32 size() const { return positions.size(); }
+    u32 getDroppedCount() const { return droppedCount; }
+
+    struct BenchmarkResult
+    {
+        u32 particleCount = 0;
+        f64 updateTime = 0.0;
+        f64 buildTime = 0.0;
+        f64 eraseUpdateTime = 0.0;
+    };
+    // doesn't touch GL, so it can run before the renderer is created (see --particle-benchmark)
+    static BenchmarkResult runBenchmark();
+    static void showBenchmark();
 };
 
 struct ParticleEmitter
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "misc.h"
+#include "math.h"
+#include "entity.h"
+
+// the sort key is made from ids that are the same every run (not addresses) so events are
+// handled in the same order regardless of the order the callbacks ran in
+struct ContactEvent
+{
+    u64 sortKey;
+    ActorUserData* a;
+    ActorUserData* b;
+    PxVec3 position;
+    PxVec3 normal;
+    PxVec3 velocityA;
+    PxVec3 velocityB;
+    f32 impulse;
+    bool canSpark;
+
+    bool operator < (ContactEvent const& other) const
+    {
+        if (sortKey != other.sortKey) return sortKey < other.sortKey;
+        if (position.x != other.position.x) return position.x < other.position.x;
+        if (position.y != other.position.y) return position.y < other.position.y;
+        return position.z < other.position.z;
+    }
+};
+
+struct TriggerEvent
+{
+    u64 sortKey;
+    ActorUserData* trigger;
+    ActorUserData* other;
+
+    bool operator < (TriggerEvent const& other) const { return sortKey < other.sortKey; }
+};
+
+// Fixed capacity queue of the events reported by the PhysX simulation callbacks. The callbacks
+// only record events (possibly from several threads at once) and the events are handled after
+// fetchResults() in a deterministic order. Events that don't fit are dropped.
+template <typename T, u32 CAPACITY>
+class PhysicsEventQueue
+{
+    Array<T> events;
+    SDL_atomic_t count;
+    u32 droppedCount = 0;
+    u32 lastCount = 0;
+
+public:
+    PhysicsEventQueue()
+    {
+        events.resize(CAPACITY);
+        SDL_AtomicSet(&count, 0);
+    }
+
+    void push(T const& event)
+    {
+        i32 index = SDL_AtomicAdd(&count, 1);
+        if (index < (i32)CAPACITY)
+        {
+            events[index] = event;
+        }
+    }
+
+    // calls the callback for each event in sorted order and then clears the queue
+    template <typename F>
+    void consume(F const& callback)
+    {
+        u32 n = (u32)SDL_AtomicGet(&count);
+        droppedCount += n > CAPACITY ? n - CAPACITY : 0;
+        n = min(n, CAPACITY);
+
+        // shrinking and growing within the capacity does not allocate
+        events.resize(n);
+        events.sort();
+        for (T const& event : events)
+        {
+            callback(event);
+        }
+        events.resize(CAPACITY);
+
+        lastCount = n;
+        SDL_AtomicSet(&count, 0);
+    }
+
+    u32 getLastCount() const { return lastCount; }
+    u32 getDroppedCount() const { return droppedCount; }
+};
@@ -0,0 +1,131 @@
+#include "physx_allocator.h"
+#include "imgui.h"
+
+#if _WIN32
+#include <malloc.h>
+#endif
+
+// stored in front of every allocation, the size keeps the returned memory 16 byte aligned
+struct AllocationHeader
+{
+    u64 size;
+    u32 nameIndex;
+    u32 pad;
+};
+static_assert(sizeof(AllocationHeader) == 16);
+
+u32 TrackingAllocator::getNameIndex(const char* name)
+{
+    // the names are string literals so the pointer almost always matches
+    for (u32 i=0; i<nameCount; ++i)
+    {
+        if (stats[i].name == name)
+        {
+            return i;
+        }
+    }
+    for (u32 i=0; i<nameCount; ++i)
+    {
+        if (strcmp(stats[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    if (nameCount == MAX_NAMES)
+    {
+        // everything else is lumped into the last entry
+        stats[MAX_NAMES - 1].name = "Other";
+        return MAX_NAMES - 1;
+    }
+    stats[nameCount] = { name, 0, 0, 0 };
+    return nameCount++;
+}
+
+void* TrackingAllocator::allocate(size_t size, const char* typeName, const char* filename, int line)
+{
+    size_t fullSize = size + sizeof(AllocationHeader);
+#if _WIN32
+    u8* mem = (u8*)_aligned_malloc(fullSize, 16);
+#else
+    u8* mem = nullptr;
+    if (posix_memalign((void**)&mem, 16, fullSize) != 0)
+    {
+        mem = nullptr;
+    }
+#endif
+    if (!mem)
+    {
+        return nullptr;
+    }
+
+    SDL_AtomicLock(&lock);
+    u32 nameIndex = getNameIndex(typeName ? typeName : "Unknown");
+    NameStats& s = stats[nameIndex];
+    s.liveBytes += size;
+    s.liveCount += 1;
+    s.totalCount += 1;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+    {
+        peakBytes = liveBytes;
+    }
+    totalCount += 1;
+    SDL_AtomicUnlock(&lock);
+
+    AllocationHeader* header = (AllocationHeader*)mem;
+    header->size = size;
+    header->nameIndex = nameIndex;
+
+    return mem + sizeof(AllocationHeader);
+}
+
+void TrackingAllocator::deallocate(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    AllocationHeader* header = (AllocationHeader*)((u8*)ptr - sizeof(AllocationHeader));
+
+    SDL_AtomicLock(&lock);
+    NameStats& s = stats[header->nameIndex];
+    s.liveBytes -= header->size;
+    s.liveCount -= 1;
+    liveBytes -= header->size;
+    SDL_AtomicUnlock(&lock);
+
+#if _WIN32
+    _aligned_free(header);
+#else
+    free(header);
+#endif
+}
+
+void TrackingAllocator::showDebugInfo()
+{
+    ImGui::Text("PhysX Memory: %.2fmb (%llu allocations)", liveBytes / (1024.0 * 1024.0),
+            (unsigned long long)totalCount);
+    if (ImGui::TreeNode("PhysX Allocations"))
+    {
+        SDL_AtomicLock(&lock);
+        NameStats sorted[MAX_NAMES];
+        u32 count = nameCount;
+        memcpy(sorted, stats, sizeof(NameStats) * count);
+        SDL_AtomicUnlock(&lock);
+
+        for (u32 i=1; i<count; ++i)
+        {
+            for (u32 j=i; j>0 && sorted[j].liveBytes > sorted[j-1].liveBytes; --j)
+            {
+                swap(sorted[j], sorted[j-1]);
+            }
+        }
+        for (u32 i=0; i<count; ++i)
+        {
+            ImGui::Text("%8.1fkb %6u live %8llu total  %s", sorted[i].liveBytes / 1024.0,
+                    sorted[i].liveCount, (unsigned long long)sorted[i].totalCount, sorted[i].name);
+        }
+        ImGui::TreePop();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "misc.h"
+
+// Allocator given to PhysX that keeps track of how much memory is live for each allocation name.
+// PhysX may allocate from its worker threads so the stats are guarded by a spin lock.
+class TrackingAllocator : public PxAllocatorCallback
+{
+    static constexpr u32 MAX_NAMES = 256;
+
+    struct NameStats
+    {
+        const char* name;
+        i64 liveBytes;
+        u32 liveCount;
+        u64 totalCount;
+    };
+
+    NameStats stats[MAX_NAMES];
+    u32 nameCount = 0;
+    SDL_SpinLock lock = 0;
+
+    i64 liveBytes = 0;
+    i64 peakBytes = 0;
+    u64 totalCount = 0;
+
+    u32 getNameIndex(const char* name);
+
+public:
+    void* allocate(size_t size, const char* typeName, const char* filename, int line) override;
+    void deallocate(void* ptr) override;
+
+    // starts measuring the highest amount of live memory from this point
+    void resetPeak()
+    {
+        SDL_AtomicLock(&lock);
+        peakBytes = liveBytes;
+        SDL_AtomicUnlock(&lock);
+    }
+
+    i64 getLiveBytes() const { return liveBytes; }
+    i64 getPeakBytes() const { return peakBytes; }
+    u64 getTotalCount() const { return totalCount; }
+
+    void showDebugInfo();
+};
@@ -0,0 +1,498 @@
+#include "projectile_system.h"
+#include "scene.h"
+#include "game.h"
+#include "renderer.h"
+#include "vehicle.h"
+#include "billboard.h"
+#include "imgui.h"
+
+void ProjectileSystem::setup(Scene* scene)
+{
+    this->scene = scene;
+    bulletMesh = g_res.getModel("misc")->getMeshByName("Bullet");
+
+    ProjectileTypeInfo& blaster = pools[BLASTER].info;
+    blaster.maxProjectiles = 512;
+    blaster.life = 3.f;
+    blaster.collisionRadius = 0.4f;
+    blaster.damage = 50;
+    blaster.upVectorDrop = 0.7f;
+    blaster.impactEmitter = ParticleEmitter(&scene->sparks, 5, 5,
+            Vec4(Vec3(0.04f, 1.f, 0.04f) * 2.f, 1.f), 0.5f, 6.f, 10.f);
+    blaster.environmentImpactSounds.push("blaster_hit");
+
+    ProjectileTypeInfo& phantom = pools[PHANTOM].info;
+    phantom.maxProjectiles = 512;
+    phantom.life = 2.5f;
+    phantom.passThroughVehicles = true;
+    phantom.collisionRadius = 0.4f;
+    phantom.damage = 50;
+    phantom.upVectorDrop = 0.7f;
+    phantom.impactEmitter = ParticleEmitter(&scene->sparks, 5, 5,
+            Vec4(Vec3(1.f, 0.02f, 0.95f) * 2.f, 1.f), 0.5f, 6.f, 10.f);
+    phantom.environmentImpactSounds.push("blaster_hit");
+
+    for (u32 type : { BULLET, BULLET_SMALL })
+    {
+        ProjectileTypeInfo& bullet = pools[type].info;
+        bullet.maxProjectiles = 4096;
+        bullet.life = 2.f;
+        bullet.collisionRadius = 0.1f;
+        bullet.damage = 11;
+        bullet.upVectorDrop = 1.f;
+        bullet.impactEmitter = ParticleEmitter(&scene->sparks, 1, 1,
+            Vec4(Vec3(1.f, 0.6f, 0.02f) * 2.f, 1.f), 0.5f, 6.f, 10.f);
+        bullet.environmentImpactSounds.push("richochet1");
+        bullet.environmentImpactSounds.push("richochet2");
+        bullet.environmentImpactSounds.push("richochet3");
+        bullet.environmentImpactSounds.push("richochet4");
+        bullet.vehicleImpactSounds.push("bullet_impact1");
+        bullet.vehicleImpactSounds.push("bullet_impact2");
+        bullet.vehicleImpactSounds.push("bullet_impact3");
+    }
+
+    ProjectileTypeInfo& missile = pools[MISSILE].info;
+    missile.maxProjectiles = 256;
+    missile.life = 4.f;
+    missile.groundFollow = true;
+    missile.collisionRadius = 0.5f;
+    missile.damage = 120;
+    missile.accel = 14.f;
+    missile.maxSpeed = 110.f;
+    missile.explosionStrength = 5.f;
+    missile.environmentImpactSounds.push("explosion1");
+    missile.vehicleImpactSounds.push("explosion1");
+
+    ProjectileTypeInfo& homingMissile = pools[HOMING_MISSILE].info;
+    homingMissile.maxProjectiles = 256;
+    homingMissile.life = 4.25f;
+    homingMissile.groundFollow = true;
+    homingMissile.collisionRadius = 0.5f;
+    homingMissile.damage = 150;
+    homingMissile.accel = 20.f;
+    homingMissile.homingSpeed = 85.f;
+    homingMissile.maxSpeed = 100.f;
+    homingMissile.explosionStrength = 6.f;
+    homingMissile.environmentImpactSounds.push("explosion1");
+    homingMissile.vehicleImpactSounds.push("explosion1");
+
+    ProjectileTypeInfo& bouncer = pools[BOUNCER].info;
+    bouncer.maxProjectiles = 256;
+    bouncer.life = 4.f;
+    bouncer.groundFollow = true;
+    bouncer.collisionRadius = 0.6f;
+    bouncer.damage = 75;
+    bouncer.bounceOffEnvironment = true;
+    bouncer.impactEmitter = ParticleEmitter(&scene->sparks, 5, 5,
+            Vec4(Vec3(0.3f, 0.3f, 1.f) * 2.f, 1.f), 0.5f, 6.f, 10.f);
+    bouncer.environmentImpactSounds.push("bouncer_bounce");
+
+    for (auto& pool : pools)
+    {
+        u32 maxProjectiles = pool.info.maxProjectiles;
+        pool.position.reserve(maxProjectiles);
+        pool.velocity.reserve(maxProjectiles);
+        pool.upVector.reserve(maxProjectiles);
+        pool.life.reserve(maxProjectiles);
+        pool.instigator.reserve(maxProjectiles);
+        pool.sweepQuery.reserve(maxProjectiles);
+        pool.ignoreActors.reserve(maxProjectiles);
+    }
+}
+
+void ProjectileSystem::spawn(Vec3 const& position, Vec3 const& velocity, Vec3 const& upVector,
+        u32 instigator, ProjectileType projectileType)
+{
+    ProjectilePool& pool = pools[projectileType];
+    if (pool.size() == pool.info.maxProjectiles)
+    {
+        ++droppedCount;
+        return;
+    }
+
+    pool.position.push(position);
+    pool.velocity.push(velocity - upVector * pool.info.upVectorDrop);
+    pool.upVector.push(upVector);
+    pool.life.push(pool.info.life);
+    pool.instigator.push(instigator);
+    pool.sweepQuery.push({});
+    IgnoreActors ignoreActors;
+    ignoreActors.actors[0] = scene->getVehicle(instigator)->getRigidBody();
+    ignoreActors.count = 1;
+    pool.ignoreActors.push(ignoreActors);
+}
+
+void ProjectileSystem::remove(ProjectilePool& pool, u32 index)
+{
+    u32 last = pool.size() - 1;
+    if (index != last)
+    {
+        pool.position[index] = pool.position[last];
+        pool.velocity[index] = pool.velocity[last];
+        pool.upVector[index] = pool.upVector[last];
+        pool.life[index] = pool.life[last];
+        pool.instigator[index] = pool.instigator[last];
+        pool.sweepQuery[index] = pool.sweepQuery[last];
+        pool.ignoreActors[index] = pool.ignoreActors[last];
+    }
+    pool.position.pop();
+    pool.velocity.pop();
+    pool.upVector.pop();
+    pool.life.pop();
+    pool.instigator.pop();
+    pool.sweepQuery.pop();
+    pool.ignoreActors.pop();
+}
+
+void ProjectileSystem::clear()
+{
+    for (auto& pool : pools)
+    {
+        pool.position.clear();
+        pool.velocity.clear();
+        pool.upVector.clear();
+        pool.life.clear();
+        pool.instigator.clear();
+        pool.sweepQuery.clear();
+        pool.ignoreActors.clear();
+    }
+}
+
+u32 ProjectileSystem::getProjectileCount() const
+{
+    u32 count = 0;
+    for (auto& pool : pools)
+    {
+        count += pool.size();
+    }
+    return count;
+}
+
+// the query filter data identifies the projectile that queued the sweep
+PxQueryHitType::Enum ProjectileSystem::preFilter(const PxFilterData& filterData,
+        const PxShape* shape, const PxRigidActor* actor, PxHitFlags& queryFlags)
+{
+    ProjectilePool const& pool = pools[filterData.word2 >> 16];
+    IgnoreActors const& ignoreActors = pool.ignoreActors[filterData.word2 & 0xFFFF];
+    for (u32 i=0; i<ignoreActors.count; ++i)
+    {
+        if (ignoreActors.actors[i] == actor)
+        {
+            return PxQueryHitType::eNONE;
+        }
+    }
+    ActorUserData* userData = (ActorUserData*)actor->userData;
+    if (userData && userData->entityType == ActorUserData::VEHICLE)
+    {
+        if (ignoreActors.count == MAX_IGNORE_ACTORS)
+        {
+            return PxQueryHitType::eBLOCK;
+        }
+        return pool.info.passThroughVehicles ? PxQueryHitType::eTOUCH : PxQueryHitType::eBLOCK;
+    }
+    return PxQueryHitType::eBLOCK;
+}
+
+void ProjectileSystem::update(f32 deltaTime)
+{
+    TIMED_BLOCK();
+
+    f64 startTime = getTime();
+    QueryBatch& queryBatch = scene->getQueryBatch();
+
+    for (u32 type=0; type<MAX_PROJECTILE_TYPES; ++type)
+    {
+        ProjectilePool& pool = pools[type];
+        ProjectileTypeInfo const& info = pool.info;
+        // only projectiles that pass through vehicles get touches, and the filter blocks once the
+        // ignore list is full
+        u32 maxTouches = info.passThroughVehicles
+            ? min(MAX_IGNORE_ACTORS, QueryBatch::MAX_TOUCHES_PER_QUERY) : 0;
+
+        // removed projectiles are replaced by the last projectile, so projectiles that have
+        // already queued a sweep this update never move
+        for (u32 i=0; i<pool.size();)
+        {
+            // handle the hits from the sweep that was queued last update
+            bool destroyed = false;
+            if (SweepResult const* hit = queryBatch.getSweepResult(pool.sweepQuery[i]))
+            {
+                IgnoreActors& ignoreActors = pool.ignoreActors[i];
+                for (u32 j=0; j<hit->nbTouches && !destroyed; ++j)
+                {
+                    destroyed = onHit(pool, i, &hit->touches[j]);
+                    if (ignoreActors.count < MAX_IGNORE_ACTORS)
+                    {
+                        ignoreActors.actors[ignoreActors.count++] = hit->touches[j].actor;
+                    }
+                }
+                if (hit->hasBlock && !destroyed)
+                {
+                    PxSweepHit block = hit->block;
+                    destroyed = onHit(pool, i, &block);
+                }
+            }
+
+            if (destroyed)
+            {
+                remove(pool, i);
+                continue;
+            }
+
+            Vec3& position = pool.position[i];
+            Vec3& velocity = pool.velocity[i];
+            f32& life = pool.life[i];
+
+            if (life <= 0.f)
+            {
+                pool.info.impactEmitter.emit(position, Vec3(0, 0, 1));
+                remove(pool, i);
+                continue;
+            }
+
+            Vec3 prevPosition = position;
+
+            if (info.groundFollow)
+            {
+                f32 speed = length(velocity);
+                PxRaycastBuffer rayHit;
+                f32 dist = 1.4f;
+                velocity.z -= deltaTime * 15.f;
+                if (scene->raycastStatic(position, { 0, 0, -1 }, 4.f, &rayHit))
+                {
+                    velocity.z -= deltaTime * 20.f;
+                    if (rayHit.block.distance <= dist)
+                    {
+                        f32 compression = (dist - rayHit.block.distance) / dist;
+                        velocity.z += compression * 400.f * deltaTime;
+                        velocity.z = smoothMove(velocity.z, 0.f, 8.f, deltaTime);
+                        f32 velAgainstHit = dot(-velocity, convert(rayHit.block.normal));
+                        if (velAgainstHit > 0.f)
+                        {
+                            velocity += convert(rayHit.block.normal) *
+                                min(velAgainstHit * deltaTime * 20.f, velAgainstHit);
+                        }
+                        velocity = normalize(velocity) * min(speed + info.accel * deltaTime, info.maxSpeed);
+                    }
+                }
+            }
+
+            if (info.homingSpeed > 0.f)
+            {
+                f32 lowestTargetPriority = FLT_MAX;
+                Vec3 targetPosition;
+                for (auto& v : scene->getVehicles())
+                {
+                    if (v->vehicleIndex == pool.instigator[i])
+                    {
+                        continue;
+                    }
+
+                    Vec3 dir = normalize(velocity);
+                    Vec3 diff = v->getPosition() - position;
+                    f32 vDot = dot(dir, normalize(diff));
+                    f32 targetPriority = lengthSquared(diff);
+                    if (vDot > 0.25f && targetPriority < lowestTargetPriority)
+                    {
+                        targetPosition = v->getPosition();
+                        lowestTargetPriority = targetPriority;
+                    }
+                }
+
+                if (lowestTargetPriority != FLT_MAX)
+                {
+                    f32 speed = length(velocity);
+                    velocity += normalize(targetPosition - position) * (info.homingSpeed * deltaTime);
+                    velocity = normalize(velocity) * speed;
+                }
+            }
+
+            position += velocity * deltaTime;
+
+            if (type == MISSILE || type == HOMING_MISSILE)
+            {
+                // TODO: play sound while missile is traveling
+                if (((u32)(life * 100.f) & 1) == 0)
+                {
+                    scene->smoke.spawn(position, Vec3(0,0,1), 0.8f,
+                            Vec4(Vec3(0.6f), 1.f), 1.75f);
+                }
+            }
+
+            // the sweep is run with the rest of the batched queries and the hits are handled on
+            // the next update
+            Vec3 sweepDir = normalize(position - prevPosition);
+            pool.sweepQuery[i] = queryBatch.sweep(info.collisionRadius, prevPosition, sweepDir,
+                    length(position - prevPosition), nullptr, COLLISION_FLAG_CHASSIS |
+                    COLLISION_FLAG_TRACK | COLLISION_FLAG_TERRAIN | COLLISION_FLAG_OBJECT, this,
+                    (type << 16) | i, maxTouches);
+
+            life -= deltaTime;
+            ++i;
+        }
+    }
+
+    lastUpdateTime = getTime() - startTime;
+}
+
+bool ProjectileSystem::onHit(ProjectilePool& pool, u32 index, PxSweepHit* hit)
+{
+    ProjectileTypeInfo& info = pool.info;
+    ActorUserData* data = (ActorUserData*)hit->actor->userData;
+    Vec3 hitPos = convert(hit->position);
+
+    info.impactEmitter.emit(hitPos, convert(hit->normal));
+
+    if (info.explosionStrength > 0.f)
+    {
+        scene->createExplosion(hitPos, pool.velocity[index] * 0.5f, info.explosionStrength);
+    }
+
+    // hit vehicle
+    if (data && data->entityType == ActorUserData::VEHICLE)
+    {
+        data->vehicle->applyDamage((f32)info.damage, pool.instigator[index]);
+
+        if (!info.vehicleImpactSounds.empty())
+        {
+            u32 soundIndex = irandom(scene->randomSeries, 0, info.vehicleImpactSounds.size());
+            g_audio.playSound3D(g_res.getSound(info.vehicleImpactSounds[soundIndex]),
+                    SoundType::GAME_SFX, hitPos, false, 0.9f,
+                    random(scene->randomSeries, 0.75f, 0.9f));
+        }
+
+        return !info.passThroughVehicles;
+    }
+
+    // hit something else
+    if (!info.environmentImpactSounds.empty())
+    {
+        u32 soundIndex = irandom(scene->randomSeries, 0, info.environmentImpactSounds.size());
+        g_audio.playSound3D(g_res.getSound(info.environmentImpactSounds[soundIndex]),
+                SoundType::GAME_SFX, hitPos, false, 0.9f,
+                random(scene->randomSeries, 0.75f, 0.9f));
+    }
+
+    if (info.bounceOffEnvironment)
+    {
+        Vec3 n = convert(hit->normal);
+        Vec3& velocity = pool.velocity[index];
+        velocity = -2.f * dot(velocity, n) * n + velocity;
+        pool.position[index] = convert(hit->position) + n * (info.collisionRadius + 0.001f);
+        return false;
+    }
+
+    return true;
+}
+
+void ProjectileSystem::render(RenderWorld* rw)
+{
+    for (u32 type=0; type<MAX_PROJECTILE_TYPES; ++type)
+    {
+        ProjectilePool& pool = pools[type];
+        for (u32 i=0; i<pool.size(); ++i)
+        {
+            Vec3 const& position = pool.position[i];
+            Mat4 m = Mat4::faceDirection(normalize(pool.velocity[i]), pool.upVector[i]);
+
+            switch (type)
+            {
+                case BLASTER:
+                {
+                    Mat4 transform = Mat4::translation(position) * m * Mat4::scaling(Vec3(0.75f));
+                    drawSimple(rw, bulletMesh, &g_res.white, transform,
+                        Vec3(0.2f, 0.9f, 0.2f), Vec3(0.01f, 1.5f, 0.01f));
+                    drawBillboard(rw, g_res.getTexture("flare"), position+Vec3(0,0,0.2f),
+                            {0.01f,1.f,0.01f,0.2f}, 1.5f, 0.f, false);
+                    rw->addPointLight(position, Vec3(0.2f, 0.9f, 0.2f) * 2.f, 4.f, 2.f);
+                } break;
+                case BULLET:
+                {
+                    Vec3 color = Vec3(1.f, 0.5f, 0.01f);
+                    Vec3 emit = Vec3(1.f, 0.5f, 0.01f) * 2.f;
+                    Mat4 transform = Mat4::translation(position) * m * Mat4::scaling(Vec3(0.35f));
+                    drawSimple(rw, bulletMesh, &g_res.white, transform, color, emit);
+                    drawBillboard(rw, g_res.getTexture("flare"),
+                                position, Vec4(emit, 0.8f), 0.75f, 0.f, false);
+                    rw->addPointLight(position, color * 2.f, 4.f, 2.f);
+                } break;
+                case BULLET_SMALL:
+                {
+                    Vec3 color = Vec3(1.f, 0.5f, 0.01f);
+                    Vec3 emit = Vec3(1.f, 0.5f, 0.01f) * 2.f;
+                    Mat4 transform = Mat4::translation(position) * m * Mat4::scaling(Vec3(0.35f));
+                    drawSimple(rw, bulletMesh, &g_res.white, transform, color, emit);
+                    drawBillboard(rw, g_res.getTexture("flare"),
+                                position, Vec4(emit, 0.8f), 0.5f, 0.f, false);
+                } break;
+                case MISSILE:
+                {
+                    Mesh* mesh = g_res.getModel("weapon_missile")->getMeshByName("missile.Missile");
+                    Mat4 transform = Mat4::translation(position) * m;
+                    drawSimple(rw, mesh, &g_res.white, transform, Vec3(1.f));
+                    drawBillboard(rw, g_res.getTexture("flare"), position,
+                                Vec4(1.f, 0.5f, 0.03f, 0.8f), 1.8f, 0.f, false);
+                    rw->addPointLight(position, Vec3(1.f, 0.5f, 0.03f) * 5.f, 5.f, 2.f);
+                } break;
+                case HOMING_MISSILE:
+                {
+                    Mesh* mesh = g_res.getModel("weapon_missile")->getMeshByName("missile.Missile");
+                    Mat4 transform = Mat4::translation(position) * m;
+                    drawSimple(rw, mesh, &g_res.white, transform, Vec3(1.f));
+                    drawBillboard(rw, g_res.getTexture("flare"), position,
+                                Vec4(1.f, 0.2f, 0.03f, 0.8f), 1.8f, 0.f, false);
+                    rw->addPointLight(position, Vec3(1.f, 0.2f, 0.03f) * 5.f, 5.f, 2.f);
+                } break;
+                case BOUNCER:
+                {
+                    Mesh* mesh = g_res.getModel("misc")->getMeshByName("Sphere");
+                    Mat4 transform = Mat4::translation(position) * Mat4::scaling(Vec3(0.4f));
+                    drawSimple(rw, mesh, &g_res.white, transform, Vec3(1.f), Vec3(0.5f));
+                    drawBillboard(rw, g_res.getTexture("flare"), position,
+                                Vec4(0.1f, 0.12f, 1.f, 0.8f), 1.75f, 0.f, false);
+                    rw->addPointLight(position, Vec3(0.1f, 0.15f, 1.f) * 7.f, 6.5f, 2.f);
+                } break;
+                case PHANTOM:
+                {
+                    Vec3 color = Vec3(1.f, 0.01f, 0.95f);
+                    Vec3 emit = Vec3(1.f, 0.01f, 0.95f) * 1.5f;
+                    Mat4 transform = Mat4::translation(position) * m * Mat4::scaling(Vec3(0.75f));
+                    drawSimple(rw, bulletMesh, &g_res.white, transform, color, emit);
+                    drawBillboard(rw, g_res.getTexture("flare"),
+                            position+Vec3(0,0,0.2f), Vec4(color, 0.4f), 1.5f, 0.f, false);
+                    rw->addPointLight(position, color * 2.f, 4.f, 2.f);
+                } break;
+            }
+        }
+    }
+}
+
+void ProjectileSystem::showDebugInfo()
+{
+    if (ImGui::TreeNode("Projectiles"))
+    {
+        ImGui::Text("Active: %u", getProjectileCount());
+        ImGui::Text("Dropped: %u", droppedCount);
+        ImGui::Text("Update Time: %.3fms", lastUpdateTime * 1000.0);
+
+        // fires a few thousand rounds in every direction from each vehicle
+        if (ImGui::Button("Stress Test") && scene->getVehicles().size() > 0)
+        {
+            const u32 roundsPerVehicle = 4000 / scene->getVehicles().size();
+            for (auto& v : scene->getVehicles())
+            {
+                for (u32 i=0; i<roundsPerVehicle; ++i)
+                {
+                    Vec3 dir = normalize(Vec3(
+                            random(scene->randomSeries, -1.f, 1.f),
+                            random(scene->randomSeries, -1.f, 1.f),
+                            random(scene->randomSeries, -0.1f, 0.3f)));
+                    spawn(v->getPosition() + Vec3(0, 0, 2.f), dir * 90.f, Vec3(0, 0, 1),
+                            v->vehicleIndex, BULLET);
+                }
+            }
+        }
+
+        ImGui::TreePop();
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "math.h"
+#include "entity.h"
+#include "resources.h"
+#include "particle_system.h"
+#include "query_batch.h"
+
+// Simulates all of the projectiles in a scene. Projectiles are stored in contiguous arrays grouped
+// by type and the arrays are allocated up front so spawning and removing projectiles never
+// allocates. Each projectile queues a sweep on the scene's QueryBatch and the hits are handled on
+// the next update.
+class ProjectileSystem : public PxQueryFilterCallback
+{
+public:
+    enum ProjectileType
+    {
+        BLASTER,
+        BULLET,
+        BULLET_SMALL,
+        MISSILE,
+        HOMING_MISSILE,
+        BOUNCER,
+        PHANTOM,
+        MAX_PROJECTILE_TYPES
+    };
+
+    static constexpr u32 MAX_IGNORE_ACTORS = 8;
+
+private:
+    struct ProjectileTypeInfo
+    {
+        u32 maxProjectiles;
+        f32 life;
+        f32 collisionRadius;
+        u32 damage;
+        f32 upVectorDrop = 0.f;
+        f32 accel = 0.f;
+        f32 maxSpeed = 100.f;
+        f32 homingSpeed = 0.f;
+        f32 explosionStrength = 0.f;
+        bool groundFollow = false;
+        bool passThroughVehicles = false;
+        bool bounceOffEnvironment = false;
+        ParticleEmitter impactEmitter;
+        SmallArray<const char*, 4> environmentImpactSounds;
+        SmallArray<const char*, 4> vehicleImpactSounds;
+    };
+
+    struct IgnoreActors
+    {
+        const PxRigidActor* actors[MAX_IGNORE_ACTORS];
+        u32 count;
+    };
+
+    struct ProjectilePool
+    {
+        ProjectileTypeInfo info;
+        Array<Vec3> position;
+        Array<Vec3> velocity;
+        Array<Vec3> upVector;
+        Array<f32> life;
+        Array<u32> instigator;
+        Array<QueryHandle> sweepQuery;
+        Array<IgnoreActors> ignoreActors;
+
+        u32 size() const { return position.size(); }
+    };
+
+    ProjectilePool pools[MAX_PROJECTILE_TYPES];
+    class Scene* scene = nullptr;
+    Mesh* bulletMesh = nullptr;
+
+    u32 droppedCount = 0;
+    f64 lastUpdateTime = 0.0;
+
+    PxQueryHitType::Enum preFilter(const PxFilterData& filterData, const PxShape* shape,
+            const PxRigidActor* actor, PxHitFlags& queryFlags) override;
+
+    // not used
+    PxQueryHitType::Enum postFilter(const PxFilterData& filterData, const PxQueryHit& hit) override
+    {
+        return PxQueryHitType::eBLOCK;
+    }
+
+    // returns true if the projectile was destroyed by the hit
+    bool onHit(ProjectilePool& pool, u32 index, PxSweepHit* hit);
+    void remove(ProjectilePool& pool, u32 index);
+
+public:
+    void setup(class Scene* scene);
+    void spawn(Vec3 const& position, Vec3 const& velocity, Vec3 const& upVector,
+            u32 instigator, ProjectileType projectileType);
+    void update(f32 deltaTime);
+    void render(class RenderWorld* rw);
+    void clear();
+
+    u32 getProjectileCount() const;
+    void showDebugInfo();
+};
@@ -0,0 +1,117 @@
+#include "query_batch.h"
+#include "threadpool.h"
+
+QueryHandle QueryBatch::sweep(f32 radius, Vec3 const& from, Vec3 const& dir, f32 dist,
+        PxRigidActor* ignore, u32 flags, PxQueryFilterCallback* filterCallback, u32 filterUserData,
+        u32 maxTouches)
+{
+    u32 touchOffset = pendingTouchCount;
+    if (!filterCallback)
+    {
+        maxTouches = 0;
+    }
+    pendingTouchCount += maxTouches;
+    pendingSweeps.push({ from, dir, dist, radius, flags, ignore, filterCallback, filterUserData,
+            touchOffset, maxTouches });
+    return { pendingSweeps.size() - 1, pendingBatchIndex };
+}
+
+QueryHandle QueryBatch::raycast(Vec3 const& from, Vec3 const& dir, f32 dist,
+        PxRigidActor* ignore, u32 flags)
+{
+    pendingRaycasts.push({ from, dir, dist, flags, ignore, false });
+    return { pendingRaycasts.size() - 1, pendingBatchIndex };
+}
+
+QueryHandle QueryBatch::raycastStatic(Vec3 const& from, Vec3 const& dir, f32 dist, u32 flags)
+{
+    pendingRaycasts.push({ from, dir, dist, flags, nullptr, true });
+    return { pendingRaycasts.size() - 1, pendingBatchIndex };
+}
+
+void QueryBatch::execute(PxScene* scene)
+{
+    TIMED_BLOCK();
+
+    f64 startTime = getTime();
+
+    sweeps.clear();
+    raycasts.clear();
+    swap(sweeps, pendingSweeps);
+    swap(raycasts, pendingRaycasts);
+    sweepResults.resize(sweeps.size());
+    raycastResults.resize(raycasts.size());
+    touchHits.resize(pendingTouchCount);
+    pendingTouchCount = 0;
+
+    // sweeps and raycasts share the same index space so they can be split across the same tasks
+    u32 sweepCount = sweeps.size();
+    u32 totalCount = sweeps.size() + raycasts.size();
+    g_threadPool.parallelFor(totalCount, QUERIES_PER_TASK, [&](u32 begin, u32 end) {
+        for (u32 i=begin; i<end; ++i)
+        {
+            if (i < sweepCount)
+            {
+                SweepQuery const& q = sweeps[i];
+                SweepResult& result = sweepResults[i];
+                PxQueryFilterData filter;
+                filter.flags |= PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC;
+                filter.data = PxFilterData(q.flags, 0, q.filterUserData, 0);
+                IgnoreActor ignoreActor(q.ignore);
+                PxQueryFilterCallback* cb = q.filterCallback ? q.filterCallback : &ignoreActor;
+                if (q.filterCallback || q.ignore)
+                {
+                    filter.flags |= PxQueryFlag::ePREFILTER;
+                }
+                PxSweepHit* touches = q.maxTouches > 0 ? touchHits.data() + q.touchOffset : nullptr;
+                PxSweepBuffer hit(touches, q.maxTouches);
+                PxTransform initialPose(convert(q.from), PxQuat(PxIdentity));
+                scene->sweep(PxSphereGeometry(q.radius), initialPose, convert(q.dir), q.dist,
+                        hit, PxHitFlags(PxHitFlag::eDEFAULT), filter, cb);
+                result.hasBlock = hit.hasBlock;
+                result.block = hit.block;
+                result.touches = touches;
+                result.nbTouches = hit.nbTouches;
+            }
+            else
+            {
+                RaycastQuery const& q = raycasts[i - sweepCount];
+                RaycastResult& result = raycastResults[i - sweepCount];
+                PxQueryFilterData filter;
+                filter.flags |= PxQueryFlag::eSTATIC;
+                if (!q.staticOnly)
+                {
+                    filter.flags |= PxQueryFlag::eDYNAMIC;
+                }
+                if (q.ignore)
+                {
+                    filter.flags |= PxQueryFlag::ePREFILTER;
+                }
+                IgnoreActor ignoreActor(q.ignore);
+                filter.data = PxFilterData(q.flags, 0, 0, 0);
+                PxRaycastBuffer hit;
+                scene->raycast(convert(q.from), convert(q.dir), q.dist, hit,
+                        PxHitFlags(PxHitFlag::eDEFAULT), filter, &ignoreActor);
+                result.hasBlock = hit.hasBlock;
+                result.block = hit.block;
+            }
+        }
+    });
+
+    executedBatchIndex = pendingBatchIndex;
+    ++pendingBatchIndex;
+
+    lastQueryCount = totalCount;
+    lastQueryTime = getTime() - startTime;
+}
+
+void QueryBatch::clear()
+{
+    pendingSweeps.clear();
+    pendingRaycasts.clear();
+    pendingTouchCount = 0;
+    sweepResults.clear();
+    raycastResults.clear();
+    executedBatchIndex = pendingBatchIndex;
+    ++pendingBatchIndex;
+}
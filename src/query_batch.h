@@ -0,0 +1,117 @@
+#pragma once
+
+#include "math.h"
+#include "collision_flags.h"
+
+// Handle to a query that was added to a QueryBatch. The result can be retrieved after the batch
+// is executed, and it stays valid until the batch is executed again.
+struct QueryHandle
+{
+    u32 index = 0;
+    u32 batchIndex = 0;
+};
+
+struct SweepResult
+{
+    bool hasBlock = false;
+    PxSweepHit block;
+    PxSweepHit* touches = nullptr;
+    u32 nbTouches = 0;
+};
+
+struct RaycastResult
+{
+    bool hasBlock = false;
+    PxRaycastHit block;
+};
+
+// Collects sweeps and raycasts during the update and runs them all at once, split across the
+// worker threads. The results are available for the next update.
+class QueryBatch
+{
+public:
+    static constexpr u32 MAX_TOUCHES_PER_QUERY = 8;
+    static constexpr u32 QUERIES_PER_TASK = 16;
+
+private:
+    struct SweepQuery
+    {
+        Vec3 from;
+        Vec3 dir;
+        f32 dist;
+        f32 radius;
+        u32 flags;
+        PxRigidActor* ignore;
+        PxQueryFilterCallback* filterCallback;
+        u32 filterUserData;
+        u32 touchOffset;
+        u32 maxTouches;
+    };
+
+    struct RaycastQuery
+    {
+        Vec3 from;
+        Vec3 dir;
+        f32 dist;
+        u32 flags;
+        PxRigidActor* ignore;
+        bool staticOnly;
+    };
+
+    Array<SweepQuery> pendingSweeps;
+    Array<RaycastQuery> pendingRaycasts;
+    u32 pendingTouchCount = 0;
+
+    Array<SweepQuery> sweeps;
+    Array<RaycastQuery> raycasts;
+    Array<SweepResult> sweepResults;
+    Array<RaycastResult> raycastResults;
+    Array<PxSweepHit> touchHits;
+
+    // starts at 1 so that a default constructed handle is never valid
+    u32 executedBatchIndex = 0;
+    u32 pendingBatchIndex = 1;
+
+    u32 lastQueryCount = 0;
+    f64 lastQueryTime = 0.0;
+
+public:
+    // The filter callback (if any) must be safe to call from multiple threads and must remain
+    // valid until the batch is executed. Touches are only reported if a filter callback that
+    // returns eTOUCH is provided, and at most maxTouches are kept. The filter user data is passed to
+    // the callback in word2 of the query filter data.
+    QueryHandle sweep(f32 radius, Vec3 const& from, Vec3 const& dir, f32 dist,
+            PxRigidActor* ignore=nullptr,
+            u32 flags=COLLISION_FLAG_TERRAIN | COLLISION_FLAG_OBJECT | COLLISION_FLAG_CHASSIS,
+            PxQueryFilterCallback* filterCallback=nullptr, u32 filterUserData=0,
+            u32 maxTouches=MAX_TOUCHES_PER_QUERY);
+    QueryHandle raycast(Vec3 const& from, Vec3 const& dir, f32 dist, PxRigidActor* ignore=nullptr,
+            u32 flags=COLLISION_FLAG_TERRAIN | COLLISION_FLAG_OBJECT
+                | COLLISION_FLAG_CHASSIS | COLLISION_FLAG_DYNAMIC);
+    QueryHandle raycastStatic(Vec3 const& from, Vec3 const& dir, f32 dist,
+            u32 flags=COLLISION_FLAG_TERRAIN | COLLISION_FLAG_OBJECT | COLLISION_FLAG_TRACK);
+
+    // returns null if the query was not part of the last executed batch
+    SweepResult const* getSweepResult(QueryHandle handle) const
+    {
+        if (handle.batchIndex != executedBatchIndex || handle.index >= sweepResults.size())
+        {
+            return nullptr;
+        }
+        return &sweepResults[handle.index];
+    }
+    RaycastResult const* getRaycastResult(QueryHandle handle) const
+    {
+        if (handle.batchIndex != executedBatchIndex || handle.index >= raycastResults.size())
+        {
+            return nullptr;
+        }
+        return &raycastResults[handle.index];
+    }
+
+    void execute(PxScene* scene);
+    void clear();
+
+    u32 getQueryCount() const { return lastQueryCount; }
+    f64 getQueryTime() const { return lastQueryTime; }
+};
@@ -0,0 +1,145 @@
+#include "render_queue.h"
+#include "imgui.h"
+
+u64 RenderQueue::makeSortKey(u32 pass, ShaderHandle shader, u32 stateKey, f32 distance, u8 stencil)
+{
+    assert(pass < RenderPass::MAX);
+    assert(shader < (1 << 12));
+
+    // non-linear so that there is more precision close to the camera
+    u64 depth = (u64)(min(sqrtf(distance * (1.f / 2000.f)), 1.f) * 65535.f);
+    u64 state = stateKey & 0xFFFFFF;
+
+    u64 key = ((u64)pass << 61) | ((u64)shader << 49) | ((u64)stencil << 1);
+    if (pass == RenderPass::SHADOW || pass == RenderPass::STATIC_SHADOW
+            || pass == RenderPass::DEPTH_PREPASS)
+    {
+        // front to back matters more than state changes when only depth is written
+        key |= (depth << 33) | (state << 9);
+    }
+    else
+    {
+        key |= (state << 25) | (depth << 9);
+    }
+    return key;
+}
+
+void RenderQueue::radixSort(SortKey* keys, SortKey* tmp, u32 count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    u32 histograms[8][256] = {};
+    for (u32 i=0; i<count; ++i)
+    {
+        u64 key = keys[i].key;
+        for (u32 b=0; b<8; ++b)
+        {
+            ++histograms[b][(key >> (b * 8)) & 0xFF];
+        }
+    }
+
+    SortKey* src = keys;
+    SortKey* dst = tmp;
+    for (u32 b=0; b<8; ++b)
+    {
+        u32 shift = b * 8;
+        u32* offsets = histograms[b];
+
+        // every key has the same value for this byte
+        if (offsets[(src[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        u32 offset = 0;
+        for (u32 j=0; j<256; ++j)
+        {
+            u32 c = offsets[j];
+            offsets[j] = offset;
+            offset += c;
+        }
+        for (u32 i=0; i<count; ++i)
+        {
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        swap(src, dst);
+    }
+
+    if (src != keys)
+    {
+        memcpy(keys, src, count * sizeof(SortKey));
+    }
+}
+
+void RenderQueue::sort(Vec3 const& viewPosition)
+{
+    u32 count = entries.size();
+    sortedCount = count;
+    keys.resize(count);
+    tmpKeys.resize(count);
+    for (u32 i=0; i<count; ++i)
+    {
+        Entry const& e = entries[i];
+        f32 distance = e.item.bounds.radius < 0.f ? 0.f
+            : max(length(e.item.bounds.center - viewPosition) - e.item.bounds.radius, 0.f);
+        keys[i] = {
+            makeSortKey(e.pass, e.shader, e.item.stateKey, distance, e.item.stencil), i };
+    }
+
+    radixSort(keys.data(), tmpKeys.data(), count);
+
+    u32 k = 0;
+    for (u32 pass=0; pass<=RenderPass::MAX; ++pass)
+    {
+        while (k < count && (keys[k].key >> 61) < pass)
+        {
+            ++k;
+        }
+        passBegin[pass] = k;
+    }
+    passBegin[RenderPass::MAX] = count;
+}
+
+void RenderQueue::showBenchmark()
+{
+    static f64 buildTime = 0.0;
+    static f64 radixSortTime = 0.0;
+    static f64 quickSortTime = 0.0;
+    const u32 ITEM_COUNT = 50000;
+
+    if (ImGui::Button("Render Queue Benchmark"))
+    {
+        RandomSeries series{ 1234 };
+        RenderQueue queue;
+
+        f64 t = getTime();
+        for (u32 i=0; i<ITEM_COUNT; ++i)
+        {
+            RenderItem item = { nullptr, nullptr, (u8)irandom(series, 0, 4) };
+            item.bounds = { Vec3(random(series, -500.f, 500.f), random(series, -500.f, 500.f),
+                    random(series, 0.f, 50.f)), random(series, 0.5f, 10.f) };
+            item.stateKey = makeStateKey(irandom(series, 1, 200), irandom(series, 1, 2000));
+            queue.push(irandom(series, 0, RenderPass::MAX), irandom(series, 0, 64), item);
+        }
+        buildTime = getTime() - t;
+
+        t = getTime();
+        queue.sort(Vec3(0.f));
+        radixSortTime = getTime() - t;
+
+        // same keys sorted with a comparison sort for reference
+        Array<SortKey> keys = queue.keys;
+        for (u32 i=0; i<keys.size(); ++i)
+        {
+            swap(keys[i], keys[irandom(series, 0, keys.size())]);
+        }
+        t = getTime();
+        keys.sort([](SortKey const& a, SortKey const& b) { return a.key < b.key; });
+        quickSortTime = getTime() - t;
+    }
+    ImGui::Text("%uk items: build %.3fms, radix sort %.3fms, quick sort %.3fms",
+            ITEM_COUNT / 1000, buildTime * 1000.0, radixSortTime * 1000.0, quickSortTime * 1000.0);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "misc.h"
+#include "gl.h"
+#include "bounding_box.h"
+
+struct RenderItem
+{
+    void* renderData;
+    void (*render)(void*);
+    u8 stencil = 0;
+    BoundingSphere bounds;
+    // items with the same state key are drawn next to each other, see makeStateKey()
+    u32 stateKey = 0;
+};
+
+// The state key only orders items to reduce redundant binds, it never affects what is drawn, so
+// it is fine for unrelated items to share a key. There are 24 bits for it in the sort key, so
+// only the low 12 bits of each GL name are used; names above 4095 alias lower ones and just cost
+// extra binds. Material parameters come from the draw data buffer and don't need to be in the
+// key, only the objects that the render callbacks bind do. The normal map is left out because
+// it nearly always goes with the same color texture.
+inline u32 makeStateKey(GLuint texture, GLuint vao)
+{
+    return ((texture & 0xFFF) << 12) | (vao & 0xFFF);
+}
+
+namespace RenderPass
+{
+    enum
+    {
+        SHADOW,
+        STATIC_SHADOW,
+        DEPTH_PREPASS,
+        OPAQUE_COLOR,
+        PICK,
+        MAX
+    };
+};
+
+// Texture and vertex array binds made by the callbacks of items in a RenderQueue go through
+// these so that binding the same thing twice in a row is skipped. Everything else binds
+// directly, so the cache is reset before each pass.
+struct BindCache
+{
+    GLuint textures[16];
+    GLuint vao;
+    u32 bindCount = 0;
+    u32 skippedCount = 0;
+};
+
+BindCache g_bindCache;
+
+inline void resetBindCache()
+{
+    for (auto& t : g_bindCache.textures)
+    {
+        t = (GLuint)-1;
+    }
+    g_bindCache.vao = (GLuint)-1;
+}
+
+inline void bindTextureUnitCached(u32 unit, GLuint texture)
+{
+    assert(unit < ARRAY_SIZE(g_bindCache.textures));
+    if (g_bindCache.textures[unit] == texture)
+    {
+        ++g_bindCache.skippedCount;
+        return;
+    }
+    g_bindCache.textures[unit] = texture;
+    ++g_bindCache.bindCount;
+    glBindTextureUnit(unit, texture);
+}
+
+inline void bindVertexArrayCached(GLuint vao)
+{
+    if (g_bindCache.vao == vao)
+    {
+        ++g_bindCache.skippedCount;
+        return;
+    }
+    g_bindCache.vao = vao;
+    ++g_bindCache.bindCount;
+    glBindVertexArray(vao);
+}
+
+// Holds the opaque render items of every pass. Each frame the items get a 64 bit sort key made
+// from the pass, shader, state key, distance to the camera and stencil value, and are radix
+// sorted by it, so each pass is drawn in one run with as few state changes as possible.
+class RenderQueue
+{
+    struct Entry
+    {
+        RenderItem item;
+        ShaderHandle shader;
+        u32 pass;
+    };
+
+    struct SortKey
+    {
+        u64 key;
+        u32 index;
+    };
+
+    Array<Entry> entries;
+    Array<SortKey> keys;
+    Array<SortKey> tmpKeys;
+    u32 passBegin[RenderPass::MAX + 1] = {};
+    u32 sortedCount = 0;
+
+    static u64 makeSortKey(u32 pass, ShaderHandle shader, u32 stateKey, f32 distance, u8 stencil);
+    static void radixSort(SortKey* keys, SortKey* tmp, u32 count);
+
+public:
+    void push(u32 pass, ShaderHandle shader, RenderItem const& item)
+    {
+        entries.push({ item, shader, pass });
+    }
+    void clear() { entries.clear(); }
+    void sort(Vec3 const& viewPosition);
+    u32 size() const { return entries.size(); }
+    u32 getSortedCount() const { return sortedCount; }
+
+    // must be called after sort()
+    template <typename F>
+    void forEach(u32 pass, F const& callback) const
+    {
+        for (u32 i=passBegin[pass]; i<passBegin[pass + 1]; ++i)
+        {
+            Entry const& e = entries[keys[i].index];
+            callback(e.shader, e.item);
+        }
+    }
+
+    static void showBenchmark();
+};
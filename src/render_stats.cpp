@@ -0,0 +1,217 @@
+#include "render_stats.h"
+#include "imgui.h"
+#include "util.h"
+
+static const char* renderStatPassNames[RenderStatPass::MAX] = {
+    "Shadow",
+    "Depth Prepass",
+    "SSAO",
+    "Opaque Color",
+    "Transparent",
+    "Highlight",
+    "Overlay",
+    "Pick",
+    "Post Process",
+    "Fullscreen",
+    "2D",
+    "Other",
+};
+
+// Each hooked function calls the original function pointer after counting the call.
+#define COUNTED_GL_CALL(name, counter, params, args) \
+    static decltype(glad_##name) real_##name; \
+    static void APIENTRY counted_##name params \
+    { \
+        ++g_renderStats.current().counter; \
+        real_##name args; \
+    }
+
+COUNTED_GL_CALL(glUseProgram, programBinds, (GLuint p), (p))
+COUNTED_GL_CALL(glBindTexture, textureBinds, (GLenum t, GLuint tex), (t, tex))
+COUNTED_GL_CALL(glBindTextureUnit, textureBinds, (GLuint u, GLuint tex), (u, tex))
+COUNTED_GL_CALL(glBindVertexArray, vaoBinds, (GLuint v), (v))
+COUNTED_GL_CALL(glUniform1f, uniformUpdates, (GLint l, GLfloat a), (l, a))
+COUNTED_GL_CALL(glUniform1i, uniformUpdates, (GLint l, GLint a), (l, a))
+COUNTED_GL_CALL(glUniform1ui, uniformUpdates, (GLint l, GLuint a), (l, a))
+COUNTED_GL_CALL(glUniform2f, uniformUpdates, (GLint l, GLfloat a, GLfloat b), (l, a, b))
+COUNTED_GL_CALL(glUniform2i, uniformUpdates, (GLint l, GLint a, GLint b), (l, a, b))
+COUNTED_GL_CALL(glUniform3f, uniformUpdates, (GLint l, GLfloat a, GLfloat b, GLfloat c), (l, a, b, c))
+COUNTED_GL_CALL(glUniform4f, uniformUpdates,
+        (GLint l, GLfloat a, GLfloat b, GLfloat c, GLfloat d), (l, a, b, c, d))
+COUNTED_GL_CALL(glUniform2fv, uniformUpdates, (GLint l, GLsizei n, const GLfloat* v), (l, n, v))
+COUNTED_GL_CALL(glUniform3fv, uniformUpdates, (GLint l, GLsizei n, const GLfloat* v), (l, n, v))
+COUNTED_GL_CALL(glUniform4fv, uniformUpdates, (GLint l, GLsizei n, const GLfloat* v), (l, n, v))
+COUNTED_GL_CALL(glUniformMatrix3fv, uniformUpdates,
+        (GLint l, GLsizei n, GLboolean t, const GLfloat* v), (l, n, t, v))
+COUNTED_GL_CALL(glUniformMatrix4fv, uniformUpdates,
+        (GLint l, GLsizei n, GLboolean t, const GLfloat* v), (l, n, t, v))
+
+static decltype(glad_glDrawArrays) real_glDrawArrays;
+static void APIENTRY counted_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    g_renderStats.addDraw(mode, count);
+    real_glDrawArrays(mode, first, count);
+}
+
+static decltype(glad_glDrawArraysInstanced) real_glDrawArraysInstanced;
+static void APIENTRY counted_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+        GLsizei instanceCount)
+{
+    g_renderStats.addDraw(mode, count, instanceCount);
+    real_glDrawArraysInstanced(mode, first, count, instanceCount);
+}
+
+static decltype(glad_glDrawElements) real_glDrawElements;
+static void APIENTRY counted_glDrawElements(GLenum mode, GLsizei count, GLenum type,
+        const void* indices)
+{
+    g_renderStats.addDraw(mode, count);
+    real_glDrawElements(mode, count, type, indices);
+}
+
+static decltype(glad_glDrawElementsBaseVertex) real_glDrawElementsBaseVertex;
+static void APIENTRY counted_glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+        const void* indices, GLint baseVertex)
+{
+    g_renderStats.addDraw(mode, count);
+    real_glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+
+#define INSTALL_GL_HOOK(name) \
+    real_##name = glad_##name; \
+    glad_##name = counted_##name;
+
+void RenderStats::installHooks()
+{
+    INSTALL_GL_HOOK(glUseProgram);
+    INSTALL_GL_HOOK(glBindTexture);
+    INSTALL_GL_HOOK(glBindTextureUnit);
+    INSTALL_GL_HOOK(glBindVertexArray);
+    INSTALL_GL_HOOK(glUniform1f);
+    INSTALL_GL_HOOK(glUniform1i);
+    INSTALL_GL_HOOK(glUniform1ui);
+    INSTALL_GL_HOOK(glUniform2f);
+    INSTALL_GL_HOOK(glUniform2i);
+    INSTALL_GL_HOOK(glUniform3f);
+    INSTALL_GL_HOOK(glUniform4f);
+    INSTALL_GL_HOOK(glUniform2fv);
+    INSTALL_GL_HOOK(glUniform3fv);
+    INSTALL_GL_HOOK(glUniform4fv);
+    INSTALL_GL_HOOK(glUniformMatrix3fv);
+    INSTALL_GL_HOOK(glUniformMatrix4fv);
+    INSTALL_GL_HOOK(glDrawArrays);
+    INSTALL_GL_HOOK(glDrawArraysInstanced);
+    INSTALL_GL_HOOK(glDrawElements);
+    INSTALL_GL_HOOK(glDrawElementsBaseVertex);
+}
+
+void RenderStats::setPass(u32 pass)
+{
+    f64 now = getTime();
+    passes[currentPass].cpuTime += now - passStartTime;
+    passStartTime = now;
+    currentPass = pass;
+}
+
+void RenderStats::beginFrame()
+{
+    // the time since the last frame ended is not rendering, so it isn't counted
+    passStartTime = getTime();
+    currentPass = RenderStatPass::OTHER;
+    for (u32 i=0; i<RenderStatPass::MAX; ++i)
+    {
+        lastFrame[i] = passes[i];
+        passes[i] = {};
+    }
+
+    if (framesToRecord > 0)
+    {
+        for (u32 i=0; i<RenderStatPass::MAX; ++i)
+        {
+            recordedFrames.push(lastFrame[i]);
+        }
+        --framesToRecord;
+        if (framesToRecord == 0)
+        {
+            writeCSV("render_stats.csv");
+            recordedFrames.clear();
+        }
+    }
+}
+
+void RenderStats::record(u32 frameCount)
+{
+    framesToRecord = frameCount;
+    recordedFrames.reserve(framesToRecord * RenderStatPass::MAX);
+}
+
+void RenderStats::endFrame()
+{
+    setPass(RenderStatPass::OTHER);
+}
+
+void RenderStats::writeCSV(const char* filename)
+{
+    Array<char> csv;
+    auto write = [&](const char* str) {
+        for (const char* c = str; *c; ++c)
+        {
+            csv.push(*c);
+        }
+    };
+
+    write("frame,pass,draw_calls,triangles,program_binds,texture_binds,vao_binds,"
+          "uniform_updates,bytes_uploaded,cpu_time_ms\n");
+    for (u32 i=0; i<recordedFrames.size(); ++i)
+    {
+        RenderPassStats const& s = recordedFrames[i];
+        write(tmpStr("%u,%s,%u,%u,%u,%u,%u,%u,%llu,%.4f\n",
+                i / RenderStatPass::MAX, renderStatPassNames[i % RenderStatPass::MAX],
+                s.drawCalls, s.triangles, s.programBinds, s.textureBinds, s.vaoBinds,
+                s.uniformUpdates, (unsigned long long)s.bytesUploaded, s.cpuTime * 1000.0));
+    }
+    writeFile(filename, csv.data(), csv.size());
+    println("Wrote render stats for %u frames to %s", recordedFrames.size() / RenderStatPass::MAX,
+            filename);
+}
+
+void RenderStats::showDebugInfo()
+{
+    if (!ImGui::TreeNode("Render Stats"))
+    {
+        return;
+    }
+
+    RenderPassStats total;
+    for (u32 i=0; i<RenderStatPass::MAX; ++i)
+    {
+        total.add(lastFrame[i]);
+    }
+    ImGui::Text("Draw Calls: %u, Triangles: %u", total.drawCalls, total.triangles);
+    ImGui::Text("Binds: %u programs, %u textures, %u vertex arrays",
+            total.programBinds, total.textureBinds, total.vaoBinds);
+    ImGui::Text("Uniform Updates: %u, Uploaded: %.1fkb", total.uniformUpdates,
+            total.bytesUploaded / 1024.0);
+    ImGui::Text("CPU Time: %.3fms", total.cpuTime * 1000.0);
+
+    ImGui::Text("%-14s %6s %8s %5s %5s %5s %6s %8s %7s", "Pass", "Draws", "Tris",
+            "Prog", "Tex", "VAO", "Unif", "Upload", "ms");
+    for (u32 i=0; i<RenderStatPass::MAX; ++i)
+    {
+        RenderPassStats const& s = lastFrame[i];
+        ImGui::Text("%-14s %6u %8u %5u %5u %5u %6u %7.1fk %7.3f", renderStatPassNames[i],
+                s.drawCalls, s.triangles, s.programBinds, s.textureBinds, s.vaoBinds,
+                s.uniformUpdates, s.bytesUploaded / 1024.0, s.cpuTime * 1000.0);
+    }
+
+    if (framesToRecord > 0)
+    {
+        ImGui::Text("Recording... %u frames left", framesToRecord);
+    }
+    else if (ImGui::Button("Dump 300 Frames to CSV"))
+    {
+        record(300);
+    }
+
+    ImGui::TreePop();
+}
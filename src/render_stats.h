@@ -0,0 +1,95 @@
+#pragma once
+
+#include "misc.h"
+#include "gl.h"
+
+namespace RenderStatPass
+{
+    enum
+    {
+        SHADOW,
+        DEPTH_PREPASS,
+        SSAO,
+        OPAQUE_COLOR,
+        TRANSPARENT,
+        HIGHLIGHT,
+        OVERLAY,
+        PICK,
+        POST_PROCESS,
+        FULLSCREEN,
+        UI_2D,
+        OTHER,
+        MAX
+    };
+};
+
+struct RenderPassStats
+{
+    u32 drawCalls = 0;
+    u32 triangles = 0;
+    u32 programBinds = 0;
+    u32 textureBinds = 0;
+    u32 vaoBinds = 0;
+    u32 uniformUpdates = 0;
+    u64 bytesUploaded = 0;
+    f64 cpuTime = 0.0;
+
+    void add(RenderPassStats const& other)
+    {
+        drawCalls += other.drawCalls;
+        triangles += other.triangles;
+        programBinds += other.programBinds;
+        textureBinds += other.textureBinds;
+        vaoBinds += other.vaoBinds;
+        uniformUpdates += other.uniformUpdates;
+        bytesUploaded += other.bytesUploaded;
+        cpuTime += other.cpuTime;
+    }
+};
+
+// Counts the GL calls made each frame, split up by the pass that made them. The draw, bind and
+// uniform calls are counted by replacing the GL function pointers (see installHooks()), so
+// nothing has to be counted by hand at the call sites.
+class RenderStats
+{
+    RenderPassStats passes[RenderStatPass::MAX];
+    RenderPassStats lastFrame[RenderStatPass::MAX];
+    u32 currentPass = RenderStatPass::OTHER;
+    f64 passStartTime = 0.0;
+
+    Array<RenderPassStats> recordedFrames;
+    u32 framesToRecord = 0;
+
+    void writeCSV(const char* filename);
+
+public:
+    RenderPassStats& current() { return passes[currentPass]; }
+    RenderPassStats const& getLastFrame(u32 pass) const { return lastFrame[pass]; }
+
+    void installHooks();
+    void beginFrame();
+    void endFrame();
+    void setPass(u32 pass);
+    // writes the stats of the next frames to render_stats.csv
+    void record(u32 frameCount);
+
+    void addDraw(GLenum mode, GLsizei count, GLsizei instanceCount=1)
+    {
+        RenderPassStats& s = current();
+        ++s.drawCalls;
+        if (mode == GL_TRIANGLES)
+        {
+            s.triangles += (count / 3) * instanceCount;
+        }
+        else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+        {
+            s.triangles += max(count - 2, 0) * instanceCount;
+        }
+    }
+
+    void addUpload(size_t bytes) { current().bytesUploaded += bytes; }
+
+    void showDebugInfo();
+};
+
+RenderStats g_renderStats;
@@ -1,6 +1,7 @@
 #include "renderer.h"
 #include "game.h"
 #include "scene.h"
+#include "imgui.h"
 
 #include <stb_include.h>
 
@@ -12,8 +13,26 @@ ShaderHandle getShaderHandle(const char* name, SmallArray<ShaderDefine> const& d
     return g_game.renderer->getShaderHandle(name, defines, renderFlags, depthOffset);
 }
 
-void glShaderSources(GLuint shader, const char* src,
-        SmallArray<ShaderDefine> const& defines, ShaderDefine const& stageDefine)
+const char* SHADER_CACHE_DIRECTORY = "shader_cache";
+const u32 SHADER_CACHE_MAGIC = 0x48535052;
+const u64 MAX_SHADER_CACHE_SIZE = megabytes(64);
+
+static u64 fnv1a(void const* data, size_t size, u64 hash=14695981039346656037ull)
+{
+    for (size_t i=0; i<size; ++i)
+    {
+        hash = (hash ^ ((u8 const*)data)[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static u64 hashString(const char* str, u64 hash=14695981039346656037ull)
+{
+    // includes the terminator so that consecutive strings can't run together
+    return fnv1a(str, strlen(str) + 1, hash);
+}
+
+StrBuf getShaderPreamble(SmallArray<ShaderDefine> const& defines, ShaderDefine const& stageDefine)
 {
     StrBuf buf;
     buf.write("#version 450\n");
@@ -29,13 +48,21 @@ void glShaderSources(GLuint shader, const char* src,
     buf.writef("#define FOG_ENABLED %u\n", u32(g_game.config.graphics.fogEnabled));
     buf.writef("#define HIGH_QUALITY_TERRAIN_ENABLED %u\n", u32(g_game.config.graphics.highQualityTerrainEnabled));
     buf.writef("#define HIGH_QUALITY_TRACK_ENABLED %u\n", u32(g_game.config.graphics.highQualityTrackEnabled));
-    buf.writef("#define MAX_POINT_LIGHTS %u\n", MAX_POINT_LIGHTS);
-    buf.writef("#define LIGHT_SPLITS %u\n", LIGHT_SPLITS);
+    buf.writef("#define CLUSTER_X %uu\n", CLUSTER_X);
+    buf.writef("#define CLUSTER_Y %uu\n", CLUSTER_Y);
+    buf.writef("#define CLUSTER_Z %uu\n", CLUSTER_Z);
     for (auto const& d : defines)
     {
         buf.writef("#define %s %s\n", d.name, d.value);
     }
     buf.writef("#define %s %s\n", stageDefine.name, stageDefine.value);
+    return buf;
+}
+
+void glShaderSources(GLuint shader, const char* src,
+        SmallArray<ShaderDefine> const& defines, ShaderDefine const& stageDefine)
+{
+    StrBuf buf = getShaderPreamble(defines, stageDefine);
     const char* sources[] = { buf.data(), src };
 #if 0
     println("SHADER ===========================");
@@ -44,6 +71,127 @@ void glShaderSources(GLuint shader, const char* src,
     glShaderSource(shader, 2, sources, 0);
 }
 
+struct ShaderCacheHeader
+{
+    u32 magic;
+    GLenum binaryFormat;
+    u64 key;
+};
+
+// The key covers the complete source of every stage, including the preamble with the defines
+// and graphics settings, and the driver. A driver update or a changed include therefore results
+// in a cache miss instead of a stale program.
+static u64 getShaderCacheKey(const char* src, SmallArray<ShaderDefine> const& defines)
+{
+    u64 hash = hashString((const char*)glGetString(GL_VENDOR));
+    hash = hashString((const char*)glGetString(GL_RENDERER), hash);
+    hash = hashString((const char*)glGetString(GL_VERSION), hash);
+    hash = hashString(getShaderPreamble(defines, {"VERT", ""}).data(), hash);
+    hash = hashString(getShaderPreamble(defines, {"FRAG", ""}).data(), hash);
+    return hashString(src, hash);
+}
+
+static const char* getShaderCacheFilename(u64 key)
+{
+    return tmpStr("%s/%016llx.bin", SHADER_CACHE_DIRECTORY, (unsigned long long)key);
+}
+
+// returns 0 if there is no usable binary, in which case the program has to be compiled
+static GLuint loadProgramBinary(u64 key)
+{
+    const char* filename = getShaderCacheFilename(key);
+    if (!fileExists(filename))
+    {
+        return 0;
+    }
+    Buffer buf = readFileBytes(filename);
+    if (buf.size < sizeof(ShaderCacheHeader))
+    {
+        return 0;
+    }
+    ShaderCacheHeader header;
+    memcpy(&header, buf.data.get(), sizeof(header));
+    if (header.magic != SHADER_CACHE_MAGIC || header.key != key)
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, buf.data.get() + sizeof(header),
+            (GLsizei)(buf.size - sizeof(header)));
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // the driver can reject binaries at any time, for example after it was updated
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// returns the size of the file that was written
+static u64 saveProgramBinary(GLuint program, u64 key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return 0;
+    }
+    Buffer buf(sizeof(ShaderCacheHeader) + length);
+    ShaderCacheHeader header = { SHADER_CACHE_MAGIC, 0, key };
+    glGetProgramBinary(program, length, nullptr, &header.binaryFormat,
+            buf.data.get() + sizeof(header));
+    memcpy(buf.data.get(), &header, sizeof(header));
+
+    createDirectory(SHADER_CACHE_DIRECTORY);
+    writeFile(getShaderCacheFilename(key), buf.data.get(), buf.size);
+    return buf.size;
+}
+
+// Programs built for an old driver, old settings or old shader sources are never loaded again,
+// so when the cache grows past the limit the files that weren't used this run are deleted. This
+// also measures the size of the cache.
+void Renderer::trimShaderCache(u64 maxSize)
+{
+    struct CacheFile
+    {
+        const char* filename;
+        u64 size;
+        bool isUsed;
+    };
+    Array<CacheFile> files;
+    u64 totalSize = 0;
+    createDirectory(SHADER_CACHE_DIRECTORY);
+    walkDirectory(SHADER_CACHE_DIRECTORY, [&](const char* dir, const char* name, bool isDirectory) {
+        if (isDirectory)
+        {
+            return;
+        }
+        const char* filename = tmpStr("%s/%s", dir, name);
+        u64 size = getFileSize(filename);
+        u64 key = strtoull(name, nullptr, 16);
+        files.push({ filename, size, usedShaderCacheKeys.get(key) != nullptr });
+        totalSize += size;
+    });
+
+    for (auto const& file : files)
+    {
+        if (totalSize <= maxSize)
+        {
+            break;
+        }
+        if (!file.isUsed)
+        {
+            deleteFile(file.filename);
+            totalSize -= file.size;
+            ++shaderCacheStats.evicted;
+        }
+    }
+    shaderCacheSize = totalSize;
+}
+
 void Renderer::loadShader(const char* filename, SmallArray<const char*> defines, const char* name)
 {
     SmallArray<ShaderDefine> actualDefines;
@@ -60,6 +208,7 @@ void Renderer::loadShader(ShaderHandle handle)
     ShaderProgramSource const& d = shaderProgramSources[handle];
     char* filename = tmpStr("shaders/%s.glsl", d.name);
 
+    f64 startTime = getTime();
     char errorMsg[256];
     char* shaderStr = stb_include_file(filename, (char*)"", (char*)"shaders", errorMsg);
     if (!shaderStr)
@@ -67,8 +216,29 @@ void Renderer::loadShader(ShaderHandle handle)
         error("Shader parse error: %s", errorMsg);
     }
 
+    u64 cacheKey = 0;
+    if (isShaderCacheEnabled)
+    {
+        cacheKey = getShaderCacheKey(shaderStr, d.defines);
+        usedShaderCacheKeys.set(cacheKey, true);
+        GLuint program = loadProgramBinary(cacheKey);
+        if (program)
+        {
+            free(shaderStr);
+            setShaderProgram(handle, program, filename);
+            ++shaderCacheStats.hits;
+            shaderCacheStats.loadTime += getTime() - startTime;
+            return;
+        }
+        ++shaderCacheStats.misses;
+    }
+
     GLint success, errorMessageLength;
     GLuint program = glCreateProgram();
+    if (isShaderCacheEnabled)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
 
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSources(vertexShader, shaderStr, d.defines, {"VERT", ""});
@@ -131,12 +301,26 @@ void Renderer::loadShader(ShaderHandle handle)
 #if 0
     glDeleteShader(geometryShader);
 #endif
+    if (isShaderCacheEnabled)
+    {
+        shaderCacheSize += saveProgramBinary(program, cacheKey);
+        if (shaderCacheSize > MAX_SHADER_CACHE_SIZE)
+        {
+            trimShaderCache(MAX_SHADER_CACHE_SIZE);
+        }
+    }
+    setShaderProgram(handle, program, filename);
+    shaderCacheStats.loadTime += getTime() - startTime;
+}
+
+void Renderer::setShaderProgram(ShaderHandle handle, GLuint program, const char* label)
+{
     if (shaderPrograms[handle].program != 0)
     {
         glDeleteProgram(shaderPrograms[handle].program);
     }
 #ifndef NDEBUG
-    glObjectLabel(GL_PROGRAM, program, strlen(filename), filename);
+    glObjectLabel(GL_PROGRAM, program, strlen(label), label);
 #endif
     shaderPrograms[handle].program = program;
 }
@@ -158,43 +342,82 @@ void Renderer::loadShaders()
     loadShader("csz_minify");
     loadShader("sao");
     loadShader("sao_blur");
+    loadShader("vinyl_bake");
+}
+
+bool Renderer::isShaderSourceEqual(ShaderHandle handle, const char* name,
+        SmallArray<ShaderDefine> const& defines, u32 renderFlags, f32 depthOffset) const
+{
+    ShaderProgramSource const& source = shaderProgramSources[handle];
+    if (strcmp(source.name, name) != 0 || source.defines.size() != defines.size()
+            || shaderPrograms[handle].renderFlags != renderFlags
+            || shaderPrograms[handle].depthOffset != depthOffset)
+    {
+        return false;
+    }
+    for (u32 i=0; i<defines.size(); ++i)
+    {
+        if (strcmp(source.defines[i].name, defines[i].name) != 0
+                || strcmp(source.defines[i].value, defines[i].value) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 ShaderHandle Renderer::getShaderHandle(const char* name, SmallArray<ShaderDefine> const& defines,
         u32 renderFlags, f32 depthOffset)
 {
-    for (u32 shaderIndex = 0; shaderIndex < shaderProgramSources.size(); ++shaderIndex)
+    u64 hash = hashString(name);
+    for (auto const& d : defines)
+    {
+        hash = hashString(d.name, hash);
+        hash = hashString(d.value, hash);
+    }
+    hash = fnv1a(&renderFlags, sizeof(renderFlags), hash);
+    hash = fnv1a(&depthOffset, sizeof(depthOffset), hash);
+
+    ShaderHandle* existingHandle = shaderHandleMap.get(hash);
+    if (existingHandle)
     {
-        ShaderProgramSource& shaderData = shaderProgramSources[shaderIndex];
-        if (shaderData.name != name
-                || shaderData.defines.size() != defines.size()
-                || renderFlags != shaderPrograms[shaderIndex].renderFlags
-                || depthOffset != shaderPrograms[shaderIndex].depthOffset)
+        if (isShaderSourceEqual(*existingHandle, name, defines, renderFlags, depthOffset))
         {
-            continue;
+            return *existingHandle;
         }
-        bool definesMatch = true;
-        for (u32 i=0; i<defines.size(); ++i)
+        // Two different shaders with the same hash. This should never happen, but if it does
+        // the second one is found by searching, since only one handle fits in the map.
+        for (ShaderHandle h=0; h<shaderPrograms.size(); ++h)
         {
-            if (strcmp(shaderData.defines[i].name, defines[i].name) != 0 ||
-                strcmp(shaderData.defines[i].value, defines[i].value) != 0)
+            if (isShaderSourceEqual(h, name, defines, renderFlags, depthOffset))
             {
-                definesMatch = false;
-                break;
+                return h;
             }
         }
-        if (definesMatch)
-        {
-            return shaderIndex;
-        }
+        error("Shader hash collision: %s", name);
     }
+
     shaderPrograms.push({ 0, renderFlags, depthOffset });
     shaderProgramSources.push({ name, defines });
     ShaderHandle handle = shaderPrograms.size() - 1;
+    if (!existingHandle)
+    {
+        shaderHandleMap.set(hash, handle);
+    }
     loadShader(handle);
     return handle;
 }
 
+void Renderer::showDebugInfo()
+{
+    ImGui::Checkbox("Shader Binary Cache", &isShaderCacheEnabled);
+    ImGui::Text("Shaders: %u programs, %u cache hits, %u cache misses, %.1fms loading",
+            shaderPrograms.size(), shaderCacheStats.hits, shaderCacheStats.misses,
+            shaderCacheStats.loadTime * 1000.0);
+    ImGui::Text("Shader Cache: %.1fmb (%u evicted)", shaderCacheSize / (1024.0 * 1024.0),
+            shaderCacheStats.evicted);
+}
+
 void Renderer::updateFramebuffers()
 {
     renderWorld.name = "Main";
@@ -272,9 +495,18 @@ void Renderer::reloadShaders()
 
 void Renderer::init()
 {
+    GLint binaryFormatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    isShaderCacheEnabled = binaryFormatCount > 0;
+    if (isShaderCacheEnabled)
+    {
+        // nothing has been used yet, so only measure the cache
+        trimShaderCache(~0ull);
+    }
     loadShaders();
 
     glCreateVertexArrays(1, &emptyVAO);
+    drawDataBuffer.init();
 
     updateFramebuffers();
     updateFullscreenFramebuffers();
@@ -288,6 +520,12 @@ void Renderer::render(f32 deltaTime)
 {
     TIMED_BLOCK();
 
+    g_renderStats.beginFrame();
+    g_bindCache.bindCount = 0;
+    g_bindCache.skippedCount = 0;
+
+    vinylBaker.update();
+
     for (RenderWorld* rw : renderWorlds)
     {
         if (rw->settingsVersion != settingsVersion)
@@ -302,6 +540,8 @@ void Renderer::render(f32 deltaTime)
     renderWorld.render(this, deltaTime);
     //renderWorld.clear();
 
+    g_renderStats.setPass(RenderStatPass::FULLSCREEN);
+
     // render to fullscreen texture
     bool isMenuHidden = (g_game.currentScene
             && g_game.currentScene->isRaceInProgress && !g_game.currentScene->isPaused);
@@ -405,9 +645,18 @@ void Renderer::render(f32 deltaTime)
         }
     }
 
+    g_renderStats.setPass(RenderStatPass::UI_2D);
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "2D Pass");
     glEnable(GL_BLEND);
 
+    // quads and text are batched, only other 2D items have to be kept apart by priority
+    static ShaderHandle batch2DShader = getShaderHandle("batch2D", {});
+    batcher2D.build(g_res.white.handle, renderItems2D.empty());
+    for (auto const& batch : batcher2D.getBatches())
+    {
+        add2D(batch2DShader, batch.priority, (void*)&batch, Batcher2D::drawBatch);
+    }
+
     // NOTE: stable sort to preserve the order the renderables were added
     /*
     renderItems2D.stableSort([](auto& a, auto& b) {
@@ -462,9 +711,13 @@ void Renderer::render(f32 deltaTime)
     glPopDebugGroup();
 
     renderItems2D.clear();
+    batcher2D.clear();
     renderWorlds.clear();
     renderWorld.clear();
     tempMem.clear();
+
+    drawDataBuffer.endFrame();
+    g_renderStats.endFrame();
 }
 
 void RenderWorld::setViewportCount(u32 viewports)
@@ -730,6 +983,22 @@ void RenderWorld::createFramebuffers()
             glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, fb.shadowDepthTexture, 0);
 
             assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+            // static shadow casters are cached here and copied to the shadow map each frame
+            glGenTextures(1, &fb.staticShadowDepthTexture);
+            glBindTexture(GL_TEXTURE_2D, fb.staticShadowDepthTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
+                    shadowMapResolution, shadowMapResolution,
+                    0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            glGenFramebuffers(1, &fb.staticShadowFramebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, fb.staticShadowFramebuffer);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                    fb.staticShadowDepthTexture, 0);
+
+            assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
         }
 
         // bloom framebuffers
@@ -820,6 +1089,8 @@ void RenderWorld::createFramebuffers()
         fbs.push(fb);
         worldInfoUBO.push(DynamicBuffer(sizeof(WorldInfo)));
         worldInfoUBOShadow.push(DynamicBuffer(sizeof(WorldInfo)));
+        lightClusters.push(LightClusters());
+        staticShadowSignature[i] = 0;
     }
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -840,6 +1111,12 @@ void RenderWorld::destroy()
     }
     worldInfoUBOShadow.clear();
 
+    for (auto& c : lightClusters)
+    {
+        c.destroy();
+    }
+    lightClusters.clear();
+
     for (auto& fb : fbs)
     {
         if (fb.mainFramebuffer)
@@ -865,6 +1142,8 @@ void RenderWorld::destroy()
         {
             glDeleteTextures(1, &fb.shadowDepthTexture);
             glDeleteFramebuffers(1, &fb.shadowFramebuffer);
+            glDeleteTextures(1, &fb.staticShadowDepthTexture);
+            glDeleteFramebuffers(1, &fb.staticShadowFramebuffer);
         }
         if (fb.cszFramebuffers[0])
         {
@@ -967,15 +1246,58 @@ void RenderWorld::clear()
         }
     };
 
-    clearRenderItems(renderItems.depthPrepass);
-    clearRenderItems(renderItems.shadowPass);
-    clearRenderItems(renderItems.opaqueColorPass);
+    renderItems.queue.clear();
     clearRenderItems(renderItems.highlightPass);
-    clearRenderItems(renderItems.pickPass);
     renderItems.transparentPass.clear();
     renderItems.overlayPass.clear();
 }
 
+void RenderWorld::showDebugInfo()
+{
+    ImGui::Checkbox("Frustum Culling", &isFrustumCullingEnabled);
+    auto showPass = [](const char* name, PassCullingStats const& stats) {
+        ImGui::Text("%s: %u submitted, %u culled, %u drawn", name, stats.submitted,
+                stats.culled, stats.submitted - stats.culled);
+    };
+    showPass("Shadow Pass", cullingStats.shadowPass);
+    ImGui::Checkbox("Shadow Cache", &isShadowCacheEnabled);
+    ImGui::Text("Static Shadow Renders: %u", staticShadowRenderCount);
+    showPass("Depth Prepass", cullingStats.depthPrepass);
+    showPass("Opaque Color Pass", cullingStats.opaqueColorPass);
+    showPass("Transparent Pass", cullingStats.transparentPass);
+    ImGui::Text("Render Queue: %u items, %u binds, %u redundant binds skipped",
+            renderItems.queue.getSortedCount(), g_bindCache.bindCount, g_bindCache.skippedCount);
+    RenderQueue::showBenchmark();
+    if (lightClusters.size() > 0)
+    {
+        lightClusters[0].showDebugInfo();
+    }
+    LightClusters::showBenchmark();
+}
+
+u64 RenderWorld::getStaticShadowSignature(Mat4 const& shadowViewProjection)
+{
+    // FNV-1a over everything that affects the static shadow casters
+    u64 hash = 14695981039346656037ull;
+    auto hashBytes = [&](void const* data, size_t size) {
+        for (size_t i=0; i<size; ++i)
+        {
+            hash = (hash ^ ((u8 const*)data)[i]) * 1099511628211ull;
+        }
+    };
+    hashBytes(&shadowViewProjection, sizeof(shadowViewProjection));
+    hashBytes(&staticShadowVersion, sizeof(staticShadowVersion));
+    renderItems.queue.forEach(RenderPass::STATIC_SHADOW,
+            [&](ShaderHandle shader, RenderItem const& renderItem) {
+        hashBytes(&shader, sizeof(shader));
+        hashBytes(&renderItem.render, sizeof(renderItem.render));
+        hashBytes(&renderItem.stateKey, sizeof(renderItem.stateKey));
+        hashBytes(&renderItem.bounds, sizeof(renderItem.bounds));
+    });
+    // zero is reserved for an invalid signature
+    return hash | 1;
+}
+
 void RenderWorld::setShadowMatrices(WorldInfo& worldInfo, WorldInfo& worldInfoShadow, u32 cameraIndex)
 {
     Vec3 inverseLightDir = worldInfo.sunDirection;
@@ -999,12 +1321,24 @@ void RenderWorld::setShadowMatrices(WorldInfo& worldInfo, WorldInfo& worldInfoSh
             shadowBounds.max.x-shadowBounds.min.x,
             shadowBounds.max.y-shadowBounds.min.y) * 0.5f;
     f32 snapMultiple = 2.f * extent / shadowMapResolution;
+    f32 minZ = shadowBounds.min.z;
+    f32 maxZ = shadowBounds.max.z;
+    if (isShadowCacheEnabled && !hasCustomShadowBounds)
+    {
+        // Quantize the projection so that it stays the same while the camera moves a little,
+        // otherwise the cached static shadows would be re-rendered every frame. The extent is
+        // padded so that the frustum is still covered when the center lags behind.
+        extent = powf(1.25f, ceilf(logf(max(extent * 1.15f, 0.01f)) / logf(1.25f)));
+        snapMultiple = 0.1f * extent;
+        minZ = floorf(minZ / snapMultiple) * snapMultiple;
+        maxZ = ceilf(maxZ / snapMultiple) * snapMultiple;
+    }
     center.x = snap(center.x, snapMultiple);
     center.y = snap(center.y, snapMultiple);
     center.z = snap(center.z, snapMultiple);
     Mat4 depthProjection = Mat4::ortho(center.x-extent, center.x+extent,
                                         center.y+extent, center.y-extent,
-                                        -shadowBounds.max.z, -shadowBounds.min.z);
+                                        -maxZ, -minZ);
     Mat4 viewProj = depthProjection * depthView;
 
     worldInfoShadow.cameraViewProjection = viewProj;
@@ -1034,6 +1368,8 @@ void RenderWorld::render(Renderer* renderer, f32 deltaTime)
     };
     renderItems.transparentPass.sort(comparator);
     renderItems.overlayPass.sort(comparator);
+    renderItems.queue.sort(cameras[0].position);
+    cullingStats = {};
     for (u32 i=0; i<fbs.size(); ++i)
     {
         renderer->setCurrentRenderingCameraIndex(i);
@@ -1041,52 +1377,18 @@ void RenderWorld::render(Renderer* renderer, f32 deltaTime)
     }
 }
 
-void RenderWorld::partitionPointLights(u32 viewportIndex)
-{
-    f32 partitionWidth = (f32)fbs[viewportIndex].renderWidth / (f32)LIGHT_SPLITS;
-    f32 partitionHeight = (f32)fbs[viewportIndex].renderHeight / (f32)LIGHT_SPLITS;
-    for (u32 x = 0; x<LIGHT_SPLITS; ++x)
-    {
-        f32 splitX = x * partitionWidth;
-
-        for (u32 y = 0; y<LIGHT_SPLITS; ++y)
-        {
-            f32 splitY = y * partitionHeight;
-
-            // TODO: perform circle vs box collision so that each light affects fewer pixels
-            u32 lightCount = 0;
-            for (auto& p : pointLights)
-            {
-                Vec4 tp = cameras[viewportIndex].viewProjection * Vec4(p.position, 1.f);
-                tp.x = (((tp.x / tp.w) + 1.f) / 2.f) * fbs[viewportIndex].renderWidth;
-                tp.y = ((-1.f * (tp.y / tp.w) + 1.f) / 2.f) * fbs[viewportIndex].renderHeight;
-
-                f32 screenSpaceLightRadius = fbs[viewportIndex].renderHeight
-                    * cameras[viewportIndex].projection[1][1] * p.radius / tp.w;
-
-                if (!(tp.x - screenSpaceLightRadius > splitX + partitionWidth
-                    || tp.x + screenSpaceLightRadius < splitX
-                    || tp.y - screenSpaceLightRadius > splitY + partitionHeight
-                    || tp.y + screenSpaceLightRadius < splitY))
-                {
-                    worldInfo.lightPartitions[x][y].pointLights[lightCount++] = p;
-                    if (lightCount >= MAX_POINT_LIGHTS)
-                    {
-                        break;
-                    }
-                }
-            }
-            worldInfo.lightPartitions[x][y].pointLightCount = lightCount;
-        }
-    }
-}
-
 void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
 {
     TIMED_BLOCK();
 
     // update worldinfo uniform buffer
-    partitionPointLights(index);
+    if (g_game.config.graphics.pointLightsEnabled)
+    {
+        lightClusters[index].build(cameras[index], pointLights.data(), pointLights.size());
+        lightClusters[index].upload(pointLights.data());
+        worldInfo.clusterDepthScale = lightClusters[index].getDepthScale();
+        worldInfo.clusterDepthBias = lightClusters[index].getDepthBias();
+    }
     worldInfo.orthoProjection = Mat4::ortho(0.f, (f32)g_game.windowWidth, (f32)g_game.windowHeight, 0.f);
     worldInfo.cameraViewProjection = cameras[index].viewProjection;
     worldInfo.cameraProjection = cameras[index].projection;
@@ -1102,10 +1404,12 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
         && ((g_game.currentScene && !g_game.currentScene->isRaceInProgress) || !g_game.currentScene);
 
     Framebuffers const& fb = fbs[index];
+    Frustum cameraFrustum(cameras[index].viewProjection);
 
     // shadow map
     if (g_game.config.graphics.shadowsEnabled)
     {
+        g_renderStats.setPass(RenderStatPass::SHADOW);
         glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "Shadow Depth Pass");
 
         // NOTE: this is here to silence a warning (nvidia warning 131222)
@@ -1119,8 +1423,6 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
         // bind worldinfo with shadow matrices
         glBindBufferBase(GL_UNIFORM_BUFFER, 0, worldInfoUBOShadow[index].getBuffer());
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fb.shadowFramebuffer);
-
         glViewport(0, 0, shadowMapResolution, shadowMapResolution);
         glDepthMask(GL_TRUE);
         glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
@@ -1131,20 +1433,54 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
         glBindTextureUnit(2, fb.shadowDepthTexture);
         glEnable(GL_DEPTH_CLAMP);
         glDisable(GL_BLEND);
-        glClear(GL_DEPTH_BUFFER_BIT);
         glEnable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(2.f, 4096.f);
         glCullFace(GL_FRONT);
 
-        for (auto& pair : renderItems.shadowPass)
+        // depth clamping is enabled so casters in front of the near plane still cast shadows
+        Frustum shadowFrustum(worldInfoShadow.cameraViewProjection);
+        auto drawShadowCasters = [&](u32 pass) {
+            resetBindCache();
+            ShaderHandle previousShader = -1;
+            renderItems.queue.forEach(pass, [&](ShaderHandle shader, RenderItem const& renderItem) {
+                if (cull(cullingStats.shadowPass, shadowFrustum, renderItem.bounds, true))
+                {
+                    return;
+                }
+                if (previousShader != shader)
+                {
+                    previousShader = shader;
+                    glUseProgram(renderer->getShaderProgram(shader));
+                }
+                renderItem.render(renderItem.renderData);
+            });
+        };
+
+        if (isShadowCacheEnabled)
         {
-            ShaderProgram const& program = renderer->getShader(pair.key);
-            glUseProgram(program.program);
-            for (auto& renderItem : pair.value)
+            // the static casters are only redrawn when they or the shadow projection change,
+            // otherwise the cached depth is copied and the dynamic casters are drawn on top
+            u64 signature = getStaticShadowSignature(worldInfoShadow.cameraViewProjection);
+            if (signature != staticShadowSignature[index])
             {
-                renderItem.render(renderItem.renderData);
+                staticShadowSignature[index] = signature;
+                ++staticShadowRenderCount;
+                glBindFramebuffer(GL_FRAMEBUFFER, fb.staticShadowFramebuffer);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                drawShadowCasters(RenderPass::STATIC_SHADOW);
             }
+            glCopyImageSubData(fb.staticShadowDepthTexture, GL_TEXTURE_2D, 0, 0, 0, 0,
+                    fb.shadowDepthTexture, GL_TEXTURE_2D, 0, 0, 0, 0,
+                    shadowMapResolution, shadowMapResolution, 1);
+            glBindFramebuffer(GL_FRAMEBUFFER, fb.shadowFramebuffer);
+        }
+        else
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, fb.shadowFramebuffer);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawShadowCasters(RenderPass::STATIC_SHADOW);
         }
+        drawShadowCasters(RenderPass::SHADOW);
 
         glDisable(GL_POLYGON_OFFSET_FILL);
         glCullFace(GL_BACK);
@@ -1157,6 +1493,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     glBindBufferBase(GL_UNIFORM_BUFFER, 0, worldInfoUBO[index].getBuffer());
 
     // depth prepass
+    g_renderStats.setPass(RenderStatPass::DEPTH_PREPASS);
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "Depth PrePass");
     glViewport(0, 0, fb.renderWidth, fb.renderHeight);
     glBindFramebuffer(GL_FRAMEBUFFER, fb.mainFramebuffer);
@@ -1168,15 +1505,21 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     glCullFace(GL_BACK);
     glClear(GL_DEPTH_BUFFER_BIT);
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    for (auto& pair : renderItems.depthPrepass)
-    {
-        ShaderProgram const& program = renderer->getShader(pair.key);
-        glUseProgram(program.program);
-        for (auto& renderItem : pair.value)
+    resetBindCache();
+    ShaderHandle previousShader = -1;
+    renderItems.queue.forEach(RenderPass::DEPTH_PREPASS,
+            [&](ShaderHandle shader, RenderItem const& renderItem) {
+        if (cull(cullingStats.depthPrepass, cameraFrustum, renderItem.bounds))
         {
-            renderItem.render(renderItem.renderData);
+            return;
         }
-    }
+        if (previousShader != shader)
+        {
+            previousShader = shader;
+            glUseProgram(renderer->getShaderProgram(shader));
+        }
+        renderItem.render(renderItem.renderData);
+    });
 
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glPopDebugGroup();
@@ -1200,6 +1543,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     }
 
     // generate csz texture
+    g_renderStats.setPass(RenderStatPass::SSAO);
     if (g_game.config.graphics.ssaoQuality != ConfigLevel::LOW)
     {
         glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "SSAO");
@@ -1284,6 +1628,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     }
 
     // color pass
+    g_renderStats.setPass(RenderStatPass::OPAQUE_COLOR);
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "Main Color Pass");
     glBindFramebuffer(GL_FRAMEBUFFER, fb.mainFramebuffer);
     glBindTextureUnit(1, reflectionCubemap->handle);
@@ -1304,26 +1649,44 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     glEnable(GL_CULL_FACE);
     glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
     glDepthMask(GL_FALSE);
-    for (auto& pair : renderItems.opaqueColorPass)
-    {
-        ShaderProgram const& program = renderer->getShader(pair.key);
-        glUseProgram(program.program);
-        for (auto& renderItem : pair.value)
+    resetBindCache();
+    previousShader = -1;
+    i32 previousStencil = -1;
+    renderItems.queue.forEach(RenderPass::OPAQUE_COLOR,
+            [&](ShaderHandle shader, RenderItem const& renderItem) {
+        if (cull(cullingStats.opaqueColorPass, cameraFrustum, renderItem.bounds))
+        {
+            return;
+        }
+        if (previousShader != shader)
         {
+            previousShader = shader;
+            glUseProgram(renderer->getShaderProgram(shader));
+        }
+        if (previousStencil != renderItem.stencil)
+        {
+            previousStencil = renderItem.stencil;
             glStencilFunc(GL_ALWAYS, renderItem.stencil, 0xFF);
-            renderItem.render(renderItem.renderData);
         }
-    }
+        renderItem.render(renderItem.renderData);
+    });
     glStencilMask(0x0);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glDepthFunc(GL_LEQUAL);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    g_renderStats.setPass(RenderStatPass::TRANSPARENT);
     glEnable(GL_POLYGON_OFFSET_FILL);
-    ShaderHandle previousShader = -1;
+    previousShader = -1;
     for (auto& renderItem : renderItems.transparentPass)
     {
+        if (cull(cullingStats.transparentPass, cameraFrustum, renderItem.bounds))
+        {
+            continue;
+        }
+        // some transparent items bind directly, so the cache can't be trusted between items
+        resetBindCache();
         if (previousShader != renderItem.shader)
         {
             previousShader = renderItem.shader;
@@ -1359,6 +1722,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     glStencilMask(0xFF);
 
     // highlight selected objects in editor
+    g_renderStats.setPass(RenderStatPass::HIGHLIGHT);
     if (isEditorActive)
     {
         glEnable(GL_DEPTH_TEST);
@@ -1435,6 +1799,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     glStencilMask(0x0);
 
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    g_renderStats.setPass(RenderStatPass::OVERLAY);
     glEnable(GL_POLYGON_OFFSET_FILL);
     previousShader = -1;
     for (auto& renderItem : renderItems.overlayPass)
@@ -1462,6 +1827,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     // color picking
     if (isPickPixelPending)
     {
+        g_renderStats.setPass(RenderStatPass::PICK);
         glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "Color Pick Pass");
         glViewport(0, 0, fb.renderWidth / 2, fb.renderHeight / 2);
         glBindFramebuffer(GL_FRAMEBUFFER, fb.pickFramebuffer);
@@ -1472,15 +1838,17 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
         glDisable(GL_BLEND);
         glClearColor(0, 0, 0, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        for (auto& pair : renderItems.pickPass)
-        {
-            ShaderProgram const& program = renderer->getShader(pair.key);
-            glUseProgram(program.program);
-            for (auto& renderItem : pair.value)
+        resetBindCache();
+        previousShader = -1;
+        renderItems.queue.forEach(RenderPass::PICK,
+                [&](ShaderHandle shader, RenderItem const& renderItem) {
+            if (previousShader != shader)
             {
-                renderItem.render(renderItem.renderData);
+                previousShader = shader;
+                glUseProgram(renderer->getShaderProgram(shader));
             }
-        }
+            renderItem.render(renderItem.renderData);
+        });
         glPopDebugGroup();
         isPickPixelPending = false;
     }
@@ -1516,6 +1884,7 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
     }
 
     // resolve multi-sample color buffer
+    g_renderStats.setPass(RenderStatPass::POST_PROCESS);
     if (g_game.config.graphics.msaaLevel > 0)
     {
         glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "MSAA Color Resolve");
@@ -1620,5 +1989,6 @@ void RenderWorld::renderViewport(Renderer* renderer, u32 index, f32 deltaTime)
         this->tex[index].handle = fb.finalColorTexture;
     }
 
+    g_renderStats.setPass(RenderStatPass::OTHER);
     glPopDebugGroup();
 }
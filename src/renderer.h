@@ -8,6 +8,12 @@
 #include "dynamic_buffer.h"
 #include "buffer.h"
 #include "map.h"
+#include "bounding_box.h"
+#include "render_queue.h"
+#include "draw_data_buffer.h"
+#include "light_clusters.h"
+#include "batcher_2d.h"
+#include "vinyl_baker.h"
 
 struct RenderItem2D
 {
@@ -17,19 +23,13 @@ struct RenderItem2D
     void (*render)(void*);
 };
 
-struct RenderItem
-{
-    void* renderData;
-    void (*render)(void*);
-    u8 stencil = 0;
-};
-
 struct TransparentRenderItem
 {
     ShaderHandle shader;
     i32 priority;
     void* renderData;
     void (*render)(void*);
+    BoundingSphere bounds;
 };
 
 struct HighlightPassRenderItem
@@ -99,6 +99,8 @@ struct Framebuffers
 
     GLuint shadowFramebuffer;
     GLuint shadowDepthTexture;
+    GLuint staticShadowFramebuffer;
+    GLuint staticShadowDepthTexture;
 
     GLuint cszFramebuffers[5];
     GLuint cszTexture;
@@ -123,24 +125,6 @@ struct FullscreenFramebuffers
     GLuint fullscreenBlurFramebuffer;
 };
 
-const u32 MAX_POINT_LIGHTS = 18;
-const u32 LIGHT_SPLITS = 5;
-
-struct PointLight
-{
-    Vec3 position;
-    f32 radius;
-    Vec3 color;
-    f32 falloff;
-};
-
-struct LightPartition
-{
-    PointLight pointLights[MAX_POINT_LIGHTS];
-    u32 pointLightCount;
-    f32 pad[3];
-};
-
 struct WorldInfo
 {
     Mat4 orthoProjection;
@@ -153,7 +137,9 @@ struct WorldInfo
     Mat4 cameraView;
     Vec4 cameraPosition;
     Mat4 shadowViewProjectionBias;
-    LightPartition lightPartitions[LIGHT_SPLITS][LIGHT_SPLITS];
+    f32 clusterDepthScale = 0.f;
+    f32 clusterDepthBias = 0.f;
+    Vec2 pad2;
     Vec3 fogColor = { 0.5f, 0.6f, 1.f };
     f32 fogDensity = 0.f;
     Vec2 invResolution;
@@ -165,15 +151,11 @@ struct WorldInfo
 
 static_assert(sizeof(WorldInfo) <= kilobytes(16));
 
-// TODO: profile to see if using a map improves performance vs a sorted array
 struct RenderItems
 {
-    Map<ShaderHandle, Array<RenderItem>> depthPrepass;
-    Map<ShaderHandle, Array<RenderItem>> shadowPass;
-    Map<ShaderHandle, Array<RenderItem>> opaqueColorPass;
+    RenderQueue queue;
     Array<TransparentRenderItem> transparentPass;
     Map<ShaderHandle, Array<HighlightPassRenderItem>> highlightPass;
-    Map<ShaderHandle, Array<RenderItem>> pickPass;
     Array<TransparentRenderItem> overlayPass;
 };
 
@@ -181,6 +163,23 @@ class RenderWorld
 {
     friend class Renderer;
 
+public:
+    struct PassCullingStats
+    {
+        u32 submitted = 0;
+        u32 culled = 0;
+    };
+
+    struct CullingStats
+    {
+        PassCullingStats shadowPass;
+        PassCullingStats depthPrepass;
+        PassCullingStats opaqueColorPass;
+        PassCullingStats transparentPass;
+    };
+
+private:
+
     u32 width = 0, height = 0;
     u32 settingsVersion = 0;
     Vec4 clearColor = { 0.15f, 0.35f, 0.9f, 1.f };
@@ -195,14 +194,35 @@ class RenderWorld
     SmallArray<Camera, MAX_VIEWPORTS> cameras;
     SmallArray<DynamicBuffer, MAX_VIEWPORTS> worldInfoUBO;
     SmallArray<DynamicBuffer, MAX_VIEWPORTS> worldInfoUBOShadow;
+    SmallArray<LightClusters, MAX_VIEWPORTS> lightClusters;
     Vec4 highlightColor[MAX_VIEWPORTS] = {};
     Vec2 motionBlur[MAX_VIEWPORTS];
     Array<PointLight> pointLights;
 
     BoundingBox shadowBounds;
     bool hasCustomShadowBounds = false;
+    bool isShadowCacheEnabled = true;
+    u32 staticShadowVersion = 0;
+    u64 staticShadowSignature[MAX_VIEWPORTS] = {};
+    u32 staticShadowRenderCount = 0;
+
+    u64 getStaticShadowSignature(Mat4 const& shadowViewProjection);
 
     RenderItems renderItems;
+    CullingStats cullingStats;
+    bool isFrustumCullingEnabled = true;
+
+    bool cull(PassCullingStats& stats, Frustum const& frustum, BoundingSphere const& bounds,
+            bool ignoreNearPlane=false)
+    {
+        ++stats.submitted;
+        if (isFrustumCullingEnabled && !frustum.intersects(bounds, ignoreNearPlane))
+        {
+            ++stats.culled;
+            return true;
+        }
+        return false;
+    }
 
     // TODO: calculate these based on render resolution
     u32 firstBloomDivisor = 2;
@@ -227,7 +247,6 @@ class RenderWorld
     void setShadowMatrices(WorldInfo& worldInfo, WorldInfo& worldInfoShadow, u32 cameraIndex);
     void renderViewport(class Renderer* renderer, u32 cameraIndex, f32 deltaTime);
     void render(class Renderer* renderer, f32 deltaTime);
-    void partitionPointLights(u32 viewportIndex);
 
 public:
     RenderWorld() { cameras.resize(1); }
@@ -244,17 +263,28 @@ public:
 
     void depthPrepass(ShaderHandle shaderHandle, RenderItem const& renderItem)
     {
-        renderItems.depthPrepass[shaderHandle].push(renderItem);
+        renderItems.queue.push(RenderPass::DEPTH_PREPASS, shaderHandle, renderItem);
     }
 
     void shadowPass(ShaderHandle shaderHandle, RenderItem const& renderItem)
     {
-        renderItems.shadowPass[shaderHandle].push(renderItem);
+        renderItems.queue.push(RenderPass::SHADOW, shaderHandle, renderItem);
+    }
+
+    // for casters that don't move, these are drawn into a cached shadow map (see
+    // invalidateStaticShadows())
+    void staticShadowPass(ShaderHandle shaderHandle, RenderItem const& renderItem)
+    {
+        renderItems.queue.push(RenderPass::STATIC_SHADOW, shaderHandle, renderItem);
     }
 
+    // Static casters are compared by their shader, bounds and state key each frame. Casters
+    // without bounds have to call this when their geometry changes.
+    void invalidateStaticShadows() { ++staticShadowVersion; }
+
     void opaqueColorPass(ShaderHandle shaderHandle, RenderItem const& renderItem)
     {
-        renderItems.opaqueColorPass[shaderHandle].push(renderItem);
+        renderItems.queue.push(RenderPass::OPAQUE_COLOR, shaderHandle, renderItem);
     }
 
     void transparentPass(TransparentRenderItem const& renderItem)
@@ -264,7 +294,7 @@ public:
 
     void pickPass(ShaderHandle shaderHandle, RenderItem const& renderItem)
     {
-        renderItems.pickPass[shaderHandle].push(renderItem);
+        renderItems.queue.push(RenderPass::PICK, shaderHandle, renderItem);
     }
 
     void highlightPass(ShaderHandle shaderHandle, HighlightPassRenderItem const& renderItem)
@@ -344,6 +374,8 @@ public:
         shadowBounds = bb;
         hasCustomShadowBounds = enabled;
     }
+    CullingStats const& getCullingStats() const { return cullingStats; }
+    void showDebugInfo();
     void destroy();
 };
 
@@ -353,7 +385,6 @@ private:
     FullscreenFramebuffers fsfb = { 0 };
     RenderWorld renderWorld;
 
-    // TODO: count draw calls
     u32 currentRenderingCameraIndex = 0;
 
     u32 fullscreenBlurDivisor = 4;
@@ -368,12 +399,35 @@ private:
     Array<ShaderProgramSource> shaderProgramSources;
 
     Map<const char*, ShaderHandle> shaderNameMap;
+    // keyed by a hash of the shader name, defines, render flags and depth offset
+    Map<u64, ShaderHandle, 256> shaderHandleMap;
     void loadShaders();
     void loadShader(const char* filename, SmallArray<const char*> defines={}, const char* name=nullptr);
     void loadShader(ShaderHandle handle);
+    void setShaderProgram(ShaderHandle handle, GLuint program, const char* label);
+    bool isShaderSourceEqual(ShaderHandle handle, const char* name,
+            SmallArray<ShaderDefine> const& defines, u32 renderFlags, f32 depthOffset) const;
+
+    // compiled programs are saved to disk and loaded from there on the next launch if the
+    // driver supports program binaries
+    bool isShaderCacheEnabled = false;
+    struct
+    {
+        u32 hits = 0;
+        u32 misses = 0;
+        u32 evicted = 0;
+        f64 loadTime = 0.0;
+    } shaderCacheStats;
+    // the cache files that were loaded or written this run are never evicted
+    Map<u64, bool, 256> usedShaderCacheKeys;
+    u64 shaderCacheSize = 0;
+    void trimShaderCache(u64 maxSize);
 
     Array<RenderItem2D> renderItems2D;
     Array<RenderWorld*> renderWorlds;
+    DrawDataBuffer drawDataBuffer;
+    Batcher2D batcher2D;
+    VinylBaker vinylBaker;
 
     void createFullscreenFramebuffers();
     Buffer tempMem = Buffer(megabytes(10));
@@ -401,7 +455,12 @@ public:
     u32 getCurrentRenderingCameraIndex() const { return currentRenderingCameraIndex; }
     void setCurrentRenderingCameraIndex(u32 index) { currentRenderingCameraIndex = index; }
     void init();
+    void beginFrame() { drawDataBuffer.beginFrame(); }
+    DrawDataBuffer& getDrawDataBuffer() { return drawDataBuffer; }
+    Batcher2D& getBatcher2D() { return batcher2D; }
+    VinylBaker& getVinylBaker() { return vinylBaker; }
     void reloadShaders();
+    void showDebugInfo();
     void updateFramebuffers();
     void updateFullscreenFramebuffers();
     ShaderHandle getShaderHandle(const char* name, SmallArray<ShaderDefine> const& defines,
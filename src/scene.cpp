@@ -24,6 +24,8 @@ Scene::Scene(TrackData* data)
     sparks.maxScale = 0.5f;
     sparks.lit = false;
 
+    projectiles.setup(this);
+
     // create PhysX scene
     PxSceneDesc sceneDesc(g_game.physx.physics->getTolerancesScale());
     sceneDesc.gravity = PxVec3(0.f, 0.f, -15.f);
@@ -35,6 +37,7 @@ Scene::Scene(TrackData* data)
     sceneDesc.broadPhaseType = PxBroadPhaseType::eABP;
 
     physicsScene = g_game.physx.physics->createScene(sceneDesc);
+    debrisPool.setup(physicsScene, g_game.config.gameplay.maxDebrisActors);
 
     if (PxPvdSceneClient* pvdClient = physicsScene->getScenePvdClient())
     {
@@ -86,7 +89,11 @@ Scene::Scene(TrackData* data)
 
 Scene::~Scene()
 {
+    // these own objects that belong to the physics scene
+    vehicleManager.release();
+    debrisPool.release();
     physicsScene->release();
+    g_game.physx.allocator.deallocate(scratchBlock);
     if (backgroundSound)
     {
         g_audio.stopSound(backgroundSound);
@@ -157,6 +164,8 @@ void Scene::startRace()
     }
 #endif
 
+    vehicleManager.setup(physicsScene, createOrder.size());
+
     numHumanDrivers = 0;
     for (u32 i=0; i<createOrder.size(); ++i)
     {
@@ -219,7 +228,10 @@ void Scene::stopRace()
 
     finishOrder.clear();
     placements.clear();
+    queryBatch.clear();
     vehicles.clear();
+    vehicleManager.release();
+    debrisPool.despawnAll();
     isRaceInProgress = false;
     g_audio.setPaused(false);
     g_audio.stopAllGameplaySounds();
@@ -227,6 +239,7 @@ void Scene::stopRace()
     allPlayersFinished = false;
     finishTimer = 0.f;
     smoke.clear();
+    projectiles.clear();
 
     if (hasGeneratedPaths)
     {
@@ -343,12 +356,11 @@ void Scene::onUpdate(Renderer* renderer, f32 deltaTime)
             listenerPositions.push(trackPreviewCameraTarget);
         }
 
-        // TODO: Use PhysX scratch buffer to reduce allocations
         if (isRaceInProgress)
         {
             physicsMouseDrag(renderer);
-            physicsScene->simulate(deltaTime);
-            physicsScene->fetchResults(true);
+            simulatePhysics(deltaTime);
+            handlePhysicsEvents();
         }
         else
         {
@@ -359,6 +371,11 @@ void Scene::onUpdate(Renderer* renderer, f32 deltaTime)
         for (u32 i=0; i<vehicles.size(); ++i)
         {
             vehicles[i]->onUpdate(rw, deltaTime);
+        }
+        vehicleManager.update(physicsScene, groundSpotGrid, deltaTime);
+        for (u32 i=0; i<vehicles.size(); ++i)
+        {
+            vehicles[i]->onUpdateEnd(rw, deltaTime);
             if (vehicles[i]->cameraIndex >= 0)
             {
                 listenerPositions.push(vehicles[i]->lastValidPosition);
@@ -370,6 +387,7 @@ void Scene::onUpdate(Renderer* renderer, f32 deltaTime)
         {
             e->onUpdate(rw, this, deltaTime);
         }
+        projectiles.update(deltaTime);
 
         // determine vehicle placement
         if (vehicles.size() > 0)
@@ -444,6 +462,7 @@ void Scene::onUpdate(Renderer* renderer, f32 deltaTime)
     {
         if ((*it)->isDestroyed())
         {
+            groundSpotGrid.remove(it->get());
             it = entities.erase(it);
         }
         else
@@ -452,11 +471,20 @@ void Scene::onUpdate(Renderer* renderer, f32 deltaTime)
         }
     }
 
+    // Run the queries that were queued during the update so the results are ready for the next
+    // update. This has to happen after the destroyed entities are gone, because the hits keep
+    // pointers to their actors.
+    if (!isPaused)
+    {
+        queryBatch.execute(physicsScene);
+    }
+
     // render entities
     for (auto const& e : entities)
     {
         e->onRender(rw, this, deltaTime);
     }
+    projectiles.render(rw);
 
     // render the batches
     batcher.render(rw);
@@ -929,17 +957,64 @@ void Scene::buildRaceResults()
 
 void Scene::applyAreaForce(Vec3 const& position, f32 strength) const
 {
+    f32 radius = strength * 1.5f;
     for (auto& v : vehicles)
     {
         f32 dist = distance(v->getPosition(), position);
-        f32 radius = strength * 1.5f;
         if (dist < radius)
         {
             v->shakeScreen(powf(
                         clamp(1.f - dist / radius, 0.f, 1.f), 0.5f) * radius);
         }
     }
-    // TODO: apply force to nearby physics bodies
+
+    // push debris and dynamic props away from the explosion
+    const u32 bufferSize = 256;
+    PxOverlapHit hitBuffer[bufferSize];
+    PxOverlapBuffer hit(hitBuffer, bufferSize);
+    PxQueryFilterData filter;
+    filter.flags = PxQueryFlag::eDYNAMIC | PxQueryFlag::eNO_BLOCK;
+    filter.data = PxFilterData(COLLISION_FLAG_DYNAMIC | COLLISION_FLAG_DEBRIS, 0, 0, 0);
+    if (!physicsScene->overlap(PxSphereGeometry(radius),
+            PxTransform(convert(position), PxIdentity), hit, filter))
+    {
+        return;
+    }
+
+    // bodies with more than one shape are reported once for each shape
+    PxRigidDynamic* pushedBodies[bufferSize];
+    u32 pushedBodyCount = 0;
+    for (u32 i=0; i<hit.getNbTouches(); ++i)
+    {
+        PxRigidDynamic* body = hit.getTouch(i).actor->is<PxRigidDynamic>();
+        if (!body || (body->getRigidBodyFlags() & PxRigidBodyFlag::eKINEMATIC))
+        {
+            continue;
+        }
+        bool alreadyPushed = false;
+        for (u32 j=0; j<pushedBodyCount; ++j)
+        {
+            if (pushedBodies[j] == body)
+            {
+                alreadyPushed = true;
+                break;
+            }
+        }
+        if (alreadyPushed)
+        {
+            continue;
+        }
+        pushedBodies[pushedBodyCount++] = body;
+
+        Vec3 centerOfMass = Vec3(body->getGlobalPose().transform(body->getCMassLocalPose().p));
+        Vec3 diff = centerOfMass - position;
+        f32 dist = length(diff);
+        f32 falloff = clamp(1.f - dist / radius, 0.f, 1.f);
+        Vec3 dir = dist > 0.001f ? diff / dist : Vec3(0, 0, 1);
+        // lift things off the ground a bit so they don't just slide away
+        dir = normalize(dir + Vec3(0, 0, 0.5f));
+        body->addForce(convert(dir * (strength * 2.f * falloff)), PxForceMode::eVELOCITY_CHANGE);
+    }
 }
 
 void Scene::createExplosion(Vec3 const& position, Vec3 const& velocity, f32 strength)
@@ -1073,10 +1148,106 @@ bool Scene::sweep(f32 radius, Vec3 const& from, Vec3 const& dir, f32 dist,
     }
 }
 
+void Scene::simulatePhysics(f32 deltaTime)
+{
+    TrackingAllocator& allocator = g_game.physx.allocator;
+    allocator.resetPeak();
+    i64 liveBytesBefore = allocator.getLiveBytes();
+    u64 allocationCountBefore = allocator.getTotalCount();
+
+    physicsScene->simulate(deltaTime, nullptr, scratchBlock, scratchBlockSize);
+    physicsScene->fetchResults(true);
+
+    // memory that is still live after the step is persistent (new contacts, grown buffers, etc)
+    // and would never have come from the scratch block, so only count what was freed again
+    i64 liveBytesAfter = allocator.getLiveBytes();
+    i64 transientPeak = allocator.getPeakBytes()
+        - (liveBytesAfter > liveBytesBefore ? liveBytesAfter : liveBytesBefore);
+    simulateHeapPeak = transientPeak > 0 ? transientPeak : 0;
+    simulateAllocationCount = allocator.getTotalCount() - allocationCountBefore;
+
+    // PhysX uses the scratch block first and then the heap. Grow the block by the amount that
+    // didn't fit once that has happened on several steps, so a single spike doesn't keep a large
+    // block around, and give some of it back when it has been big enough for a long time. The
+    // size must be a multiple of 16kb.
+    const u32 MAX_SCRATCH_BLOCK_SIZE = (u32)megabytes(4);
+    const u32 GROW_AFTER_OVERFLOW_STEPS = 8;
+    const u32 SHRINK_AFTER_STEPS = 60 * 30;
+    if (simulateHeapPeak > 0)
+    {
+        ++scratchOverflowSteps;
+        if (simulateHeapPeak > scratchOverflowPeak)
+        {
+            scratchOverflowPeak = simulateHeapPeak;
+        }
+        stepsSinceScratchOverflow = 0;
+    }
+    else
+    {
+        ++stepsSinceScratchOverflow;
+    }
+
+    u32 newSize = scratchBlockSize;
+    if (scratchOverflowSteps >= GROW_AFTER_OVERFLOW_STEPS)
+    {
+        newSize = (u32)align(scratchBlockSize + scratchOverflowPeak, kilobytes(16));
+        newSize = min(newSize, MAX_SCRATCH_BLOCK_SIZE);
+        scratchOverflowSteps = 0;
+        scratchOverflowPeak = 0;
+    }
+    else if (stepsSinceScratchOverflow >= SHRINK_AFTER_STEPS && scratchBlockSize > 0)
+    {
+        newSize = (u32)(scratchBlockSize * 3 / 4 / kilobytes(16) * kilobytes(16));
+        stepsSinceScratchOverflow = 0;
+        scratchOverflowSteps = 0;
+        scratchOverflowPeak = 0;
+    }
+    if (newSize != scratchBlockSize)
+    {
+        allocator.deallocate(scratchBlock);
+        scratchBlock = newSize > 0
+            ? (u8*)allocator.allocate(newSize, "Scene Scratch Block", __FILE__, __LINE__) : nullptr;
+        scratchBlockSize = newSize;
+    }
+}
+
+// identifies an actor the same way every run, unlike the actor's address
+static u32 getActorSortId(ActorUserData* userData)
+{
+    if (!userData)
+    {
+        return 0;
+    }
+    if (userData->entityType == ActorUserData::VEHICLE)
+    {
+        return (1u << 30) | userData->vehicle->vehicleIndex;
+    }
+    if (userData->entityType == ActorUserData::ENTITY
+            || userData->entityType == ActorUserData::SELECTABLE_ENTITY)
+    {
+        return (2u << 30) | userData->entity->entityCounterID;
+    }
+    return userData->entityType;
+}
+
 void Scene::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs)
 {
     PxContactPairPoint contactPoints[64];
 
+    if (pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0
+                | PxContactPairHeaderFlag::eREMOVED_ACTOR_1))
+    {
+        return;
+    }
+
+    ActorUserData* a = (ActorUserData*)pairHeader.actors[0]->userData;
+    ActorUserData* b = (ActorUserData*)pairHeader.actors[1]->userData;
+    u64 sortKey = ((u64)getActorSortId(a) << 32) | getActorSortId(b);
+    PxVec3 velA = pairHeader.actors[0]->getConcreteType() == PxConcreteType::eRIGID_DYNAMIC ?
+        pairHeader.actors[0]->is<PxRigidDynamic>()->getLinearVelocity() : PxVec3(0, 0, 0);
+    PxVec3 velB = pairHeader.actors[1]->getConcreteType() == PxConcreteType::eRIGID_DYNAMIC ?
+        pairHeader.actors[1]->is<PxRigidDynamic>()->getLinearVelocity() : PxVec3(0, 0, 0);
+
     for(u32 i=0; i<nbPairs; ++i)
     {
         u32 contactCount = pairs[i].contactCount;
@@ -1090,103 +1261,30 @@ void Scene::onContact(const PxContactPairHeader& pairHeader, const PxContactPair
 
         for(u32 j=0; j<contactCount; ++j)
         {
+            // weaker contacts don't do anything
             f32 magnitude = contactPoints[j].impulse.magnitude();
-            if (magnitude > 1350.f)
+            if (magnitude <= 20.f)
             {
-                ActorUserData* a = (ActorUserData*)pairHeader.actors[0]->userData;
-                ActorUserData* b = (ActorUserData*)pairHeader.actors[1]->userData;
-                f32 damage = min(magnitude * 0.00058f, 100.f);
-
-                // apply damage
-                if (a && a->entityType == ActorUserData::VEHICLE)
-                {
-                    f32 myDamage = damage;
-                    if (b && b->entityType == ActorUserData::VEHICLE)
-                    {
-                        if (b->vehicle->hasAbility("Ram Booster"))
-                        {
-                            myDamage *= 2.75f;
-                            // TODO: Shouldn't minDamage be multiplied by deltaTime?
-                            f32 minDamage = 5.f;
-                            myDamage = max(myDamage, minDamage);
-                        }
-                        if (a->vehicle->hasAbility("Ram Booster"))
-                        {
-                            myDamage *= 0.75f;
-                        }
-                    }
-                    u32 instigator = (b && b->entityType == ActorUserData::VEHICLE)
-                        ? b->vehicle->vehicleIndex : a->vehicle->vehicleIndex;
-                    a->vehicle->applyDamage(myDamage, instigator);
-                    if (damage > 5.f)
-                    {
-                        a->vehicle->shakeScreen(damage * 0.35f);
-                    }
-                }
-                if (b && b->entityType == ActorUserData::VEHICLE)
-                {
-                    f32 myDamage = damage;
-                    if (a && a->entityType == ActorUserData::VEHICLE)
-                    {
-                        if (a->vehicle->hasAbility("Ram Booster"))
-                        {
-                            myDamage *= 2.75f;
-                            // TODO: test this out
-                            myDamage = max(myDamage, 5.f);
-                        }
-                        if (b->vehicle->hasAbility("Ram Booster"))
-                        {
-                            myDamage *= 0.75f;
-                        }
-                    }
-                    u32 instigator = (a && a->entityType == ActorUserData::VEHICLE)
-                        ? a->vehicle->vehicleIndex : b->vehicle->vehicleIndex;
-                    b->vehicle->applyDamage(myDamage, instigator);
-                    if (damage > 5.f)
-                    {
-                        b->vehicle->shakeScreen(damage * 0.35f);
-                    }
-                }
-
-                if (damage > 0.1f)
-                {
-                    g_audio.playSound3D(g_res.getSound("impact"),
-                            SoundType::GAME_SFX, contactPoints[j].position, false, 1.f,
-                            clamp(damage * 0.2f, 0.1f, 1.f));
-                }
+                continue;
             }
 
             PxMaterial* materialA = pairs[i].shapes[0]->getMaterialFromInternalFaceIndex(
                     contactPoints[j].internalFaceIndex0);
             PxMaterial* materialB = pairs[i].shapes[1]->getMaterialFromInternalFaceIndex(
                     contactPoints[j].internalFaceIndex1);
-            if (magnitude > 20.f &&
-                    materialA != g_game.physx.materials.offroad &&
-                    materialB != g_game.physx.materials.offroad)
-                    // && pairs[i].events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS)
-            {
-                Vec3 velOffset = Vec3(
-                    random(randomSeries, -0.25f, 0.25f),
-                    random(randomSeries, -0.25f, 0.25f),
-                    random(randomSeries, 1.f, 2.f));
-
-                PxVec3 velA = pairHeader.actors[0]->getConcreteType() == PxConcreteType::eRIGID_DYNAMIC ?
-                    pairHeader.actors[0]->is<PxRigidDynamic>()->getLinearVelocity() : PxVec3(0, 0, 0);
-                PxVec3 velB = pairHeader.actors[1]->getConcreteType() == PxConcreteType::eRIGID_DYNAMIC ?
-                    pairHeader.actors[1]->is<PxRigidDynamic>()->getLinearVelocity() : PxVec3(0, 0, 0);
-                PxVec3 velocityDiff = velA - velB;
-                f32 magnitude = velocityDiff.magnitude();
-                f32 minMagnitude = 10.f;
-                if (magnitude > minMagnitude)
-                {
-                    f32 alpha = min((magnitude - minMagnitude) * 0.25f, 1.f);
-                    Vec3 collisionVelocity = velA + velB * 0.5f;
-                    sparks.spawn(contactPoints[j].position,
-                            (contactPoints[j].normal + velOffset)
-                                * random(randomSeries, 4.f, 5.f) + collisionVelocity * 0.4f, 1.f,
-                            Vec4(Vec3(1.f, random(randomSeries, 0.55f, 0.7f), 0.02f) * 2.f, alpha));
-                }
-            }
+
+            contactEvents.push({
+                sortKey,
+                a,
+                b,
+                contactPoints[j].position,
+                contactPoints[j].normal,
+                velA,
+                velB,
+                magnitude,
+                materialA != g_game.physx.materials.offroad &&
+                    materialB != g_game.physx.materials.offroad,
+            });
         }
     }
 }
@@ -1214,17 +1312,119 @@ void Scene::onTrigger(PxTriggerPair* pairs, PxU32 count)
 
         if (userData && otherUserData)
         {
-            if (userData->entityType == ActorUserData::ENTITY
-                    || userData->entityType == ActorUserData::SELECTABLE_ENTITY)
+            triggerEvents.push({
+                ((u64)getActorSortId(userData) << 32) | getActorSortId(otherUserData),
+                userData,
+                otherUserData,
+            });
+        }
+    }
+}
+
+void Scene::handlePhysicsEvents()
+{
+    TIMED_BLOCK();
+
+    contactEvents.consume([this](ContactEvent const& e) {
+        ActorUserData* a = e.a;
+        ActorUserData* b = e.b;
+        if (e.impulse > 1350.f)
+        {
+            f32 damage = min(e.impulse * 0.00058f, 100.f);
+
+            // apply damage
+            if (a && a->entityType == ActorUserData::VEHICLE)
+            {
+                f32 myDamage = damage;
+                if (b && b->entityType == ActorUserData::VEHICLE)
+                {
+                    if (b->vehicle->hasAbility("Ram Booster"))
+                    {
+                        myDamage *= 2.75f;
+                        // TODO: Shouldn't minDamage be multiplied by deltaTime?
+                        f32 minDamage = 5.f;
+                        myDamage = max(myDamage, minDamage);
+                    }
+                    if (a->vehicle->hasAbility("Ram Booster"))
+                    {
+                        myDamage *= 0.75f;
+                    }
+                }
+                u32 instigator = (b && b->entityType == ActorUserData::VEHICLE)
+                    ? b->vehicle->vehicleIndex : a->vehicle->vehicleIndex;
+                a->vehicle->applyDamage(myDamage, instigator);
+                if (damage > 5.f)
+                {
+                    a->vehicle->shakeScreen(damage * 0.35f);
+                }
+            }
+            if (b && b->entityType == ActorUserData::VEHICLE)
+            {
+                f32 myDamage = damage;
+                if (a && a->entityType == ActorUserData::VEHICLE)
+                {
+                    if (a->vehicle->hasAbility("Ram Booster"))
+                    {
+                        myDamage *= 2.75f;
+                        // TODO: test this out
+                        myDamage = max(myDamage, 5.f);
+                    }
+                    if (b->vehicle->hasAbility("Ram Booster"))
+                    {
+                        myDamage *= 0.75f;
+                    }
+                }
+                u32 instigator = (a && a->entityType == ActorUserData::VEHICLE)
+                    ? a->vehicle->vehicleIndex : b->vehicle->vehicleIndex;
+                b->vehicle->applyDamage(myDamage, instigator);
+                if (damage > 5.f)
+                {
+                    b->vehicle->shakeScreen(damage * 0.35f);
+                }
+            }
+
+            if (damage > 0.1f)
             {
-                userData->entity->onTrigger(otherUserData);
+                g_audio.playSound3D(g_res.getSound("impact"),
+                        SoundType::GAME_SFX, e.position, false, 1.f,
+                        clamp(damage * 0.2f, 0.1f, 1.f));
             }
-            if (otherUserData->entityType == ActorUserData::VEHICLE)
+        }
+
+        if (e.canSpark)
+            // && pairs[i].events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS)
+        {
+            Vec3 velOffset = Vec3(
+                random(randomSeries, -0.25f, 0.25f),
+                random(randomSeries, -0.25f, 0.25f),
+                random(randomSeries, 1.f, 2.f));
+
+            PxVec3 velocityDiff = e.velocityA - e.velocityB;
+            f32 magnitude = velocityDiff.magnitude();
+            f32 minMagnitude = 10.f;
+            if (magnitude > minMagnitude)
             {
-                otherUserData->vehicle->onTrigger(userData);
+                f32 alpha = min((magnitude - minMagnitude) * 0.25f, 1.f);
+                Vec3 collisionVelocity = e.velocityA + e.velocityB * 0.5f;
+                sparks.spawn(e.position,
+                        (e.normal + velOffset)
+                            * random(randomSeries, 4.f, 5.f) + collisionVelocity * 0.4f, 1.f,
+                        Vec4(Vec3(1.f, random(randomSeries, 0.55f, 0.7f), 0.02f) * 2.f, alpha));
             }
         }
-    }
+    });
+
+    triggerEvents.consume([](TriggerEvent const& e) {
+        if (e.trigger->entityType == ActorUserData::ENTITY
+                || e.trigger->entityType == ActorUserData::SELECTABLE_ENTITY)
+        {
+            e.trigger->entity->onTrigger(e.other);
+        }
+        if (e.other->entityType == ActorUserData::VEHICLE)
+        {
+            e.other->vehicle->onTrigger(e.trigger);
+        }
+    });
 }
 
 void Scene::serialize(Serializer& s)
@@ -1304,10 +1504,13 @@ Array<DataFile::Value> Scene::serializeTransientEntities()
 
 void Scene::deserializeTransientEntities(Array<DataFile::Value>& entities)
 {
+    // the query results may point to the actors of the entities that are removed
+    queryBatch.clear();
     for (auto it = this->entities.begin(); it != this->entities.end();)
     {
         if (((*it)->entityFlags & EntityFlags::TRANSIENT) == EntityFlags::TRANSIENT)
         {
+            groundSpotGrid.remove(it->get());
             it = this->entities.erase(it);
         }
         else
@@ -1328,6 +1531,51 @@ void Scene::showDebugInfo()
     ImGui::Text("Entities: %i", entities.size());
     ImGui::Text("Generated Paths: %s", hasGeneratedPaths ? "true" : "false");
     ImGui::Text("World Time: %.4f", worldTime);
+    ImGui::Text("Batched Queries: %u (%.3fms)", queryBatch.getQueryCount(),
+            queryBatch.getQueryTime() * 1000.0);
+    vehicleManager.showDebugInfo();
+    ImGui::Text("Ground Spots: %u", groundSpotGrid.getSpotCount());
+    debrisPool.showDebugInfo();
+    ImGui::Text("Physics Scratch Block: %ukb (last step: %.1fkb heap overflow, %llu allocations)",
+            scratchBlockSize / 1024, simulateHeapPeak / 1024.0,
+            (unsigned long long)simulateAllocationCount);
+    ImGui::Text("Contact Events: %u (%u dropped)", contactEvents.getLastCount(),
+            contactEvents.getDroppedCount());
+    ImGui::Text("Trigger Events: %u (%u dropped)", triggerEvents.getLastCount(),
+            triggerEvents.getDroppedCount());
+    projectiles.showDebugInfo();
+    ImGui::Text("Particles: %u smoke, %u sparks (%u / %u dropped)", smoke.size(), sparks.size(),
+            smoke.getDroppedCount(), sparks.getDroppedCount());
+    ParticleSystem::showBenchmark();
+    Terrain::showBenchmark(this);
+
+    f64 totalAiTime = 0.0;
+    u32 aiCount = 0;
+    for (auto& v : vehicles)
+    {
+        if (!v->driver->isPlayer)
+        {
+            totalAiTime += v->aiUpdateTime;
+            ++aiCount;
+        }
+    }
+    if (aiCount > 0)
+    {
+        ImGui::Text("AI Time: %.3fms (%u AI)", totalAiTime * 1000.0, aiCount);
+        if (ImGui::TreeNode("AI Cost"))
+        {
+            for (auto& v : vehicles)
+            {
+                if (!v->driver->isPlayer)
+                {
+                    ImGui::Text("%-16s avg: %.3fms, decision: %.3fms, interval: %u",
+                            v->driver->playerName.data(), v->aiUpdateTime * 1000.0,
+                            v->aiDecisionTime * 1000.0, v->aiDecisionInterval);
+                }
+            }
+            ImGui::TreePop();
+        }
+    }
     if (auto playerVehicle = vehicles.findIf([](auto& v) { return v->driver->isPlayer; }))
     {
         ImGui::Gap();
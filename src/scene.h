@@ -18,6 +18,11 @@
 #include "racing_line.h"
 #include "batcher.h"
 #include "track_preview.h"
+#include "query_batch.h"
+#include "vehicle_physics.h"
+#include "projectile_system.h"
+#include "debris_pool.h"
+#include "physics_events.h"
 
 struct RaceBonus
 {
@@ -105,6 +110,21 @@ private:
     MotionGrid motionGrid;
     PxDistanceJoint* dragJoint = nullptr;
     Batcher batcher;
+    QueryBatch queryBatch;
+    VehicleManager vehicleManager;
+    GroundSpotGrid groundSpotGrid;
+    DebrisPool debrisPool;
+    PhysicsEventQueue<ContactEvent, 1024> contactEvents;
+    PhysicsEventQueue<TriggerEvent, 256> triggerEvents;
+
+    // temporary memory for simulate(), grown when PhysX keeps falling back to the heap
+    u8* scratchBlock = nullptr;
+    u32 scratchBlockSize = 0;
+    i64 simulateHeapPeak = 0;
+    i64 scratchOverflowPeak = 0;
+    u32 scratchOverflowSteps = 0;
+    u32 stepsSinceScratchOverflow = 0;
+    u64 simulateAllocationCount = 0;
     bool hasTrackPreview = false;
 
     bool allPlayersFinished = false;
@@ -117,6 +137,8 @@ private:
     void onTrigger(PxTriggerPair* pairs, PxU32 count);
     void onAdvance(const PxRigidBody* const*, const PxTransform*, const PxU32) {}
     void onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs);
+    void handlePhysicsEvents();
+    void simulatePhysics(f32 deltaTime);
 
     void buildRaceResults();
     void physicsMouseDrag(Renderer* renderer);
@@ -136,6 +158,7 @@ public:
     SoundHandle backgroundSound = 0;
     ParticleSystem smoke;
     ParticleSystem sparks;
+    ProjectileSystem projectiles;
     RibbonRenderer ribbons;
     DebugDraw debugDraw;
     Terrain* terrain = nullptr;
@@ -196,6 +219,10 @@ public:
     PxScene* const& getPhysicsScene() const { return physicsScene; }
     TrackGraph& getTrackGraph() { return trackGraph; }
     MotionGrid& getMotionGrid() { return motionGrid; }
+    QueryBatch& getQueryBatch() { return queryBatch; }
+    VehicleManager& getVehicleManager() { return vehicleManager; }
+    GroundSpotGrid& getGroundSpotGrid() { return groundSpotGrid; }
+    DebrisPool& getDebrisPool() { return debrisPool; }
     u32 getTotalLaps() const { return totalLaps; }
     f32 timeUntilStart() const;
     bool canGo() const { return timeUntilStart() < 0.001f; };
@@ -3,6 +3,8 @@
 #include "renderer.h"
 #include "debug_draw.h"
 #include "scene.h"
+#include "imgui.h"
+#include <emmintrin.h>
 
 void Terrain::createBuffers()
 {
@@ -73,7 +75,6 @@ void Terrain::resize(f32 x1, f32 y1, f32 x2, f32 y2, bool preserve)
 		heightBuffer[i] = 0.f;
     }
     vertices.reset(new Vertex[heightBufferSize]);
-	indices.reset(new u32[heightBufferSize * 6]);
     blend.reset(new u32[heightBufferSize]);
 	for (u32 i = 0; i < heightBufferSize; ++i)
 	{
@@ -124,6 +125,11 @@ void Terrain::onCreate(Scene* scene)
 void Terrain::onRender(RenderWorld* rw, Scene* scene, f32 deltaTime)
 {
     regenerateMaterial();
+    if (hasMeshChanged)
+    {
+        rw->invalidateStaticShadows();
+        hasMeshChanged = false;
+    }
 
     /*
     u32 width = (x2 - x1) / tileSize;
@@ -147,21 +153,39 @@ void Terrain::onRender(RenderWorld* rw, Scene* scene, f32 deltaTime)
         }
     }
     */
+    // the brush is only shown on frames that set it
+    if (brushFrame != g_game.frameCount)
+    {
+        brushSettings = { 1.f, 1.f, 1.f };
+        brushPosition = { 0, 0, 1000000 };
+    }
+
+    selectChunkLods(rw);
+
+    struct ChunkRenderData
+    {
+        Terrain* terrain;
+        u32 firstIndex;
+        u32 indexCount;
+        i32 baseVertex;
+    };
     auto renderDepth = [](void* renderData){
-        Terrain* terrain = (Terrain*)renderData;
-        glBindVertexArray(terrain->vao);
-        glDrawElements(GL_TRIANGLES, terrain->indexCount, GL_UNSIGNED_INT, 0);
+        ChunkRenderData* d = (ChunkRenderData*)renderData;
+        bindVertexArrayCached(d->terrain->vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT,
+                (void*)(uintptr_t)(d->firstIndex * sizeof(u32)), d->baseVertex);
     };
     auto renderColor = [](void* renderData){
-        Terrain* t = (Terrain*)renderData;
-        glBindTextureUnit(6, t->textures[0]->handle);
-        glBindTextureUnit(7, t->textures[1]->handle);
-        glBindTextureUnit(8, t->textures[2]->handle);
-        glBindTextureUnit(9, t->textures[3]->handle);
-        glBindTextureUnit(10, t->normalTextures[0]->handle);
-        glBindTextureUnit(11, t->normalTextures[1]->handle);
-        glBindTextureUnit(12, t->normalTextures[2]->handle);
-        glBindTextureUnit(13, t->normalTextures[3]->handle);
+        ChunkRenderData* d = (ChunkRenderData*)renderData;
+        Terrain* t = d->terrain;
+        bindTextureUnitCached(6, t->textures[0]->handle);
+        bindTextureUnitCached(7, t->textures[1]->handle);
+        bindTextureUnitCached(8, t->textures[2]->handle);
+        bindTextureUnitCached(9, t->textures[3]->handle);
+        bindTextureUnitCached(10, t->normalTextures[0]->handle);
+        bindTextureUnitCached(11, t->normalTextures[1]->handle);
+        bindTextureUnitCached(12, t->normalTextures[2]->handle);
+        bindTextureUnitCached(13, t->normalTextures[3]->handle);
 		if (g_game.isEditing)
 		{
 			glUniform3fv(3, 1, (GLfloat*)&t->brushSettings);
@@ -175,15 +199,42 @@ void Terrain::onRender(RenderWorld* rw, Scene* scene, f32 deltaTime)
 			glUniform3fv(8, 1, (f32*)&t->fresnel[2]);
 			glUniform3fv(9, 1, (f32*)&t->fresnel[3]);
 		}
-		glBindVertexArray(t->vao);
-        glDrawElements(GL_TRIANGLES, t->indexCount, GL_UNSIGNED_INT, 0);
-
-        // reset the brush settings every frame
-        t->setBrushSettings(1.f, 1.f, 1.f, { 0, 0, 1000000 });
+		bindVertexArrayCached(t->vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, d->indexCount, GL_UNSIGNED_INT,
+                (void*)(uintptr_t)(d->firstIndex * sizeof(u32)), d->baseVertex);
     };
-    rw->depthPrepass(depthShader, { this, renderDepth });
-    rw->shadowPass(depthShader, { this, renderDepth });
-    rw->opaqueColorPass(g_game.isEditing ? colorShaderWithBrush : colorShader, { this, renderColor });
+
+    i32 width = (i32)((x2 - x1) / tileSize);
+    ShaderHandle chunkColorShader = g_game.isEditing ? colorShaderWithBrush : colorShader;
+    u32 stateKey = makeStateKey(textures[0]->handle, vao);
+    for (auto& c : chunks)
+    {
+        Vec3 bmin(x1 + c.x * tileSize, y1 + c.y * tileSize, c.minZ);
+        Vec3 bmax(x1 + (c.x + c.width) * tileSize, y1 + (c.y + c.height) * tileSize, c.maxZ);
+        BoundingSphere bounds = { (bmin + bmax) * 0.5f, length(bmax - bmin) * 0.5f };
+        i32 baseVertex = c.y * width + c.x;
+
+        IndexRange const& range = indexRanges[(c.pattern * LOD_COUNT + c.lod) * 16 + c.edgeMask];
+        ChunkRenderData* d = g_tmpMem.bump<ChunkRenderData>();
+        *d = { this, range.first, range.count, baseVertex };
+
+        // the static shadows are cached, so they can afford full detail
+        IndexRange const& fullRange = indexRanges[c.pattern * LOD_COUNT * 16];
+        ChunkRenderData* shadowData = g_tmpMem.bump<ChunkRenderData>();
+        *shadowData = { this, fullRange.first, fullRange.count, baseVertex };
+
+        rw->depthPrepass(depthShader, { d, renderDepth, 0, bounds });
+        rw->staticShadowPass(depthShader, { shadowData, renderDepth, 0, bounds });
+        rw->opaqueColorPass(chunkColorShader, { d, renderColor, 0, bounds, stateKey });
+    }
+}
+
+void Terrain::setBrushSettings(f32 brushRadius, f32 brushFalloff, f32 brushStrength,
+        Vec3 brushPosition)
+{
+    this->brushSettings = { brushRadius, brushFalloff, brushStrength };
+    this->brushPosition = brushPosition;
+    brushFrame = g_game.frameCount;
 }
 
 void Terrain::regenerateMaterial()
@@ -207,10 +258,8 @@ void Terrain::regenerateMaterial()
 
 bool Terrain::isOffroadAt(f32 x, f32 y) const
 {
-    u32 ux = getCellX(x);
-    u32 uy = getCellX(y);
-    i32 width = (i32)((x2 - x1) / tileSize);
-    return (blend[uy * width + ux] & 0x00FF0000) > OFFROAD_THRESHOLD;
+    // matches the material of the collision, so it agrees with what the wheels touch
+    return getCellMaterialIndex(getCellX(x), getCellY(y)) == 1;
 }
 
 Vec3 Terrain::computeNormal(u32 width, u32 height, u32 x, u32 y)
@@ -225,113 +274,562 @@ Vec3 Terrain::computeNormal(u32 width, u32 height, u32 x, u32 y)
     return normalize(normal);
 }
 
-void Terrain::regenerateMesh()
+void Terrain::updateVertices(i32 minX, i32 minY, i32 maxX, i32 maxY)
 {
-    // TODO: Update just the section of the mesh that has changed (buffer subdata)
-    if (!isDirty) { return; }
-    isDirty = false;
     i32 width = (i32)((x2 - x1) / tileSize);
     i32 height = (i32)((y2 - y1) / tileSize);
-	u32 indexIndex = 0;
-    for (i32 x = 0; x < width; ++x)
+    for (i32 y = minY; y <= maxY; ++y)
     {
-        for (i32 y = 0; y < height; ++y)
+        for (i32 x = minX; x <= maxX; ++x)
         {
-            f32 z = heightBuffer[(y * width) + x];
-            Vec3 pos(x1 + x * tileSize, y1 + y * tileSize, z);
-            Vec3 normal = computeNormal(width, height, x, y);
             u32 i = y * width + x;
             vertices[i] = {
-                pos,
-                normal,
+                Vec3(x1 + x * tileSize, y1 + y * tileSize, heightBuffer[i]),
+                computeNormal(width, height, x, y),
                 blend[i]
             };
-            if (x < width - 1 && y < height - 1)
+        }
+    }
+}
+
+void Terrain::regenerateMesh()
+{
+    if (!isDirty) { return; }
+    isDirty = false;
+    hasMeshChanged = true;
+    f64 startTime = getTime();
+    i32 width = (i32)((x2 - x1) / tileSize);
+    i32 height = (i32)((y2 - y1) / tileSize);
+
+    if (!isFullRebuildNeeded)
+    {
+        // normals come from the neighbouring heights, and the clamped normals at the edges reach
+        // two cells in
+        i32 minX = max(dirtyMinX - 2, 0);
+        i32 minY = max(dirtyMinY - 2, 0);
+        i32 maxX = min(dirtyMaxX + 2, width - 1);
+        i32 maxY = min(dirtyMaxY + 2, height - 1);
+        updateVertices(minX, minY, maxX, maxY);
+        updateChunks(minX, minY, maxX, maxY);
+
+        // the vertices are stored in rows, so a narrow region is uploaded one row at a time
+        u32 rowLength = maxX - minX + 1;
+        if (rowLength * 2 >= (u32)width)
+        {
+            u32 first = minY * width + minX;
+            u32 count = maxY * width + maxX + 1 - first;
+            glNamedBufferSubData(vbo, first * sizeof(Vertex), count * sizeof(Vertex),
+                    vertices.get() + first);
+        }
+        else
+        {
+            for (i32 y = minY; y <= maxY; ++y)
             {
-                if ((x & 1) ? (y & 1) : !(y & 1))
-                {
-					indices[indexIndex + 0] = y * width + x;
-                    indices[indexIndex + 1] = y * width + x + 1;
-                    indices[indexIndex + 2] = (y + 1) * width + x;
+                u32 first = y * width + minX;
+                glNamedBufferSubData(vbo, first * sizeof(Vertex), rowLength * sizeof(Vertex),
+                        vertices.get() + first);
+            }
+        }
+        lastMeshUpdateVertexCount = rowLength * (maxY - minY + 1);
+        lastMeshUpdateTime = getTime() - startTime;
+        return;
+    }
+
+    isFullRebuildNeeded = false;
+    updateVertices(0, 0, width - 1, height - 1);
+    // the indices only depend on the size of the terrain
+    buildChunks(width, height);
+    glNamedBufferData(vbo, heightBufferSize * sizeof(Vertex), vertices.get(), GL_DYNAMIC_DRAW);
+    glNamedBufferData(ebo, indices.size() * sizeof(u32), indices.data(), GL_DYNAMIC_DRAW);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(vao, ebo);
+    lastMeshUpdateVertexCount = heightBufferSize;
+    lastMeshUpdateTime = getTime() - startTime;
+}
+
+static i32 getChunkCount(i32 cells, i32 chunkSize)
+{
+    // a remainder shorter than half a chunk is added to the last chunk
+    return max((cells + chunkSize / 2) / chunkSize, 1);
+}
 
-                    indices[indexIndex + 3] = (y + 1) * width + x;
-                    indices[indexIndex + 4] = y * width + x + 1;
-                    indices[indexIndex + 5] = (y + 1) * width + x + 1;
+// The offsets within a chunk of the vertices used at a lod step. The last span is stretched to the
+// edge, and merged with the one before it if it would be less than half a step, so that the
+// samples of a lod are always a subset of the samples of the lod before it.
+static void getLodSamples(i32 size, i32 step, Array<i32>& samples)
+{
+    samples.clear();
+    for (i32 i = 0; i < size; i += step)
+    {
+        samples.push(i);
+    }
+    if (samples.size() > 1 && size - samples.back() < step / 2)
+    {
+        samples.pop();
+    }
+    samples.push(size);
+}
+
+static bool hasLod(i32 chunkWidth, i32 chunkHeight, u32 lod, Array<i32>& samples)
+{
+    // stitching needs a row of vertices between opposite edges
+    getLodSamples(chunkWidth, 1 << lod, samples);
+    if (samples.size() < 3)
+    {
+        return lod == 0;
+    }
+    getLodSamples(chunkHeight, 1 << lod, samples);
+    return samples.size() >= 3 || lod == 0;
+}
+
+void Terrain::buildChunks(i32 width, i32 height)
+{
+    i32 cellsX = width - 1;
+    i32 cellsY = height - 1;
+    chunkCountX = getChunkCount(cellsX, CHUNK_SIZE);
+    chunkCountY = getChunkCount(cellsY, CHUNK_SIZE);
+    i32 lastChunkWidth = cellsX - (chunkCountX - 1) * CHUNK_SIZE;
+    i32 lastChunkHeight = cellsY - (chunkCountY - 1) * CHUNK_SIZE;
+
+    chunks.clear();
+    for (i32 cy = 0; cy < chunkCountY; ++cy)
+    {
+        for (i32 cx = 0; cx < chunkCountX; ++cx)
+        {
+            Chunk c;
+            c.x = cx * CHUNK_SIZE;
+            c.y = cy * CHUNK_SIZE;
+            bool isLastX = cx == chunkCountX - 1;
+            bool isLastY = cy == chunkCountY - 1;
+            c.width = isLastX ? lastChunkWidth : CHUNK_SIZE;
+            c.height = isLastY ? lastChunkHeight : CHUNK_SIZE;
+            c.pattern = (isLastX ? 1 : 0) + (isLastY ? 2 : 0);
+            c.maxLod = 0;
+            while (c.maxLod + 1 < LOD_COUNT && hasLod(c.width, c.height, c.maxLod + 1, lodSamplesX))
+            {
+                ++c.maxLod;
+            }
+            c.lod = 0;
+            c.edgeMask = 0;
+            updateChunk(c, width);
+            chunks.push(c);
+        }
+    }
+
+    indices.clear();
+    for (u32 pattern = 0; pattern < PATTERN_COUNT; ++pattern)
+    {
+        bool isLastX = pattern & 1;
+        bool isLastY = pattern & 2;
+        bool isUsed = (isLastX || chunkCountX > 1) && (isLastY || chunkCountY > 1);
+        i32 chunkWidth = isLastX ? lastChunkWidth : CHUNK_SIZE;
+        i32 chunkHeight = isLastY ? lastChunkHeight : CHUNK_SIZE;
+        for (u32 lod = 0; lod < LOD_COUNT; ++lod)
+        {
+            bool isLodUsed = isUsed && hasLod(chunkWidth, chunkHeight, lod, lodSamplesX);
+            for (u32 edgeMask = 0; edgeMask < 16; ++edgeMask)
+            {
+                IndexRange& range = indexRanges[(pattern * LOD_COUNT + lod) * 16 + edgeMask];
+                range.first = indices.size();
+                if (isLodUsed)
+                {
+                    addChunkIndices(chunkWidth, chunkHeight, 1 << lod, edgeMask, width);
                 }
-                else
+                range.count = indices.size() - range.first;
+            }
+        }
+    }
+}
+
+void Terrain::addChunkIndices(i32 chunkWidth, i32 chunkHeight, i32 step, u32 edgeMask,
+        i32 rowStride)
+{
+    auto addTriangle = [&](i32 ax, i32 ay, i32 bx, i32 by, i32 cx, i32 cy) {
+        // counter-clockwise when seen from above
+        if ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax) < 0)
+        {
+            i32 tx = bx, ty = by;
+            bx = cx; by = cy;
+            cx = tx; cy = ty;
+        }
+        indices.push(ay * rowStride + ax);
+        indices.push(by * rowStride + bx);
+        indices.push(cy * rowStride + cx);
+    };
+    // alternate the diagonals the same way as the collision height field
+    auto addQuad = [&](i32 qx1, i32 qy1, i32 qx2, i32 qy2, bool flip) {
+        if (flip)
+        {
+            addTriangle(qx1, qy1, qx2, qy1, qx1, qy2);
+            addTriangle(qx1, qy2, qx2, qy1, qx2, qy2);
+        }
+        else
+        {
+            addTriangle(qx1, qy1, qx2, qy1, qx2, qy2);
+            addTriangle(qx2, qy2, qx1, qy2, qx1, qy1);
+        }
+    };
+
+    Array<i32>& xs = lodSamplesX;
+    Array<i32>& ys = lodSamplesY;
+    getLodSamples(chunkWidth, step, xs);
+    getLodSamples(chunkHeight, step, ys);
+    i32 nx = (i32)xs.size();
+    i32 ny = (i32)ys.size();
+
+    if (edgeMask == 0 || nx < 3 || ny < 3)
+    {
+        for (i32 j = 0; j < ny - 1; ++j)
+        {
+            for (i32 i = 0; i < nx - 1; ++i)
+            {
+                addQuad(xs[i], ys[j], xs[i + 1], ys[j + 1], (i & 1) == (j & 1));
+            }
+        }
+        return;
+    }
+
+    // the inside of the chunk is a regular grid
+    for (i32 j = 1; j < ny - 2; ++j)
+    {
+        for (i32 i = 1; i < nx - 2; ++i)
+        {
+            addQuad(xs[i], ys[j], xs[i + 1], ys[j + 1], (i & 1) == (j & 1));
+        }
+    }
+
+    // Each edge (left, right, bottom, top) is joined to the outermost row or column of the inside
+    // by walking along both and always advancing the one that is further behind. An edge next to a
+    // coarser chunk only uses the vertices that the coarser chunk has, so there are no cracks.
+    Array<i32>& edge = lodSamplesEdge;
+    for (u32 side = 0; side < 4; ++side)
+    {
+        bool isVertical = side < 2;
+        Array<i32> const& along = isVertical ? ys : xs;
+        i32 size = isVertical ? chunkHeight : chunkWidth;
+        if (edgeMask & (1 << side))
+        {
+            getLodSamples(size, step * 2, edge);
+        }
+        else
+        {
+            edge = along;
+        }
+        i32 outer = side == 0 ? 0 : side == 1 ? chunkWidth : side == 2 ? 0 : chunkHeight;
+        i32 inner = side == 0 ? xs[1] : side == 1 ? xs[nx - 2] : side == 2 ? ys[1] : ys[ny - 2];
+        auto add = [&](i32 t1, i32 line1, i32 t2, i32 line2, i32 t3, i32 line3) {
+            if (isVertical)
+            {
+                addTriangle(line1, t1, line2, t2, line3, t3);
+            }
+            else
+            {
+                addTriangle(t1, line1, t2, line2, t3, line3);
+            }
+        };
+
+        u32 a = 0;
+        u32 b = 1;
+        u32 lastA = edge.size() - 1;
+        u32 lastB = along.size() - 2;
+        while (a < lastA || b < lastB)
+        {
+            if (b == lastB || (a < lastA && edge[a + 1] <= along[b + 1]))
+            {
+                add(edge[a], outer, edge[a + 1], outer, along[b], inner);
+                ++a;
+            }
+            else
+            {
+                add(edge[a], outer, along[b], inner, along[b + 1], inner);
+                ++b;
+            }
+        }
+    }
+}
+
+void Terrain::updateChunks(i32 minX, i32 minY, i32 maxX, i32 maxY)
+{
+    i32 width = (i32)((x2 - x1) / tileSize);
+    for (auto& c : chunks)
+    {
+        // vertices on the border belong to both chunks
+        if (c.x <= maxX && c.x + c.width >= minX && c.y <= maxY && c.y + c.height >= minY)
+        {
+            updateChunk(c, width);
+        }
+    }
+}
+
+void Terrain::updateChunk(Chunk& c, i32 width)
+{
+    f32 const* heights = heightBuffer.get() + c.y * width + c.x;
+    c.minZ = FLT_MAX;
+    c.maxZ = -FLT_MAX;
+    for (i32 y = 0; y <= c.height; ++y)
+    {
+        for (i32 x = 0; x <= c.width; ++x)
+        {
+            c.minZ = min(c.minZ, heights[y * width + x]);
+            c.maxZ = max(c.maxZ, heights[y * width + x]);
+        }
+    }
+
+    c.lodError[0] = 0.f;
+    Array<i32>& xs = lodSamplesX;
+    Array<i32>& ys = lodSamplesY;
+    for (u32 lod = 1; lod < LOD_COUNT; ++lod)
+    {
+        if (lod > c.maxLod)
+        {
+            c.lodError[lod] = FLT_MAX;
+            continue;
+        }
+        // measured against the bilinear surface through the lod's vertices, which is close
+        // enough to its triangles
+        getLodSamples(c.width, 1 << lod, xs);
+        getLodSamples(c.height, 1 << lod, ys);
+        f32 error = c.lodError[lod - 1];
+        for (u32 j = 0; j < ys.size() - 1; ++j)
+        {
+            for (u32 i = 0; i < xs.size() - 1; ++i)
+            {
+                f32 h00 = heights[ys[j] * width + xs[i]];
+                f32 h10 = heights[ys[j] * width + xs[i + 1]];
+                f32 h01 = heights[ys[j + 1] * width + xs[i]];
+                f32 h11 = heights[ys[j + 1] * width + xs[i + 1]];
+                for (i32 y = ys[j]; y <= ys[j + 1]; ++y)
                 {
-                    indices[indexIndex + 0] = y * width + x;
-                    indices[indexIndex + 1] = y * width + x + 1;
-                    indices[indexIndex + 2] = (y + 1) * width + x + 1;
+                    f32 ty = (f32)(y - ys[j]) / (f32)(ys[j + 1] - ys[j]);
+                    f32 left = lerp(h00, h01, ty);
+                    f32 right = lerp(h10, h11, ty);
+                    for (i32 x = xs[i]; x <= xs[i + 1]; ++x)
+                    {
+                        f32 tx = (f32)(x - xs[i]) / (f32)(xs[i + 1] - xs[i]);
+                        error = max(error, absolute(heights[y * width + x] - lerp(left, right, tx)));
+                    }
+                }
+            }
+        }
+        c.lodError[lod] = error;
+    }
+}
 
-                    indices[indexIndex + 3] = (y + 1) * width + x + 1;
-                    indices[indexIndex + 4] = (y + 1) * width + x;
-                    indices[indexIndex + 5] = y * width + x;
+void Terrain::selectChunkLods(RenderWorld* rw)
+{
+    u32 cameraCount = rw->getViewportCount();
+    f32 viewportHeight = cameraCount > 0
+        ? rw->getHeight() * viewportLayout[cameraCount - 1].scale.y : 0.f;
+    for (auto& c : chunks)
+    {
+        c.lod = 0;
+        if (!isLodEnabled || cameraCount == 0)
+        {
+            continue;
+        }
+        Vec3 bmin(x1 + c.x * tileSize, y1 + c.y * tileSize, c.minZ);
+        Vec3 bmax(x1 + (c.x + c.width) * tileSize, y1 + (c.y + c.height) * tileSize, c.maxZ);
+
+        // the height error allowed for the chunk, from the camera that sees it largest
+        f32 allowedError = FLT_MAX;
+        for (u32 i=0; i<cameraCount; ++i)
+        {
+            Camera const& cam = rw->getCamera(i);
+            Vec3 closest = max(min(cam.position, bmax), bmin);
+            f32 distance = max(length(cam.position - closest), 1.f);
+            f32 pixelsPerUnit = viewportHeight / (2.f * tanf(radians(cam.fov) * 0.5f) * distance);
+            allowedError = min(allowedError, maxLodScreenError / pixelsPerUnit);
+        }
+        while (c.lod < c.maxLod && c.lodError[c.lod + 1] <= allowedError)
+        {
+            ++c.lod;
+        }
+    }
+
+    // neighbours can only be stitched to one lod coarser, so chunks are refined until that holds
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (i32 cy = 0; cy < chunkCountY; ++cy)
+        {
+            for (i32 cx = 0; cx < chunkCountX; ++cx)
+            {
+                Chunk& c = chunks[cy * chunkCountX + cx];
+                u32 lod = c.lod;
+                if (cx > 0) lod = min(lod, chunks[cy * chunkCountX + cx - 1].lod + 1);
+                if (cx < chunkCountX - 1) lod = min(lod, chunks[cy * chunkCountX + cx + 1].lod + 1);
+                if (cy > 0) lod = min(lod, chunks[(cy - 1) * chunkCountX + cx].lod + 1);
+                if (cy < chunkCountY - 1) lod = min(lod, chunks[(cy + 1) * chunkCountX + cx].lod + 1);
+                if (lod != c.lod)
+                {
+                    c.lod = lod;
+                    changed = true;
                 }
-				indexIndex += 6;
             }
         }
     }
-	indexCount = indexIndex;
-    glNamedBufferData(vbo, heightBufferSize * sizeof(Vertex), vertices.get(), GL_DYNAMIC_DRAW);
-    glNamedBufferData(ebo, indexCount * sizeof(u32), indices.get(), GL_DYNAMIC_DRAW);
-    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-    glVertexArrayElementBuffer(vao, ebo);
+
+    for (u32 i=0; i<LOD_COUNT; ++i)
+    {
+        lastLodChunkCount[i] = 0;
+    }
+    lastTriangleCount = 0;
+    lastFullDetailTriangleCount = 0;
+    for (i32 cy = 0; cy < chunkCountY; ++cy)
+    {
+        for (i32 cx = 0; cx < chunkCountX; ++cx)
+        {
+            Chunk& c = chunks[cy * chunkCountX + cx];
+            c.edgeMask = 0;
+            if (cx > 0 && chunks[cy * chunkCountX + cx - 1].lod > c.lod) c.edgeMask |= 1;
+            if (cx < chunkCountX - 1 && chunks[cy * chunkCountX + cx + 1].lod > c.lod) c.edgeMask |= 2;
+            if (cy > 0 && chunks[(cy - 1) * chunkCountX + cx].lod > c.lod) c.edgeMask |= 4;
+            if (cy < chunkCountY - 1 && chunks[(cy + 1) * chunkCountX + cx].lod > c.lod) c.edgeMask |= 8;
+            ++lastLodChunkCount[c.lod];
+            lastTriangleCount +=
+                indexRanges[(c.pattern * LOD_COUNT + c.lod) * 16 + c.edgeMask].count / 3;
+            lastFullDetailTriangleCount += indexRanges[c.pattern * LOD_COUNT * 16].count / 3;
+        }
+    }
+}
+
+u8 Terrain::getCellMaterialIndex(i32 x, i32 y) const
+{
+    // a cell is offroad if any of its corners are
+    i32 width = (i32)((x2 - x1) / tileSize);
+    i32 height = (i32)((y2 - y1) / tileSize);
+    i32 nx = min(x + 1, width - 1);
+    i32 ny = min(y + 1, height - 1);
+    u32 threshold = OFFROAD_THRESHOLD;
+    return ((blend[y * width + x] & 0x00FF0000) > threshold ||
+            (blend[y * width + nx] & 0x00FF0000) > threshold ||
+            (blend[ny * width + x] & 0x00FF0000) > threshold ||
+            (blend[ny * width + nx] & 0x00FF0000) > threshold) ? 1 : 0;
+}
+
+bool Terrain::fillHeightFieldSamples(i32 minX, i32 minY, i32 maxX, i32 maxY)
+{
+    i32 width = (i32)((x2 - x1) / tileSize);
+    heightFieldSamples.resize((maxX - minX + 1) * (maxY - minY + 1));
+    PxHeightFieldSample* sample = heightFieldSamples.data();
+    f32 invScale = 1.f / heightFieldScale;
+    for (i32 y = minY; y <= maxY; ++y)
+    {
+        for (i32 x = minX; x <= maxX; ++x)
+        {
+            f32 h = roundf(heightBuffer[y * width + x] * invScale);
+            if (absolute(h) > 32767.f)
+            {
+                return false;
+            }
+            u8 materialIndex = getCellMaterialIndex(x, y);
+            sample->height = (PxI16)h;
+            sample->materialIndex0 = PxBitAndByte(materialIndex);
+            sample->materialIndex1 = PxBitAndByte(materialIndex);
+            // split the cells along the same diagonals as the render mesh
+            if ((x ^ y) & 1)
+            {
+                sample->setTessFlag();
+            }
+            else
+            {
+                sample->clearTessFlag();
+            }
+            ++sample;
+        }
+    }
+    return true;
 }
 
 void Terrain::regenerateCollisionMesh(Scene* scene)
 {
     if (!isCollisionMeshDirty) { return; }
     isCollisionMeshDirty = false;
-    PxTriangleMeshDesc desc;
-    desc.points.count = heightBufferSize;
-    desc.points.stride = sizeof(Vertex);
-    desc.points.data = vertices.get();
-    desc.triangles.count = indexCount / 3;
-    desc.triangles.stride = 3 * sizeof(indices[0]);
-    desc.triangles.data = indices.get();
+    f64 startTime = getTime();
+    i32 width = (i32)((x2 - x1) / tileSize);
+    i32 height = (i32)((y2 - y1) / tileSize);
 
-	u32 materialIndexCount = indexCount / 3;
-    materialIndices.reset(new PxMaterialTableIndex[materialIndexCount]);
-    for (u32 i=0; i<materialIndexCount; ++i)
+    // Rows of the height field run along y and columns along x, so the samples have the same
+    // layout as the height buffer. Its local y axis is up, which this rotation turns into z.
+    PxTransform localPose(PxVec3(x1, y1, 0.f), PxQuat(0.5f, 0.5f, 0.5f, 0.5f));
+    PxShape* shape = nullptr;
+    if (actor->getNbShapes() > 0)
     {
-        u32 threshold = OFFROAD_THRESHOLD;
-        u32 vertexIndex1 = indices[i * 3 + 0];
-        u32 vertexIndex2 = indices[i * 3 + 1];
-        u32 vertexIndex3 = indices[i * 3 + 2];
-        materialIndices[i] = ((blend[vertexIndex1] & 0x00FF0000) > threshold ||
-                              (blend[vertexIndex2] & 0x00FF0000) > threshold ||
-                              (blend[vertexIndex3] & 0x00FF0000) > threshold) ? 1 : 0;
+        actor->getShapes(&shape, 1);
     }
 
-    PxTypedStridedData<PxMaterialTableIndex> materialIndexData;
-    materialIndexData.data = materialIndices.get();
-    materialIndexData.stride = sizeof(PxMaterialTableIndex);
-    desc.materialIndices = materialIndexData;
+    if (shape && heightField && !isCollisionFullRebuildNeeded)
+    {
+        // the material of a cell depends on the corners after it
+        i32 minX = max(collisionDirtyMinX - 1, 0);
+        i32 minY = max(collisionDirtyMinY - 1, 0);
+        i32 maxX = collisionDirtyMaxX;
+        i32 maxY = collisionDirtyMaxY;
+        if (fillHeightFieldSamples(minX, minY, maxX, maxY))
+        {
+            PxHeightFieldDesc desc;
+            desc.format = PxHeightFieldFormat::eS16_TM;
+            desc.nbColumns = maxX - minX + 1;
+            desc.nbRows = maxY - minY + 1;
+            desc.samples.data = heightFieldSamples.data();
+            desc.samples.stride = sizeof(PxHeightFieldSample);
+            heightField->modifySamples(minX, minY, desc, true);
+            // updates the bounds of the shape
+            shape->setGeometry(PxHeightFieldGeometry(heightField, PxMeshGeometryFlags(),
+                        heightFieldScale, tileSize, tileSize));
+            lastCollisionUpdateSampleCount = desc.nbColumns * desc.nbRows;
+            lastCollisionUpdateTime = getTime() - startTime;
+            return;
+        }
+        // a height is out of range of the current scale, so everything has to be requantized
+    }
+    isCollisionFullRebuildNeeded = false;
 
-    PxDefaultMemoryOutputStream writeBuffer;
-    if (!g_game.physx.cooking->cookTriangleMesh(desc, writeBuffer))
+    // leave room for sculpting so that later edits can keep updating just their region
+    f32 maxHeight = 0.f;
+    for (u32 i=0; i<heightBufferSize; ++i)
     {
-        FATAL_ERROR("Failed to create collision mesh for terrain");
+        maxHeight = max(maxHeight, absolute(heightBuffer[i]));
+    }
+    heightFieldScale = max(maxHeight * 2.f, 64.f) / 32767.f;
+    fillHeightFieldSamples(0, 0, width - 1, height - 1);
+
+    PxHeightFieldDesc desc;
+    desc.format = PxHeightFieldFormat::eS16_TM;
+    desc.nbColumns = width;
+    desc.nbRows = height;
+    desc.samples.data = heightFieldSamples.data();
+    desc.samples.stride = sizeof(PxHeightFieldSample);
+    PxHeightField* newHeightField = g_game.physx.cooking->createHeightField(desc,
+            g_game.physx.physics->getPhysicsInsertionCallback());
+    if (!newHeightField)
+    {
+        FATAL_ERROR("Failed to create height field for terrain");
     }
 
-    PxDefaultMemoryInputData readBuffer(writeBuffer.getData(), writeBuffer.getSize());
-    PxTriangleMesh* triMesh = g_game.physx.physics->createTriangleMesh(readBuffer);
-    if (actor->getNbShapes() > 0)
+    PxHeightFieldGeometry geometry(newHeightField, PxMeshGeometryFlags(),
+            heightFieldScale, tileSize, tileSize);
+    if (shape)
     {
-        PxShape* shape;
-        actor->getShapes(&shape, 1);
-        shape->setGeometry(PxTriangleMeshGeometry(triMesh));
+        shape->setGeometry(geometry);
+        shape->setLocalPose(localPose);
     }
     else
     {
-        PxShape* shape = PxRigidActorExt::createExclusiveShape(*actor,
-                PxTriangleMeshGeometry(triMesh), materials, ARRAY_SIZE(materials));
+        shape = PxRigidActorExt::createExclusiveShape(*actor, geometry, materials, ARRAY_SIZE(materials));
+        shape->setLocalPose(localPose);
         shape->setQueryFilterData(PxFilterData(COLLISION_FLAG_TERRAIN, DECAL_TERRAIN, 0, DRIVABLE_SURFACE));
         shape->setSimulationFilterData(PxFilterData(COLLISION_FLAG_TERRAIN, -1, 0, 0));
         shape->setFlag(PxShapeFlag::eVISUALIZATION, false);
     }
-    triMesh->release();
+    if (heightField)
+    {
+        heightField->release();
+    }
+    heightField = newHeightField;
+    lastCollisionUpdateSampleCount = heightBufferSize;
+    lastCollisionUpdateTime = getTime() - startTime;
 }
 
 f32 Terrain::getZ(Vec2 pos) const
@@ -367,6 +865,95 @@ i32 Terrain::getCellY(f32 y) const
     return clamp((i32)((y - y1) / tileSize), 0, height - 1);
 }
 
+// Brushes go through their rows four cells at a time, and big brushes split the rows across
+// the worker threads
+static constexpr u32 BRUSH_ROWS_PER_TASK = 8;
+static constexpr u32 MIN_PARALLEL_BRUSH_CELLS = 4096;
+
+template <typename T>
+static void forEachBrushRow(i32 minY, i32 maxY, u32 cellCount, bool isMultithreaded, T const& fn,
+        u32 minParallelCells=MIN_PARALLEL_BRUSH_CELLS)
+{
+    if (!isMultithreaded || cellCount < minParallelCells)
+    {
+        for (i32 y = minY; y <= maxY; ++y)
+        {
+            fn(y);
+        }
+        return;
+    }
+    g_threadPool.parallelFor((u32)(maxY - minY + 1), BRUSH_ROWS_PER_TASK, [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i)
+        {
+            fn(minY + (i32)i);
+        }
+    });
+}
+
+// loads and stores up to four floats, for the end of a row
+static inline __m128 loadCells(f32 const* p, i32 count)
+{
+    if (count >= 4)
+    {
+        return _mm_loadu_ps(p);
+    }
+    alignas(16) f32 v[4] = {};
+    for (i32 i = 0; i < count; ++i)
+    {
+        v[i] = p[i];
+    }
+    return _mm_load_ps(v);
+}
+
+static inline void storeCells(f32* p, __m128 v, i32 count)
+{
+    if (count >= 4)
+    {
+        _mm_storeu_ps(p, v);
+        return;
+    }
+    alignas(16) f32 tmp[4];
+    _mm_store_ps(tmp, v);
+    for (i32 i = 0; i < count; ++i)
+    {
+        p[i] = tmp[i];
+    }
+}
+
+struct BrushWeights
+{
+    f32 x1, y1, tileSize;
+    Vec2 pos;
+    f32 radius;
+    f32 falloff;
+
+    // the falloff of the brush at cells x to x+3 of row y
+    __m128 get(i32 x, i32 y) const
+    {
+        __m128 cellX = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0)));
+        __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(x1), _mm_mul_ps(cellX, _mm_set1_ps(tileSize))),
+                _mm_set1_ps(pos.x));
+        f32 dy = y1 + y * tileSize - pos.y;
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_set1_ps(dy * dy)));
+        __m128 t = _mm_sub_ps(_mm_set1_ps(1.f), _mm_div_ps(distance, _mm_set1_ps(radius)));
+        t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        if (falloff != 1.f)
+        {
+            alignas(16) f32 w[4];
+            _mm_store_ps(w, t);
+            for (u32 i=0; i<4; ++i)
+            {
+                if (w[i] > 0.f && w[i] < 1.f)
+                {
+                    w[i] = powf(w[i], falloff);
+                }
+            }
+            t = _mm_load_ps(w);
+        }
+        return t;
+    }
+};
+
 void Terrain::raise(Vec2 pos, f32 radius, f32 falloff, f32 amount)
 {
     i32 minX = getCellX(pos.x - radius);
@@ -374,16 +961,19 @@ void Terrain::raise(Vec2 pos, f32 radius, f32 falloff, f32 amount)
     i32 maxX = getCellX(pos.x + radius);
     i32 maxY = getCellY(pos.y + radius);
     i32 width = (i32)((x2 - x1) / tileSize);
-    for (i32 x=minX; x<=maxX; ++x)
-    {
-        for (i32 y=minY; y<=maxY; ++y)
+    BrushWeights brush = { x1, y1, tileSize, pos, radius, falloff };
+    u32 cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+    forEachBrushRow(minY, maxY, cellCount, isBrushMultithreaded, [&](i32 y) {
+        f32* row = heightBuffer.get() + y * width;
+        for (i32 x=minX; x<=maxX; x+=4)
         {
-            Vec2 p(x1 + x * tileSize, y1 + y * tileSize);
-            f32 t = powf(clamp(1.f - (length(pos - p) / radius), 0.f, 1.f), falloff);
-            heightBuffer[y * width + x] += t * amount;
+            i32 count = maxX - x + 1;
+            __m128 t = brush.get(x, y);
+            __m128 h = loadCells(row + x, count);
+            storeCells(row + x, _mm_add_ps(h, _mm_mul_ps(t, _mm_set1_ps(amount))), count);
         }
-    }
-    setDirty();
+    });
+    setDirty(minX, minY, maxX, maxY);
 }
 
 void Terrain::perturb(Vec2 pos, f32 radius, f32 falloff, f32 amount)
@@ -406,7 +996,7 @@ void Terrain::perturb(Vec2 pos, f32 radius, f32 falloff, f32 amount)
 #endif
         }
     }
-    setDirty();
+    setDirty(minX, minY, maxX, maxY);
 }
 
 void Terrain::flatten(Vec2 pos, f32 radius, f32 falloff, f32 amount, f32 z)
@@ -416,17 +1006,19 @@ void Terrain::flatten(Vec2 pos, f32 radius, f32 falloff, f32 amount, f32 z)
     i32 maxX = getCellX(pos.x + radius);
     i32 maxY = getCellY(pos.y + radius);
     i32 width = (i32)((x2 - x1) / tileSize);
-    for (i32 x=minX; x<=maxX; ++x)
-    {
-        for (i32 y=minY; y<=maxY; ++y)
+    BrushWeights brush = { x1, y1, tileSize, pos, radius, falloff };
+    u32 cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+    forEachBrushRow(minY, maxY, cellCount, isBrushMultithreaded, [&](i32 y) {
+        f32* row = heightBuffer.get() + y * width;
+        for (i32 x=minX; x<=maxX; x+=4)
         {
-            Vec2 p(x1 + x * tileSize, y1 + y * tileSize);
-            f32 t = powf(clamp(1.f - (length(pos - p) / radius), 0.f, 1.f), falloff);
-            f32 currentZ = heightBuffer[y * width + x];
-            heightBuffer[y * width + x] += (z - currentZ) * t * amount;
+            i32 count = maxX - x + 1;
+            __m128 t = _mm_mul_ps(brush.get(x, y), _mm_set1_ps(amount));
+            __m128 h = loadCells(row + x, count);
+            storeCells(row + x, _mm_add_ps(h, _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(z), h), t)), count);
         }
-    }
-    setDirty();
+    });
+    setDirty(minX, minY, maxX, maxY);
 }
 
 void Terrain::smooth(Vec2 pos, f32 radius, f32 falloff, f32 amount)
@@ -437,22 +1029,42 @@ void Terrain::smooth(Vec2 pos, f32 radius, f32 falloff, f32 amount)
     i32 maxY = getCellY(pos.y + radius);
     i32 width = (i32)((x2 - x1) / tileSize);
     i32 height = (i32)((y2 - y1) / tileSize);
-    for (i32 x=minX; x<=maxX; ++x)
+
+    // the heights are averaged from a copy so that the rows don't depend on each other, with a
+    // border of one cell clamped to the edges of the terrain
+    i32 copyWidth = maxX - minX + 3;
+    i32 copyHeight = maxY - minY + 3;
+    Array<f32> copy(copyWidth * copyHeight);
+    for (i32 cy = 0; cy < copyHeight; ++cy)
     {
-        for (i32 y=minY; y<=maxY; ++y)
+        f32 const* row = heightBuffer.get() + clamp(minY - 1 + cy, 0, height - 1) * width;
+        for (i32 cx = 0; cx < copyWidth; ++cx)
         {
-            Vec2 p(x1 + x * tileSize, y1 + y * tileSize);
-            f32 t = powf(clamp(1.f - (length(pos - p) / radius), 0.f, 1.f), falloff);
-            f32 hl = heightBuffer[y * width + clamp(x - 1, 0, width - 1)];
-            f32 hr = heightBuffer[y * width + clamp(x + 1, 0, width - 1)];
-            f32 hd = heightBuffer[clamp(y - 1, 0, height - 1) * width + x];
-            f32 hu = heightBuffer[clamp(y + 1, 0, height - 1) * width + x];
-            f32 currentZ = heightBuffer[y * width + x];
-            f32 average = (hl + hr + hd + hu) * 0.25f;
-            heightBuffer[y * width + x] += (average - currentZ) * t * amount;
+            copy[cy * copyWidth + cx] = row[clamp(minX - 1 + cx, 0, width - 1)];
         }
     }
-    setDirty();
+
+    BrushWeights brush = { x1, y1, tileSize, pos, radius, falloff };
+    u32 cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+    forEachBrushRow(minY, maxY, cellCount, isBrushMultithreaded, [&](i32 y) {
+        f32* row = heightBuffer.get() + y * width;
+        f32 const* center = copy.data() + (y - minY + 1) * copyWidth + 1;
+        f32 const* down = center - copyWidth;
+        f32 const* up = center + copyWidth;
+        for (i32 x=minX; x<=maxX; x+=4)
+        {
+            i32 count = maxX - x + 1;
+            i32 i = x - minX;
+            __m128 t = _mm_mul_ps(brush.get(x, y), _mm_set1_ps(amount));
+            __m128 h = loadCells(center + i, count);
+            __m128 sum = _mm_add_ps(
+                    _mm_add_ps(loadCells(center + i - 1, count), loadCells(center + i + 1, count)),
+                    _mm_add_ps(loadCells(down + i, count), loadCells(up + i, count)));
+            __m128 average = _mm_mul_ps(sum, _mm_set1_ps(0.25f));
+            storeCells(row + x, _mm_add_ps(h, _mm_mul_ps(_mm_sub_ps(average, h), t)), count);
+        }
+    });
+    setDirty(minX, minY, maxX, maxY);
 }
 
 // adapted from http://ranmantaru.com/blog/2011/10/08/water-erosion-on-heightmap-terrain/
@@ -477,8 +1089,6 @@ void Terrain::erode(Vec2 pos, f32 radius, f32 falloff, f32 amount)
     f32 Kg = g * 2;
     f32 scale = 40.f;
 
-    OwnedPtr<Vec2[]> erosion(new Vec2[width * height]);
-
     const u32 MAX_PATH_LEN = 10;
 
 #define HMAP(X, Y) (heightBuffer[(Y) * width + (X)] / scale)
@@ -486,8 +1096,7 @@ void Terrain::erode(Vec2 pos, f32 radius, f32 falloff, f32 amount)
 #define DEPOSIT_AT(X, Z, W) \
 { \
 f32 delta = ds * (W) * amount; \
-erosion[clamp((Z) * width + (X), 0, (i32)heightBufferSize)].y += delta; \
-heightBuffer[clamp((Z) * width + (X), 0, (i32)heightBufferSize)] += delta * scale; \
+heightBuffer[(Z) * width + (X)] += delta * scale; \
 }
 
 #define DEPOSIT(H) \
@@ -497,135 +1106,211 @@ DEPOSIT_AT(xi  , zi+1, (1-xf)*   zf ) \
 DEPOSIT_AT(xi+1, zi+1,    xf *   zf ) \
 (H)+=ds;
 
-    const u32 iterations = (u32)(radius * radius);
-    for (u32 i =0; i < iterations; ++i)
-    {
-        //i32 xi = irandom(randomSeries, 0, width - 1);
-        //i32 zi = irandom(randomSeries, 0, height - 1);
-        i32 xi = irandom(randomSeries, minX, maxX);
-        i32 zi = irandom(randomSeries, minY, maxY);
-        f32 xp = (f32)xi, zp = (f32)zi;
-        f32 xf = 0, zf = 0;
-        f32 h = HMAP(xi, zi);
-        f32 s = 0, v = 0, w = 1;
-        f32 h00 = h;
-        f32 h10 = HMAP(xi+1, zi  );
-        f32 h01 = HMAP(xi  , zi+1);
-        f32 h11 = HMAP(xi+1, zi+1);
-        f32 dx = 0, dz = 0;
-        for (u32 numMoves = 0; numMoves < MAX_PATH_LEN; ++numMoves)
-        {
-            f32 gx = h00 + h01 - h10 - h11;
-            f32 gz = h00 + h10 - h01 - h11;
-            dx = (dx - gx) * Ki + gx;
-            dz = (dz - gz) * Ki + gz;
-
-            f32 dl = sqrtf(dx * dx + dz * dz);
-            if (dl <= FLT_EPSILON)
-            {
-                f32 a = random(randomSeries, 0.f, PI * 2.f);
-                dx = cosf(a);
-                dz = sinf(a);
-            }
-            else
-            {
-                dx /= dl;
-                dz /= dl;
-            }
+#define ERODE(X, Z, W) \
+{ \
+f32 delta = ds * (W) * amount; \
+heightBuffer[(Z) * width + (X)] -= delta * scale; \
+}
 
-            f32 nxp = xp + dx;
-            f32 nzp = zp + dz;
+    // Droplets erode the cells from one before to two after their position, so they are kept
+    // that far from the edges of the terrain
+    auto simulateDroplets = [&](RandomSeries& series, u32 dropletCount,
+            i32 startMinX, i32 startMinY, i32 startMaxX, i32 startMaxY) {
+        for (u32 i =0; i < dropletCount; ++i)
+        {
+            i32 xi = irandom(series, startMinX, startMaxX);
+            i32 zi = irandom(series, startMinY, startMaxY);
+            f32 xp = (f32)xi, zp = (f32)zi;
+            f32 xf = 0, zf = 0;
+            f32 h = HMAP(xi, zi);
+            f32 s = 0, v = 0, w = 1;
+            f32 h00 = h;
+            f32 h10 = HMAP(xi+1, zi  );
+            f32 h01 = HMAP(xi  , zi+1);
+            f32 h11 = HMAP(xi+1, zi+1);
+            f32 dx = 0, dz = 0;
+            for (u32 numMoves = 0; numMoves < MAX_PATH_LEN; ++numMoves)
+            {
+                f32 gx = h00 + h01 - h10 - h11;
+                f32 gz = h00 + h10 - h01 - h11;
+                dx = (dx - gx) * Ki + gx;
+                dz = (dz - gz) * Ki + gz;
 
-            i32 nxi = (i32)floorf(nxp);
-            i32 nzi = (i32)floorf(nzp);
-            f32 nxf = nxp - nxi;
-            f32 nzf = nzp - nzi;
+                f32 dl = sqrtf(dx * dx + dz * dz);
+                if (dl <= FLT_EPSILON)
+                {
+                    f32 a = random(series, 0.f, PI * 2.f);
+                    dx = cosf(a);
+                    dz = sinf(a);
+                }
+                else
+                {
+                    dx /= dl;
+                    dz /= dl;
+                }
 
-            f32 nh00 = HMAP(nxi  , nzi  );
-            f32 nh10 = HMAP(nxi+1, nzi  );
-            f32 nh01 = HMAP(nxi  , nzi+1);
-            f32 nh11 = HMAP(nxi+1, nzi+1);
+                f32 nxp = xp + dx;
+                f32 nzp = zp + dz;
 
-            f32 nh = (nh00 * (1 - nxf) + nh10 * nxf) * (1 - nzf) + (nh01 * (1 - nxf) + nh11 * nxf) * nzf;
-            if (nh >= h)
-            {
-                f32 ds = (nh - h) + 0.001f;
-                if (ds >= s)
+                i32 nxi = (i32)floorf(nxp);
+                i32 nzi = (i32)floorf(nzp);
+                if (nxi < 1 || nzi < 1 || nxi > width - 3 || nzi > height - 3)
                 {
-                    ds = s;
-                    DEPOSIT(h)
-                    s = 0;
                     break;
                 }
-                DEPOSIT(h)
-                s -= ds;
-                v = 0;
-            }
+                f32 nxf = nxp - nxi;
+                f32 nzf = nzp - nzi;
 
-            f32 dh = h - nh;
-            f32 slope = dh;
-            f32 q = max(slope, minSlope) * v * w * Kq;
-            f32 ds = s - q;
-            if (ds >= 0)
-            {
-                ds *= Kd;
-                DEPOSIT(dh)
-                s -= ds;
-            }
-            else
-            {
-                ds *= -Kr;
-                ds = min(ds, dh * 0.99f);
+                f32 nh00 = HMAP(nxi  , nzi  );
+                f32 nh10 = HMAP(nxi+1, nzi  );
+                f32 nh01 = HMAP(nxi  , nzi+1);
+                f32 nh11 = HMAP(nxi+1, nzi+1);
 
-#define ERODE(X, Z, W) \
-{ \
-f32 delta = ds * (W) * amount; \
-heightBuffer          [clamp((Z) * width + (X), 0, (i32)heightBufferSize)] -= delta * scale; \
-Vec2 &e = erosion[clamp((Z) * width + (X), 0, (i32)heightBufferSize)]; \
-f32 r=e.x, d=e.y; \
-if (delta<=d) d-=delta; \
-else { r+=delta-d; d=0; } \
-e.x=r; e.y=d; \
-}
+                f32 nh = (nh00 * (1 - nxf) + nh10 * nxf) * (1 - nzf) + (nh01 * (1 - nxf) + nh11 * nxf) * nzf;
+                if (nh >= h)
+                {
+                    f32 ds = (nh - h) + 0.001f;
+                    if (ds >= s)
+                    {
+                        ds = s;
+                        DEPOSIT(h)
+                        s = 0;
+                        break;
+                    }
+                    DEPOSIT(h)
+                    s -= ds;
+                    v = 0;
+                }
 
-                for (i32 z = zi - 1; z <= zi + 2; ++z)
+                f32 dh = h - nh;
+                f32 slope = dh;
+                f32 q = max(slope, minSlope) * v * w * Kq;
+                f32 ds = s - q;
+                if (ds >= 0)
+                {
+                    ds *= Kd;
+                    DEPOSIT(dh)
+                    s -= ds;
+                }
+                else
                 {
-                    f32 zo = z - zp;
-                    f32 zo2 = zo * zo;
-                    for (i32 x = xi - 1; x <= xi + 2; ++x)
+                    ds *= -Kr;
+                    ds = min(ds, dh * 0.99f);
+
+                    for (i32 z = zi - 1; z <= zi + 2; ++z)
                     {
-                        f32 xo = x - xp;
-                        f32 w = 1 - (xo * xo + zo2) * 0.25f;
-                        if (w <= 0)
+                        f32 zo = z - zp;
+                        f32 zo2 = zo * zo;
+                        for (i32 x = xi - 1; x <= xi + 2; ++x)
                         {
-                            continue;
+                            f32 xo = x - xp;
+                            f32 w = 1 - (xo * xo + zo2) * 0.25f;
+                            if (w <= 0)
+                            {
+                                continue;
+                            }
+                            w *= 0.1591549430918953f;
+                            ERODE(x, z, w)
                         }
-                        w *= 0.1591549430918953f;
-                        ERODE(x, z, w)
                     }
+                    dh -= ds;
+                    s += ds;
                 }
-                dh -= ds;
-                s += ds;
-            }
 
-            v = sqrtf(v * v + Kg * dh);
-            w *= 1 - Kw;
+                v = sqrtf(v * v + Kg * dh);
+                w *= 1 - Kw;
+
+                xp = nxp;
+                zp = nzp;
+                xi = nxi;
+                zi = nzi;
+                xf = nxf;
+                zf = nzf;
+
+                h = nh;
+                h00 = nh00;
+                h10 = nh10;
+                h01 = nh01;
+                h11 = nh11;
+            }
+        }
+    };
 
-            xp = nxp;
-            zp = nzp;
-            xi = nxi;
-            zi = nzi;
-            xf = nxf;
-            zf = nzf;
+#undef HMAP
+#undef DEPOSIT_AT
+#undef DEPOSIT
+#undef ERODE
+
+    // A droplet touches cells at most MAX_PATH_LEN + 2 away from where it starts, so droplets
+    // starting in tiles that have another tile between them never touch the same cells. The tiles
+    // are done in four passes of tiles that are that far apart, and the tiles of a pass run in
+    // parallel. Each tile has its own random series, so the result doesn't depend on the threads.
+    const i32 TILE_SIZE = 32;
+    static_assert(TILE_SIZE > 2 * ((i32)MAX_PATH_LEN + 2), "erosion tiles are too small");
+
+    i32 startMinX = max(minX, 1);
+    i32 startMinY = max(minY, 1);
+    i32 startMaxX = min(maxX, width - 2);
+    i32 startMaxY = min(maxY, height - 2);
+    if (startMaxX <= startMinX || startMaxY <= startMinY)
+    {
+        return;
+    }
+    i32 tileCountX = (startMaxX - startMinX + TILE_SIZE - 1) / TILE_SIZE;
+    i32 tileCountY = (startMaxY - startMinY + TILE_SIZE - 1) / TILE_SIZE;
+    u64 totalArea = (u64)(startMaxX - startMinX) * (startMaxY - startMinY);
+    const u32 iterations = (u32)(radius * radius);
+    u32 seed = xorshift32(randomSeries);
 
-            h = nh;
-            h00 = nh00;
-            h10 = nh10;
-            h01 = nh01;
-            h11 = nh11;
+    struct ErosionTile
+    {
+        i32 minX, minY, maxX, maxY;
+        u32 dropletCount;
+        u32 seed;
+    };
+    Array<ErosionTile> passes[4];
+    u64 areaBefore = 0;
+    for (i32 ty = 0; ty < tileCountY; ++ty)
+    {
+        for (i32 tx = 0; tx < tileCountX; ++tx)
+        {
+            ErosionTile tile;
+            tile.minX = startMinX + tx * TILE_SIZE;
+            tile.minY = startMinY + ty * TILE_SIZE;
+            tile.maxX = min(tile.minX + TILE_SIZE, startMaxX);
+            tile.maxY = min(tile.minY + TILE_SIZE, startMaxY);
+            // the droplets are shared out by area, and the rounding never loses any
+            u64 areaAfter = areaBefore + (u64)(tile.maxX - tile.minX) * (tile.maxY - tile.minY);
+            tile.dropletCount = (u32)(iterations * areaAfter / totalArea - iterations * areaBefore / totalArea);
+            areaBefore = areaAfter;
+            tile.seed = (seed ^ ((u32)(ty * tileCountX + tx) * 0x9E3779B9u)) | 1;
+            passes[(tx & 1) + (ty & 1) * 2].push(tile);
         }
     }
-    setDirty();
+    for (auto& tiles : passes)
+    {
+        auto erodeTiles = [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i)
+            {
+                ErosionTile const& tile = tiles[i];
+                RandomSeries series{ tile.seed };
+                simulateDroplets(series, tile.dropletCount,
+                        tile.minX, tile.minY, tile.maxX, tile.maxY);
+            }
+        };
+        if (isBrushMultithreaded)
+        {
+            g_threadPool.parallelFor(tiles.size(), 1, erodeTiles);
+        }
+        else
+        {
+            erodeTiles(0, tiles.size());
+        }
+    }
+
+    i32 reach = (i32)MAX_PATH_LEN + 2;
+    setDirty(max(minX - reach, 0), max(minY - reach, 0),
+            min(maxX + reach, width - 1), min(maxY + reach, height - 1));
 }
 
 void Terrain::matchTrack(Vec2 pos, f32 radius, f32 falloff, f32 amount, Scene* scene)
@@ -635,33 +1320,78 @@ void Terrain::matchTrack(Vec2 pos, f32 radius, f32 falloff, f32 amount, Scene* s
     i32 maxX = getCellX(pos.x + radius);
     i32 maxY = getCellY(pos.y + radius);
     i32 width = (i32)((x2 - x1) / tileSize);
-    for (i32 x=minX; x<=maxX; ++x)
-    {
-        for (i32 y=minY; y<=maxY; ++y)
+    BrushWeights brush = { x1, y1, tileSize, pos, radius, falloff };
+    u32 cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+    // the scene queries are the slow part, and they can run on any thread
+    forEachBrushRow(minY, maxY, cellCount, isBrushMultithreaded, [&](i32 y) {
+        f32* row = heightBuffer.get() + y * width;
+        for (i32 x=minX; x<=maxX; x+=4)
         {
-            Vec2 p(x1 + x * tileSize, y1 + y * tileSize);
-            f32 t = powf(clamp(1.f - (length(pos - p) / radius), 0.f, 1.f), falloff);
-            f32 currentZ = heightBuffer[y * width + x];
-            f32 z = currentZ;
-            Vec3 from = Vec3(p.x, p.y, 1000.f);
-            Vec3 rayDir = Vec3(0, 0, -1);
-            PxRaycastBuffer rayHit;
-            if (scene->raycastStatic(from, rayDir, 10000.f, &rayHit, COLLISION_FLAG_TRACK))
+            i32 count = maxX - x + 1;
+            __m128 t = brush.get(x, y);
+            __m128 h = loadCells(row + x, count);
+            alignas(16) f32 weights[4];
+            alignas(16) f32 targetZ[4];
+            _mm_store_ps(weights, t);
+            _mm_store_ps(targetZ, h);
+            for (i32 i = 0; i < min(count, 4); ++i)
             {
-                z = rayHit.block.position.z - 0.15f;
-            }
-            else
-            {
-                PxSweepBuffer sweepHit;
-                if (scene->sweepStatic(9.f, from, rayDir, 10000.f, &sweepHit, COLLISION_FLAG_TRACK))
+                // cells outside of the brush aren't changed, so there is no need to look
+                if (weights[i] <= 0.f)
+                {
+                    continue;
+                }
+                Vec3 from = Vec3(x1 + (x + i) * tileSize, y1 + y * tileSize, 1000.f);
+                Vec3 rayDir = Vec3(0, 0, -1);
+                PxRaycastBuffer rayHit;
+                if (scene->raycastStatic(from, rayDir, 10000.f, &rayHit, COLLISION_FLAG_TRACK))
                 {
-                    z = sweepHit.block.position.z - 0.45f;
+                    targetZ[i] = rayHit.block.position.z - 0.15f;
+                }
+                else
+                {
+                    PxSweepBuffer sweepHit;
+                    if (scene->sweepStatic(9.f, from, rayDir, 10000.f, &sweepHit, COLLISION_FLAG_TRACK))
+                    {
+                        targetZ[i] = sweepHit.block.position.z - 0.45f;
+                    }
                 }
             }
-            heightBuffer[y * width + x] += (z - currentZ) * t * amount;
+            __m128 z = _mm_load_ps(targetZ);
+            t = _mm_mul_ps(t, _mm_set1_ps(amount));
+            storeCells(row + x, _mm_add_ps(h, _mm_mul_ps(_mm_sub_ps(z, h), t)), count);
         }
+    }, 64);
+    setDirty(minX, minY, maxX, maxY);
+}
+
+static inline __m128i loadBlendCells(u32 const* p, i32 count)
+{
+    if (count >= 4)
+    {
+        return _mm_loadu_si128((__m128i const*)p);
+    }
+    alignas(16) u32 v[4] = {};
+    for (i32 i = 0; i < count; ++i)
+    {
+        v[i] = p[i];
+    }
+    return _mm_load_si128((__m128i const*)v);
+}
+
+static inline void storeBlendCells(u32* p, __m128i v, i32 count)
+{
+    if (count >= 4)
+    {
+        _mm_storeu_si128((__m128i*)p, v);
+        return;
+    }
+    alignas(16) u32 tmp[4];
+    _mm_store_si128((__m128i*)tmp, v);
+    for (i32 i = 0; i < count; ++i)
+    {
+        p[i] = tmp[i];
     }
-    setDirty();
 }
 
 void Terrain::paint(Vec2 pos, f32 radius, f32 falloff, f32 amount, u32 materialIndex)
@@ -671,23 +1401,131 @@ void Terrain::paint(Vec2 pos, f32 radius, f32 falloff, f32 amount, u32 materialI
     i32 maxX = getCellX(pos.x + radius);
     i32 maxY = getCellY(pos.y + radius);
     i32 width = (i32)((x2 - x1) / tileSize);
-    for (i32 x=minX; x<=maxX; ++x)
+    BrushWeights brush = { x1, y1, tileSize, pos, radius, falloff };
+    u32 cellCount = (maxX - minX + 1) * (maxY - minY + 1);
+    forEachBrushRow(minY, maxY, cellCount, isBrushMultithreaded, [&](i32 y) {
+        u32* row = blend.get() + y * width;
+        for (i32 x=minX; x<=maxX; x+=4)
+        {
+            i32 count = maxX - x + 1;
+            __m128i cells = loadBlendCells(row + x, count);
+
+            // one register per layer, holding that layer of 4 cells
+            __m128 layers[4];
+            for (u32 i = 0; i < 4; ++i)
+            {
+                __m128i b = _mm_and_si128(_mm_srli_epi32(cells, i * 8), _mm_set1_epi32(0xFF));
+                layers[i] = _mm_div_ps(_mm_cvtepi32_ps(b), _mm_set1_ps(255.f));
+            }
+            layers[materialIndex] = _mm_add_ps(layers[materialIndex],
+                    _mm_mul_ps(brush.get(x, y), _mm_set1_ps(amount)));
+
+            // summed in the same order as the scalar code, so the rounding is the same
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(layers[0], layers[1]), layers[2]), layers[3]);
+            cells = _mm_setzero_si128();
+            for (u32 i = 0; i < 4; ++i)
+            {
+                __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(layers[i], sum), _mm_set1_ps(255.f)));
+                cells = _mm_or_si128(cells, _mm_slli_epi32(_mm_and_si128(b, _mm_set1_epi32(0xFF)), i * 8));
+            }
+            storeBlendCells(row + x, cells, count);
+        }
+    });
+    setDirty(minX, minY, maxX, maxY);
+}
+
+void Terrain::showBenchmark(Scene* scene)
+{
+    const i32 SIZE = 1024;
+    const u32 BRUSH_COUNT = 6;
+    const char* brushNames[BRUSH_COUNT] = {
+        "Raise", "Flatten", "Smooth", "Erode", "Match Track", "Paint" };
+    static f64 serialTimes[BRUSH_COUNT] = {};
+    static f64 parallelTimes[BRUSH_COUNT] = {};
+    static bool isErosionDeterministic = true;
+
+    if (ImGui::Button("Terrain Brush Benchmark"))
     {
-        for (i32 y=minY; y<=maxY; ++y)
+        // the default tile size is two units
+        Terrain terrain(-(f32)SIZE, -(f32)SIZE, (f32)SIZE, (f32)SIZE);
+        i32 width = (i32)((terrain.x2 - terrain.x1) / terrain.tileSize);
+        i32 height = (i32)((terrain.y2 - terrain.y1) / terrain.tileSize);
+        for (i32 y = 0; y < height; ++y)
         {
-            Vec2 p(x1 + x * tileSize, y1 + y * tileSize);
-            f32 t = powf(clamp(1.f - (length(pos - p) / radius), 0.f, 1.f), falloff);
-            u8* b = reinterpret_cast<u8*>(&blend[y * width + x]);
-            Vec4 bl = Vec4(b[0], b[1], b[2], b[3]) / 255.f;
-            bl[materialIndex] += t * amount;
-            bl /= bl.x + bl.y + bl.z + bl.w;
-            b[0] = u8(bl[0] * 255.f);
-            b[1] = u8(bl[1] * 255.f);
-            b[2] = u8(bl[2] * 255.f);
-            b[3] = u8(bl[3] * 255.f);
+            for (i32 x = 0; x < width; ++x)
+            {
+                terrain.heightBuffer[y * width + x] =
+                    sinf(x * 0.05f) * cosf(y * 0.07f) * 8.f + sinf((x + y) * 0.31f);
+            }
+        }
+        OwnedPtr<f32[]> erodedHeights(new f32[terrain.heightBufferSize]);
+
+        // a brush that covers the whole height field, except for match track, which does two
+        // scene queries per cell
+        f32 radius = (f32)SIZE;
+        for (u32 pass = 0; pass < 2; ++pass)
+        {
+            terrain.isBrushMultithreaded = pass == 1;
+            f64* times = pass == 1 ? parallelTimes : serialTimes;
+            for (u32 i = 0; i < BRUSH_COUNT; ++i)
+            {
+                if (i == 3)
+                {
+                    terrain.randomSeries = RandomSeries{};
+                }
+                f64 t = getTime();
+                switch (i)
+                {
+                    case 0: terrain.raise(Vec2(0.f), radius, 1.5f, 1.f); break;
+                    case 1: terrain.flatten(Vec2(0.f), radius, 1.5f, 0.5f, 2.f); break;
+                    case 2: terrain.smooth(Vec2(0.f), radius, 1.5f, 0.5f); break;
+                    case 3: terrain.erode(Vec2(0.f), radius, 1.5f, 1.f); break;
+                    case 4: terrain.matchTrack(Vec2(0.f), radius * 0.125f, 1.5f, 0.5f, scene); break;
+                    case 5: terrain.paint(Vec2(0.f), radius, 1.5f, 1.f, 1); break;
+                }
+                times[i] = getTime() - t;
+
+                // starting from the same heights, erosion has to give the same result with and
+                // without threads
+                if (i == 3)
+                {
+                    if (pass == 0)
+                    {
+                        memcpy(erodedHeights.get(), terrain.heightBuffer.get(),
+                                terrain.heightBufferSize * sizeof(f32));
+                    }
+                    else
+                    {
+                        isErosionDeterministic = memcmp(erodedHeights.get(),
+                                terrain.heightBuffer.get(), terrain.heightBufferSize * sizeof(f32)) == 0;
+                    }
+                }
+            }
+            if (pass == 0)
+            {
+                // undo the first pass so the second one starts from the same heights
+                for (i32 y = 0; y < height; ++y)
+                {
+                    for (i32 x = 0; x < width; ++x)
+                    {
+                        terrain.heightBuffer[y * width + x] =
+                            sinf(x * 0.05f) * cosf(y * 0.07f) * 8.f + sinf((x + y) * 0.31f);
+                    }
+                }
+                for (u32 i = 0; i < terrain.heightBufferSize; ++i)
+                {
+                    terrain.blend[i] = 0x000000FF;
+                }
+            }
         }
     }
-    setDirty();
+    ImGui::Text("Terrain brushes on %ix%i heights (single threaded / multithreaded):", SIZE, SIZE);
+    for (u32 i = 0; i < BRUSH_COUNT; ++i)
+    {
+        ImGui::Text("  %s: %.3fms / %.3fms", brushNames[i], serialTimes[i] * 1000.0,
+                parallelTimes[i] * 1000.0);
+    }
+    ImGui::Text("  Erosion deterministic: %s", isErosionDeterministic ? "yes" : "no");
 }
 
 void Terrain::serializeState(Serializer& s)
@@ -18,29 +18,118 @@ class Terrain : public Entity
 
     OwnedPtr<f32[]> heightBuffer;
     OwnedPtr<Vertex[]> vertices;
-    OwnedPtr<u32[]> indices;
     OwnedPtr<u32[]> blend;
 	u32 heightBufferSize = 0;
-	u32 indexCount = 0;
 
     GLuint vao = 0, vbo = 0, ebo = 0;
     Vec3 brushSettings = { 1.f, 1.f, 1.f };
     Vec3 brushPosition = { 0, 0, 1000000 };
+    u64 brushFrame = 0;
+
+    static constexpr i32 CHUNK_SIZE = 32;
+    static constexpr u32 LOD_COUNT = 4;
+    static constexpr u32 PATTERN_COUNT = 4;
+
+    // The terrain is drawn in chunks of CHUNK_SIZE cells (the last row and column of chunks take
+    // the remainder). Every chunk of the same size uses the same index pattern, offset to the
+    // chunk with a base vertex. Each lod skips twice as many vertices as the one before it, and
+    // has a variant for every combination of edges that have to be stitched to a neighbour one
+    // lod coarser.
+    struct Chunk
+    {
+        i32 x, y;
+        i32 width, height;
+        u32 pattern;
+        u32 maxLod;
+        u32 lod;
+        u32 edgeMask;
+        f32 minZ, maxZ;
+        // largest height difference between each lod and the full detail mesh
+        f32 lodError[LOD_COUNT];
+    };
+    struct IndexRange
+    {
+        u32 first;
+        u32 count;
+    };
+    Array<Chunk> chunks;
+    i32 chunkCountX = 0, chunkCountY = 0;
+    Array<u32> indices;
+    // indexed by (pattern * LOD_COUNT + lod) * 16 + edgeMask
+    IndexRange indexRanges[PATTERN_COUNT * LOD_COUNT * 16];
+    // reused by the chunk functions so that they don't allocate for every chunk
+    Array<i32> lodSamplesX, lodSamplesY, lodSamplesEdge;
 
     RandomSeries randomSeries;
 
     bool isDirty = true;
     bool isCollisionMeshDirty = true;
+    bool hasMeshChanged = true;
+    bool isFullRebuildNeeded = true;
+
+    bool isCollisionFullRebuildNeeded = true;
+
+    // cells changed since the last mesh update (inclusive), unless a full rebuild is needed
+    i32 dirtyMinX = 0, dirtyMinY = 0, dirtyMaxX = 0, dirtyMaxY = 0;
+    // the same for the collision, which is updated less often
+    i32 collisionDirtyMinX = 0, collisionDirtyMinY = 0;
+    i32 collisionDirtyMaxX = 0, collisionDirtyMaxY = 0;
 
     PxMaterial* materials[2];
-    OwnedPtr<PxMaterialTableIndex[]> materialIndices;
     PxRigidStatic* actor = nullptr;
+    PxHeightField* heightField = nullptr;
+    // heights are stored as 16 bit integers multiplied by this
+    f32 heightFieldScale = 0.f;
+    Array<PxHeightFieldSample> heightFieldSamples;
     ActorUserData physicsUserData;
     void setDirty()
     {
         isDirty = true;
         isCollisionMeshDirty = true;
+        isFullRebuildNeeded = true;
+        isCollisionFullRebuildNeeded = true;
     }
+    void setDirty(i32 minX, i32 minY, i32 maxX, i32 maxY)
+    {
+        if (!isDirty)
+        {
+            dirtyMinX = minX;
+            dirtyMinY = minY;
+            dirtyMaxX = maxX;
+            dirtyMaxY = maxY;
+        }
+        else
+        {
+            dirtyMinX = min(dirtyMinX, minX);
+            dirtyMinY = min(dirtyMinY, minY);
+            dirtyMaxX = max(dirtyMaxX, maxX);
+            dirtyMaxY = max(dirtyMaxY, maxY);
+        }
+        if (!isCollisionMeshDirty)
+        {
+            collisionDirtyMinX = minX;
+            collisionDirtyMinY = minY;
+            collisionDirtyMaxX = maxX;
+            collisionDirtyMaxY = maxY;
+        }
+        else
+        {
+            collisionDirtyMinX = min(collisionDirtyMinX, minX);
+            collisionDirtyMinY = min(collisionDirtyMinY, minY);
+            collisionDirtyMaxX = max(collisionDirtyMaxX, maxX);
+            collisionDirtyMaxY = max(collisionDirtyMaxY, maxY);
+        }
+        isDirty = true;
+        isCollisionMeshDirty = true;
+    }
+    void updateVertices(i32 minX, i32 minY, i32 maxX, i32 maxY);
+    void buildChunks(i32 width, i32 height);
+    void addChunkIndices(i32 chunkWidth, i32 chunkHeight, i32 step, u32 edgeMask, i32 rowStride);
+    void updateChunks(i32 minX, i32 minY, i32 maxX, i32 maxY);
+    void updateChunk(Chunk& c, i32 width);
+    void selectChunkLods(RenderWorld* rw);
+    u8 getCellMaterialIndex(i32 x, i32 y) const;
+    bool fillHeightFieldSamples(i32 minX, i32 minY, i32 maxX, i32 maxY);
 
     static constexpr u8 OFFROAD_THRESHOLD = 170;
 
@@ -49,6 +138,21 @@ class Terrain : public Entity
     ShaderHandle colorShader = getShaderHandle("terrain", {});
 
 public:
+    u32 lastMeshUpdateVertexCount = 0;
+    f64 lastMeshUpdateTime = 0.0;
+    u32 lastCollisionUpdateSampleCount = 0;
+    f64 lastCollisionUpdateTime = 0.0;
+
+    // large brushes are split across the worker threads
+    bool isBrushMultithreaded = true;
+
+    bool isLodEnabled = true;
+    // how far in pixels a chunk may be from the full detail mesh on screen
+    f32 maxLodScreenError = 2.f;
+    u32 lastLodChunkCount[LOD_COUNT] = {};
+    u32 lastTriangleCount = 0;
+    u32 lastFullDetailTriangleCount = 0;
+
     f32 x1 = 0, y1 = 0, x2 = 0, y2 = 0;
     f32 tileSize = 2.0f;
     i64 materialGuid = 0;
@@ -72,9 +176,13 @@ public:
     }
     ~Terrain()
     {
-        glDeleteBuffers(0, &vbo);
-        glDeleteBuffers(0, &ebo);
-        glDeleteVertexArrays(0, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        glDeleteVertexArrays(1, &vao);
+        if (heightField)
+        {
+            heightField->release();
+        }
     }
 
     void raise(Vec2 pos, f32 radius, f32 falloff, f32 amount);
@@ -84,6 +192,7 @@ public:
     void erode(Vec2 pos, f32 radius, f32 falloff, f32 amount);
     void matchTrack(Vec2 pos, f32 radius, f32 falloff, f32 amount, class Scene* scene);
     void paint(Vec2 pos, f32 radius, f32 falloff, f32 amount, u32 materialIndex);
+    static void showBenchmark(class Scene* scene);
 
     void generate(f32 heightScale=4.f, f32 scale=0.05f);
     void createBuffers();
@@ -107,9 +216,6 @@ public:
     void serializeState(Serializer& s) override;
     void applyDecal(class Decal& decal) override;
 
-    void setBrushSettings(f32 brushRadius, f32 brushFalloff, f32 brushStrength, Vec3 brushPosition)
-    {
-        this->brushSettings = { brushRadius, brushFalloff, brushStrength };
-        this->brushPosition = brushPosition;
-    }
+    // only applies to the current frame
+    void setBrushSettings(f32 brushRadius, f32 brushFalloff, f32 brushStrength, Vec3 brushPosition);
 };
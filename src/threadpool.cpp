@@ -21,8 +21,10 @@ void ThreadPool::start()
 
 void ThreadPool::signalCompletion()
 {
+    SDL_LockMutex(wakeMtx);
 	isFinished = true;
 	SDL_CondBroadcast(wakeCond);
+    SDL_UnlockMutex(wakeMtx);
 }
 
 void ThreadPool::join()
@@ -38,7 +40,12 @@ void ThreadPool::addTask(Task const&& task)
     SDL_LockMutex(taskMtx);
 	tasks.push(task);
 	SDL_UnlockMutex(taskMtx);
+
+    // signal while holding the wake mutex so the wakeup can't be lost between a worker
+    // checking for tasks and going to sleep
+    SDL_LockMutex(wakeMtx);
 	SDL_CondSignal(wakeCond);
+    SDL_UnlockMutex(wakeMtx);
 }
 
 void ThreadPool::wait()
@@ -57,7 +64,10 @@ void ThreadPool::worker()
 	while (!isFinished)
 	{
 	    SDL_LockMutex(wakeMtx);
-	    SDL_CondWait(wakeCond, wakeMtx);
+        while (tasks.empty() && !isFinished)
+        {
+	        SDL_CondWait(wakeCond, wakeMtx);
+        }
 	    SDL_UnlockMutex(wakeMtx);
 
 	    while (!tasks.empty())
@@ -88,3 +98,43 @@ void ThreadPool::worker()
 	    SDL_UnlockMutex(waitMtx);
 	}
 }
+
+static void processParallelForJob(ParallelForJob* job)
+{
+    for (;;)
+    {
+        u32 begin = (u32)SDL_AtomicAdd(&job->next, (i32)job->grainSize);
+        if (begin >= job->count)
+        {
+            break;
+        }
+        job->execute(job->data, begin, min(begin + job->grainSize, job->count));
+    }
+}
+
+void ThreadPool::runParallelFor(ParallelForJob& job)
+{
+    u32 rangeCount = (job.count + job.grainSize - 1) / job.grainSize;
+    u32 taskCount = min(rangeCount - 1, threads.size());
+    SDL_AtomicSet(&job.next, 0);
+    SDL_AtomicSet(&job.pending, (i32)taskCount);
+    for (u32 i=0; i<taskCount; ++i)
+    {
+        addTask({ &job, [](void* data) -> void* {
+            ParallelForJob* job = (ParallelForJob*)data;
+            processParallelForJob(job);
+            SDL_AtomicDecRef(&job->pending);
+            return nullptr;
+        }});
+    }
+
+    // the calling thread works on the job too, so all of the ranges get processed even if the
+    // workers are busy with something else
+    processParallelForJob(&job);
+
+    // the job lives on the caller's stack, so wait until every task that references it is done
+    while (SDL_AtomicGet(&job.pending) > 0)
+    {
+        SDL_Delay(0);
+    }
+}
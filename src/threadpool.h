@@ -33,6 +33,16 @@ struct Task
     void* (*execute)(void*) = nullptr;
 };
 
+struct ParallelForJob
+{
+    void* data = nullptr;
+    void (*execute)(void* data, u32 begin, u32 end) = nullptr;
+    u32 count = 0;
+    u32 grainSize = 1;
+    SDL_atomic_t next;
+    SDL_atomic_t pending;
+};
+
 class ThreadPool
 {
     Array<Task> tasks;
@@ -71,6 +81,26 @@ public:
     void signalCompletion();
     void join();
     void wait();
+    void runParallelFor(ParallelForJob& job);
+
+    // Splits [0, count) into ranges of grainSize and runs fn(begin, end) for each range on the
+    // worker threads and the calling thread. Returns when all ranges are complete.
+    // NOTE: must not be called from a worker thread
+    template <typename T>
+    void parallelFor(u32 count, u32 grainSize, T const& fn)
+    {
+        if (count <= grainSize || threads.empty())
+        {
+            fn(0, count);
+            return;
+        }
+        ParallelForJob job;
+        job.data = (void*)&fn;
+        job.execute = [](void* data, u32 begin, u32 end) { (*(T const*)data)(begin, end); };
+        job.count = count;
+        job.grainSize = grainSize;
+        runParallelFor(job);
+    }
 
 	friend i32 threadFunc(void* data);
 };
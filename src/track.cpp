@@ -60,28 +60,33 @@ void Track::onRender(RenderWorld* rw, Scene* scene, f32 deltaTime)
             createSegmentMesh(*c, scene);
         }
     }
+    if (hasMeshChanged)
+    {
+        rw->invalidateStaticShadows();
+        hasMeshChanged = false;
+    }
 
     auto renderDepth = [](void* renderData){
         Track* track = (Track*)renderData;
         for (auto& c : track->connections)
         {
-            glBindVertexArray(c->vao);
+            bindVertexArrayCached(c->vao);
             glDrawElements(GL_TRIANGLES, (GLsizei)c->indices.size(), GL_UNSIGNED_INT, 0);
         }
     };
     auto renderColor = [](void* renderData){
         Track* track = (Track*)renderData;
-        glBindTextureUnit(0, g_res.getTexture("tarmac")->handle);
-        glBindTextureUnit(5, g_res.getTexture("tarmac_normal")->handle);
-        glBindTextureUnit(6, g_res.getTexture("tarmac_spec")->handle);
+        bindTextureUnitCached(0, g_res.getTexture("tarmac")->handle);
+        bindTextureUnitCached(5, g_res.getTexture("tarmac_normal")->handle);
+        bindTextureUnitCached(6, g_res.getTexture("tarmac_spec")->handle);
         for (auto& c : track->connections)
         {
-            glBindVertexArray(c->vao);
+            bindVertexArrayCached(c->vao);
             glDrawElements(GL_TRIANGLES, (GLsizei)c->indices.size(), GL_UNSIGNED_INT, 0);
         }
     };
     rw->depthPrepass(depthShader, { this, renderDepth });
-    rw->shadowPass(depthShader, { this, renderDepth });
+    rw->staticShadowPass(depthShader, { this, renderDepth });
     rw->opaqueColorPass(colorShader, { this, renderColor });
 }
 
@@ -628,6 +633,7 @@ void Track::createSegmentMesh(BezierSegment& c, Scene* scene)
 {
     previewMesh.destroy();
     c.isDirty = false;
+    hasMeshChanged = true;
 
     if (c.vertices.empty())
     {
@@ -144,6 +144,7 @@ private:
     i32 dragOppositeConnectionIndex = -1;
     i32 dragOppositeConnectionHandle = -1;
     bool isDragging = false;
+    bool hasMeshChanged = true;
     Vec3 dragOffset;
     Array<Selection> selectedPoints;
     Scene* scene = nullptr;
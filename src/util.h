@@ -430,6 +430,19 @@ bool fileExists(const char* filename)
     return true;
 }
 
+// returns 0 if the file can't be opened
+size_t getFileSize(const char* filename)
+{
+    SDL_RWops* file = SDL_RWFromFile(filename, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+    size_t size = (size_t)SDL_RWsize(file);
+    SDL_RWclose(file);
+    return size;
+}
+
 void writeFile(const char* filename, void* data, size_t len)
 {
     SDL_RWops* file = SDL_RWFromFile(filename, "w+b");
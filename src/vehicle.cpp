@@ -50,7 +50,8 @@ Vehicle::Vehicle(Scene* scene, Mat4 const& transform, Vec3 const& startOffset,
 
     actorUserData.entityType = ActorUserData::VEHICLE;
     actorUserData.vehicle = this;
-    vehiclePhysics.setup(&actorUserData, scene->getPhysicsScene(), transform, &this->tuning);
+    vehiclePhysics.setup(&actorUserData, scene->getPhysicsScene(), transform, &this->tuning,
+            &scene->getVehicleManager(), vehicleIndex);
 
     // create weapons
     u32 frontWeaponSlotCount = 0;
@@ -87,10 +88,6 @@ Vehicle::~Vehicle()
 {
     if (engineSound) g_audio.stopSound(engineSound);
     if (tireSound) g_audio.stopSound(tireSound);
-    for (auto& d : vehicleDebris)
-    {
-        d.rigidBody->release();
-    }
 }
 
 void Vehicle::resetAmmo()
@@ -298,6 +295,17 @@ void Vehicle::onRender(RenderWorld* rw, f32 deltaTime)
     driver->getVehicleData()->render(rw, transform,
             wheelTransforms, *driver->getVehicleConfig(), nullptr, this, isBraking,
             cameraIndex >= 0, Vec4(shieldColor, shieldStrength));
+    // debris that was recycled by another vehicle this frame
+    for (u32 i=0; i<vehicleDebris.size();)
+    {
+        if (!scene->getDebrisPool().get(vehicleDebris[i].handle))
+        {
+            vehicleDebris[i] = vehicleDebris.back();
+            vehicleDebris.pop();
+            continue;
+        }
+        ++i;
+    }
     driver->getVehicleData()->renderDebris(rw, vehicleDebris,
             *driver->getVehicleConfig());
 }
@@ -379,10 +387,9 @@ void Vehicle::onUpdate(RenderWorld* rw, f32 deltaTime)
     {
         VehicleDebris& debris = vehicleDebris[i];
         debris.life -= deltaTime;
-        if (debris.life <= 0.f)
+        if (debris.life <= 0.f || !scene->getDebrisPool().get(debris.handle))
         {
-            scene->getPhysicsScene()->removeActor(*debris.rigidBody);
-            debris.rigidBody->release();
+            scene->getDebrisPool().despawn(debris.handle);
             if (vehicleDebris.size() > 1)
             {
                 debris = vehicleDebris.back();
@@ -569,16 +576,32 @@ void Vehicle::onUpdate(RenderWorld* rw, f32 deltaTime)
         vehiclePhysics.setSpeedHandicap(1.f, 1.f);
     }
 
-    // update vehicle physics
+    // set the vehicle physics inputs, the vehicle is updated by the scene's VehicleManager
+    // along with the rest of the vehicles
     if (!finishedRace)
     {
-        vehiclePhysics.update(scene->getPhysicsScene(), deltaTime,
+        vehiclePhysics.updateInputs(deltaTime,
                 input.digital, input.accel, input.brake, input.steer, false, true, false);
     }
     else
     {
-        vehiclePhysics.update(scene->getPhysicsScene(), deltaTime, false, 0.f,
+        vehiclePhysics.updateInputs(deltaTime, false, 0.f,
                 controlledBrakingTimer < 0.5f ? 0.f : 0.5f, 0.f, 0.f, true, true);
+    }
+    scene->getVehicleManager().queueVehicle(&vehiclePhysics);
+    isPhysicsUpdatePending = true;
+}
+
+void Vehicle::onUpdateEnd(RenderWorld* rw, f32 deltaTime)
+{
+    if (!isPhysicsUpdatePending)
+    {
+        return;
+    }
+    isPhysicsUpdatePending = false;
+
+    if (finishedRace)
+    {
         if (vehiclePhysics.getForwardSpeed() > 1.f)
         {
             controlledBrakingTimer = min(controlledBrakingTimer + deltaTime, 1.f);
@@ -971,24 +994,27 @@ void Vehicle::blowUp(f32 respawnTime, bool giveAttackCredit)
     Mat4 transform = vehiclePhysics.getTransform();
     for (auto& d : tuning.debrisChunks)
     {
-        PxRigidDynamic* body = g_game.physx.physics->createRigidDynamic(
-                PxTransform(convert(transform * d.transform)));
-        body->attachShape(*d.collisionShape);
-        PxRigidBodyExt::updateMassAndInertia(*body, 10.f);
-        scene->getPhysicsScene()->addActor(*body);
-        body->setLinearVelocity(
-                convert(previousVelocity) +
+        PxVec3 linearVelocity = convert(previousVelocity) +
                 convert(Vec3(normalize(transform.rotation() * Vec4(d.transform.position(), 1.f)))
-                    * random(scene->randomSeries, 3.f, 14.f) + Vec3(0, 0, 9.f)));
-        body->setAngularVelocity(PxVec3(
+                    * random(scene->randomSeries, 3.f, 14.f) + Vec3(0, 0, 9.f));
+        PxVec3 angularVelocity(
                     random(scene->randomSeries, 0.f, 9.f),
                     random(scene->randomSeries, 0.f, 9.f),
-                    random(scene->randomSeries, 0.f, 9.f)));
+                    random(scene->randomSeries, 0.f, 9.f));
+        DebrisHandle handle = scene->getDebrisPool().spawn(d.collisionShape,
+                PxTransform(convert(transform * d.transform)), 10.f,
+                linearVelocity, angularVelocity, scene->getWorldTime());
+        PxRigidDynamic* body = scene->getDebrisPool().get(handle);
+        if (!body)
+        {
+            continue;
+        }
 
         createVehicleDebris(VehicleDebris{
             &d,
             body,
-            random(scene->randomSeries, 6.f, 7.f)
+            random(scene->randomSeries, 6.f, 7.f),
+            handle
         });
     }
     deadTimer = respawnTime;
@@ -1164,7 +1190,130 @@ void Vehicle::updatePlayerInput(f32 deltaTime, RenderWorld* rw)
 #endif
 }
 
+f32 Vehicle::getAiPathSteer(Vec3 const& targetP)
+{
+    Vec2 dirToTargetP = normalize(Vec2(getPosition()) - Vec2(targetP));
+    f32 steer = clamp(dot(Vec2(getRightVector()), dirToTargetP) * 1.2f, -1.f, 1.f);
+    if (scene->canGo() && scene->getWorldTime() > 5.f
+            && (isBackingUp || vehiclePhysics.getForwardSpeed() < -0.25f))
+    {
+        steer *= -1.f;
+    }
+    return -steer;
+}
+
+f32 Vehicle::getAiAggression()
+{
+    return min(max(((f32)scene->getWorldTime() - 3.f) * 0.3f, 0.f), getAI()->aggression);
+}
+
+u32 getAiObstacleFlags(f32 attackTimer)
+{
+    u32 flags = COLLISION_FLAG_DYNAMIC | COLLISION_FLAG_OIL  |
+                COLLISION_FLAG_GLUE    | COLLISION_FLAG_MINE; // | COLLISION_FLAG_BOOSTER;
+    if (attackTimer < 0.6f)
+    {
+        flags |= COLLISION_FLAG_CHASSIS;
+    }
+    return flags;
+}
+
+void Vehicle::queueAiQueries()
+{
+    auto& ai = *getAI();
+    QueryBatch& batch = scene->getQueryBatch();
+    Vec3 currentPosition = getPosition();
+    Vec3 forwardVector = getForwardVector();
+    f32 aggression = getAiAggression();
+
+    aiObstacleQuery = batch.sweep(tuning.collisionWidth * 0.5f + 0.05f,
+            currentPosition + Vec3(0, 0, 0.25f), forwardVector, 13.f + ai.awareness * 8.f,
+            getRigidBody(), getAiObstacleFlags(attackTimer));
+    if (ai.fear > 0.f)
+    {
+        aiFearQuery = batch.sweep(0.5f, currentPosition, -forwardVector,
+                aggression * 35.f + 10.f, getRigidBody(), COLLISION_FLAG_CHASSIS);
+    }
+    if (aggression > 0.f)
+    {
+        aiAttackQuery = batch.sweep(0.5f, currentPosition, forwardVector,
+                aggression * 50.f + 10.f, getRigidBody(), COLLISION_FLAG_CHASSIS | COLLISION_FLAG_OBJECT);
+    }
+}
+
+bool Vehicle::aiSweep(QueryHandle handle, f32 radius, Vec3 const& from, Vec3 const& dir,
+        f32 dist, u32 flags, PxSweepBuffer* hit)
+{
+    // use the result that was queued last frame if there is one
+    if (SweepResult const* result = scene->getQueryBatch().getSweepResult(handle))
+    {
+        if (hit)
+        {
+            hit->hasBlock = result->hasBlock;
+            hit->block = result->block;
+        }
+        return result->hasBlock;
+    }
+    return scene->sweep(radius, from, dir, dist, hit, getRigidBody(), flags);
+}
+
 void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
+{
+    f64 startTime = getTime();
+    auto const& config = g_game.config.gameplay;
+
+    // AI that are far away from every camera make decisions less often
+    aiDecisionInterval = max(config.aiDecisionInterval, 1u);
+    if (cameraIndex < 0)
+    {
+        Vec3 currentPosition = getPosition();
+        f32 minCameraDistanceSquared = FLT_MAX;
+        for (u32 i=0; i<rw->getViewportCount(); ++i)
+        {
+            minCameraDistanceSquared = min(minCameraDistanceSquared,
+                    distanceSquared(rw->getCamera(i).position, currentPosition));
+        }
+        if (minCameraDistanceSquared > square(config.aiFarDistance))
+        {
+            aiDecisionInterval = max(config.aiFarDecisionInterval, aiDecisionInterval);
+        }
+    }
+
+    aiDecisionTimer += deltaTime;
+
+    // stagger the decision frames by vehicle index so the AI don't all think on the same frame
+    bool isDecisionFrame = (g_game.frameCount + vehicleIndex) % aiDecisionInterval == 0;
+    if (isDecisionFrame)
+    {
+        updateAiDecision(aiDecisionTimer, rw);
+        aiDecisionTimer = 0.f;
+        aiDecisionTime = getTime() - startTime;
+
+        // one-shot inputs should only be sent on the frame the decision was made
+        aiInput = input;
+        aiInput.beginShoot = false;
+        aiInput.beginShootRear = false;
+        aiInput.reset = false;
+    }
+
+    // queue the queries for the next decision so they can be batched with everything else
+    if ((g_game.frameCount + 1 + vehicleIndex) % aiDecisionInterval == 0)
+    {
+        queueAiQueries();
+    }
+
+    if (!isDecisionFrame)
+    {
+        // in between decisions keep steering toward the last target, preserving whatever
+        // adjustment the last decision made for obstacles, targets, etc.
+        input = aiInput;
+        input.steer = clamp(getAiPathSteer(aiTargetPosition) + aiSteerBias, -1.f, 1.f);
+    }
+
+    aiUpdateTime = aiUpdateTime * 0.95 + (getTime() - startTime) * 0.05;
+}
+
+void Vehicle::updateAiDecision(f32 deltaTime, RenderWorld* rw)
 {
     auto& ai = *getAI();
 
@@ -1259,6 +1408,7 @@ void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
         Vec3(targetOffset.x * dir + targetOffset.y * Vec2(-dir.y, dir.x), 0);
     Vec2 dirToTargetP = normalize(Vec2(currentPosition) - Vec2(targetP));
     previousTargetPosition = targetPathPoint.position;
+    aiTargetPosition = targetP;
 #if 0
     Mesh* sphere = g_res.getModel("misc")->getMeshByName("Sphere");
     drawSimple(rw, sphere, &g_res.white, Mat4::translation(targetP),
@@ -1269,26 +1419,20 @@ void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
     //input.accel *= 0.8f;
     input.brake = 0.f;
     input.steer = clamp(dot(Vec2(rightVector), dirToTargetP) * 1.2f, -1.f, 1.f);
-    f32 aggression = min(max(((f32)scene->getWorldTime() - 3.f) * 0.3f, 0.f),
-            ai.aggression);
+    f32 aggression = getAiAggression();
 
     // obstacle avoidance
 #if 1
-    u32 flags = COLLISION_FLAG_DYNAMIC | COLLISION_FLAG_OIL  |
-                COLLISION_FLAG_GLUE    | COLLISION_FLAG_MINE; // | COLLISION_FLAG_BOOSTER;
-    if (attackTimer < 0.6f)
-    {
-        flags |= COLLISION_FLAG_CHASSIS;
-    }
+    u32 flags = getAiObstacleFlags(attackTimer);
     PxSweepBuffer hit;
     f32 sweepLength = 13.f + ai.awareness * 8.f;
     PxRigidBody* ignoreBody = getRigidBody();
     isBlocked = false;
     isNearHazard = false;
     f32 mySpeed = getRigidBody()->getLinearVelocity().magnitude();
-    if (mySpeed < 35.f && scene->sweep(tuning.collisionWidth * 0.5f + 0.05f,
+    if (mySpeed < 35.f && aiSweep(aiObstacleQuery, tuning.collisionWidth * 0.5f + 0.05f,
             currentPosition + Vec3(0, 0, 0.25f), forwardVector, sweepLength,
-            &hit, ignoreBody, flags) && scene->getWorldTime() > 5.f)
+            flags, &hit) && scene->getWorldTime() > 5.f)
     {
         bool shouldAvoid = true;
 
@@ -1439,8 +1583,8 @@ void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
     {
         // TODO: shouldn't this use fear rather than aggression?
         f32 fearRayLength = aggression * 35.f + 10.f;
-        if (scene->sweep(0.5f, currentPosition, -forwardVector,
-                    fearRayLength, nullptr, getRigidBody(), COLLISION_FLAG_CHASSIS))
+        if (aiSweep(aiFearQuery, 0.5f, currentPosition, -forwardVector,
+                    fearRayLength, COLLISION_FLAG_CHASSIS))
         {
             fearTimer += deltaTime;
             if (fearTimer > 1.f * (1.f - ai.fear) + 0.5f)
@@ -1532,8 +1676,8 @@ void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
                 Vec4(0, 1, 0, 1), Vec4(0, 1, 0, 1));
         */
         PxSweepBuffer hit;
-        if (scene->sweep(0.5f, currentPosition, forwardVector, rayLength, &hit, getRigidBody(),
-                    COLLISION_FLAG_CHASSIS | COLLISION_FLAG_OBJECT)
+        if (aiSweep(aiAttackQuery, 0.5f, currentPosition, forwardVector, rayLength,
+                    COLLISION_FLAG_CHASSIS | COLLISION_FLAG_OBJECT, &hit)
                 && hit.block.actor->userData
                 && ((ActorUserData*)(hit.block.actor->userData))->entityType == ActorUserData::VEHICLE)
         {
@@ -1581,6 +1725,8 @@ void Vehicle::updateAiInput(f32 deltaTime, RenderWorld* rw)
 
     // TODO: make the sign correct in the first place
     input.steer *= -1.f;
+
+    aiSteerBias = input.steer - getAiPathSteer(targetP);
 }
 
 f32 Vehicle::getTraversedDistance() const
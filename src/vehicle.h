@@ -46,6 +46,7 @@ public:
 	bool isBlocked = false;
 	bool isFollowed = false;
 	bool isNearHazard = false;
+	bool isPhysicsUpdatePending = false;
 
     // gameplay data
     VehicleInput input;
@@ -99,6 +100,16 @@ public:
     Vehicle* target = nullptr;
     f32 fearTimer = 0.f;
     f32 rearWeaponTimer = 0.f;
+    VehicleInput aiInput;
+    f32 aiDecisionTimer = 0.f;
+    f32 aiSteerBias = 0.f;
+    Vec3 aiTargetPosition = Vec3(0);
+    u32 aiDecisionInterval = 1;
+    f64 aiUpdateTime = 0.0;
+    f64 aiDecisionTime = 0.0;
+    QueryHandle aiObstacleQuery;
+    QueryHandle aiFearQuery;
+    QueryHandle aiAttackQuery;
 
     // weapons
     SmallArray<OwnedPtr<Weapon>, ARRAY_SIZE(VehicleConfiguration::weaponIndices)>
@@ -177,9 +188,16 @@ public:
     }
 
     void updateAiInput(f32 deltaTime, RenderWorld* rw);
+    void updateAiDecision(f32 deltaTime, RenderWorld* rw);
+    f32 getAiPathSteer(Vec3 const& targetP);
+    f32 getAiAggression();
+    void queueAiQueries();
+    bool aiSweep(QueryHandle handle, f32 radius, Vec3 const& from, Vec3 const& dir, f32 dist,
+            u32 flags, PxSweepBuffer* hit=nullptr);
     void updatePlayerInput(f32 deltaTime, RenderWorld* rw);
 
     void onUpdate(RenderWorld* rw, f32 deltaTime);
+    void onUpdateEnd(RenderWorld* rw, f32 deltaTime);
     void onRender(RenderWorld* rw, f32 deltaTime);
     void drawWeaponAmmo(Renderer* renderer, Vec2 pos, Weapon* weapon,
             bool showAmmo, bool selected);
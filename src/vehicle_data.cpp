@@ -40,8 +40,12 @@ VehicleStats VehicleTuning::computeVehicleStats()
     // create vehicle
     // TODO: add a few timesteps of delay to make sure that suspension is at rest position
     Mat4 startTransform = Mat4::translation({ 0, 0, getRestOffset() });
+    // the vehicle is stepped the same way as in a race, by a vehicle manager of its own
+    VehicleManager vehicleManager;
+    vehicleManager.setup(physicsScene, 1);
+    GroundSpotGrid groundSpotGrid;
     VehiclePhysics v;
-    v.setup(nullptr, physicsScene, startTransform, this);
+    v.setup(nullptr, physicsScene, startTransform, this, &vehicleManager, 0);
 
     const f32 timestep = 1.f / 50.f;
 
@@ -53,7 +57,9 @@ VehicleStats VehicleTuning::computeVehicleStats()
         physicsScene->simulate(timestep);
         physicsScene->fetchResults(true);
 
-        v.update(physicsScene, timestep, true, 1.f, 0.f, 0.f, false, true, false);
+        v.updateInputs(timestep, true, 1.f, 0.f, 0.f, false, true, false);
+        vehicleManager.queueVehicle(&v);
+        vehicleManager.update(physicsScene, groundSpotGrid, timestep);
         if (v.getForwardSpeed() >= 28.f)
         {
             f32 time = iterations * timestep;
@@ -73,7 +79,9 @@ VehicleStats VehicleTuning::computeVehicleStats()
         physicsScene->simulate(timestep);
         physicsScene->fetchResults(true);
 
-        v.update(physicsScene, timestep, true, 0.f, 0.f, 0.f, false, true, false);
+        v.updateInputs(timestep, true, 0.f, 0.f, 0.f, false, true, false);
+        vehicleManager.queueVehicle(&v);
+        vehicleManager.update(physicsScene, groundSpotGrid, timestep);
 
         // prevent vehicle from moving forwards or backwards
         PxVec3 vel = v.getRigidBody()->getLinearVelocity();
@@ -111,7 +119,9 @@ VehicleStats VehicleTuning::computeVehicleStats()
         physicsScene->simulate(timestep);
         physicsScene->fetchResults(true);
 
-        v.update(physicsScene, timestep, true, 1.f, 0.f, 0.f, false, true, false);
+        v.updateInputs(timestep, true, 1.f, 0.f, 0.f, false, true, false);
+        vehicleManager.queueVehicle(&v);
+        vehicleManager.update(physicsScene, groundSpotGrid, timestep);
         if (v.getForwardSpeed() >= 16.f)
         {
             f32 time = iterations * timestep;
@@ -279,6 +289,7 @@ void VehicleData::loadModelData(VehicleTuning& tuning)
                     PxConvexMeshGeometry(collisionMesh, PxMeshScale(convert(transform.scale()))), *material);
             shape->setSimulationFilterData(PxFilterData(COLLISION_FLAG_DEBRIS,
                         COLLISION_FLAG_TERRAIN | COLLISION_FLAG_OBJECT | COLLISION_FLAG_CHASSIS, 0, 0));
+            shape->setQueryFilterData(PxFilterData(COLLISION_FLAG_DEBRIS, 0, 0, 0));
             material->release();
             tuning.debrisChunks.push({
                 mesh,
@@ -375,6 +386,17 @@ void VehicleData::loadModelData(VehicleTuning& tuning)
     tuning.chassisOneMaterialBatch.end();
 }
 
+static GLuint getBakedPaintTexture(VehicleConfiguration const& config, i64 const textureGuids[3])
+{
+    Texture* textures[3];
+    for (u32 i=0; i<3; ++i)
+    {
+        textures[i] = textureGuids[i] ? g_res.getTexture(textureGuids[i]) : nullptr;
+    }
+    return g_game.renderer->getVinylBaker().get(config.paintMaterial.color, textures,
+            config.cosmetics.vinylColors);
+}
+
 void VehicleData::render(RenderWorld* rw, Mat4 const& transform,
         Mat4* wheelTransforms, VehicleConfiguration& config, VehicleTuning* tuning,
         Vehicle* vehicle, bool isBraking, bool isHidden, Vec4 const& shield)
@@ -408,12 +430,13 @@ void VehicleData::render(RenderWorld* rw, Mat4 const& transform,
             textureGuids[i] = ((VinylPattern*)r)->colorTextureGuid;
         }
     }
+    GLuint bakedPaintTexture = getBakedPaintTexture(config, textureGuids);
     for (auto& m : tuning->chassisBatch.batches)
     {
         if (m.material == originalPaintMaterial)
         {
             config.paintMaterial.drawVehicle(rw, transform, &m.mesh, 2, shield,
-                    textureGuids, config.cosmetics.vinylColors);
+                    textureGuids, config.cosmetics.vinylColors, bakedPaintTexture);
         }
         else
         {
@@ -491,6 +514,7 @@ void VehicleData::renderDebris(RenderWorld* rw,
         }
     }
 
+    GLuint bakedPaintTexture = getBakedPaintTexture(config, textureGuids);
     Material* originalPaintMaterial = g_res.getMaterial("paint_material");
     for (auto const& d : debris)
     {
@@ -499,7 +523,7 @@ void VehicleData::renderDebris(RenderWorld* rw,
         if (d.meshInfo->material == originalPaintMaterial)
         {
             config.paintMaterial.drawVehicle(rw, transform, d.meshInfo->mesh, 0, Vec4(0.f),
-                    textureGuids, config.cosmetics.vinylColors);
+                    textureGuids, config.cosmetics.vinylColors, bakedPaintTexture);
         }
         else
         {
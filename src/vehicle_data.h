@@ -7,6 +7,7 @@
 #include "material.h"
 #include "batcher.h"
 #include "vinyl_pattern.h"
+#include "debris_pool.h"
 
 #define WHEEL_FRONT_LEFT  PxVehicleDrive4WWheelOrder::eFRONT_LEFT
 #define WHEEL_FRONT_RIGHT PxVehicleDrive4WWheelOrder::eFRONT_RIGHT
@@ -44,6 +45,7 @@ struct VehicleDebris
     VehicleMesh* meshInfo;
     PxRigidDynamic* rigidBody;
     f32 life = 0.f;
+    DebrisHandle handle;
 };
 
 struct VehicleCollisionMesh
@@ -1,6 +1,8 @@
 #include "vehicle_physics.h"
 #include "game.h"
 #include "collision_flags.h"
+#include "threadpool.h"
+#include "imgui.h"
 #include <vehicle/PxVehicleUtil.h>
 
 const u32 QUERY_HITS_PER_WHEEL = 8;
@@ -142,36 +144,19 @@ PxBatchQuery* VehicleSceneQueryData::setUpBatchedSceneQuery(const PxU32 batchId,
     return scene->createBatchQuery(sqDesc);
 }
 
-static PxVehicleDrivableSurfaceToTireFrictionPairs* createFrictionPairs(
-        VehicleTuning const& settings, const PxMaterial** materials)
+constexpr u32 NUM_SURFACE_TYPES = 2;
+
+// each vehicle gets its own set of tire types so that all vehicles can share one table
+static PxVehicleDrivableSurfaceToTireFrictionPairs* createFrictionPairs(u32 numTireTypes,
+        const PxMaterial** materials)
 {
-    constexpr u32 NUM_SURFACE_TYPES = 2;
     PxVehicleDrivableSurfaceType surfaceTypes[NUM_SURFACE_TYPES] = { { 0 }, { 1 } };
 
-    const u32 numTireTypes = 2;
     PxVehicleDrivableSurfaceToTireFrictionPairs* surfaceTirePairs =
         PxVehicleDrivableSurfaceToTireFrictionPairs::allocate(numTireTypes, NUM_SURFACE_TYPES);
 
     surfaceTirePairs->setup(numTireTypes, NUM_SURFACE_TYPES, materials, surfaceTypes);
 
-    f32 tireFriction[numTireTypes] = {
-        1.f,
-        settings.rearTireGripPercent,
-    };
-
-    f32 frictionTable[NUM_SURFACE_TYPES] = {
-        settings.trackTireFriction,
-        settings.offroadTireFriction,
-    };
-
-    for(u32 i = 0; i < NUM_SURFACE_TYPES; i++)
-    {
-        for(u32 j = 0; j < numTireTypes; j++)
-        {
-            surfaceTirePairs->setTypePairFriction(i, j, frictionTable[i] * tireFriction[j]);
-        }
-    }
-
     return surfaceTirePairs;
 }
 
@@ -211,21 +196,16 @@ static PxConvexMesh* createWheelMesh(const PxF32 width, const PxF32 radius)
 }
 
 void VehiclePhysics::setup(void* userData, PxScene* scene, Mat4 const& transform,
-        VehicleTuning* tune)
+        VehicleTuning* tune, VehicleManager* vehicleManager, u32 vehicleSlot)
 {
     this->tuning = tune;
     VehicleTuning& tuning = *tune;
 
-    const PxMaterial* surfaceMaterials[] = {
-        g_game.physx.materials.track,
-        g_game.physx.materials.offroad
-    };
     PxMaterial* vehicleMaterial = g_game.physx.materials.vehicle;
 
-    sceneQueryData = VehicleSceneQueryData::allocate(1, NUM_WHEELS, QUERY_HITS_PER_WHEEL, 1,
-            &WheelSceneQueryPreFilterNonBlocking, &WheelSceneQueryPostFilterNonBlocking, g_game.physx.allocator);
-    batchQuery = VehicleSceneQueryData::setUpBatchedSceneQuery(0, *sceneQueryData, scene);
-    frictionPairs = createFrictionPairs(tuning, surfaceMaterials);
+    frictionPairs = vehicleManager->getFrictionPairs();
+    tireTypeOffset = vehicleSlot * VehicleManager::TIRE_TYPES_PER_VEHICLE;
+    vehicleManager->setTireFriction(vehicleSlot, tuning);
 
     PxConvexMesh* wheelConvexMeshes[NUM_WHEELS];
     PxMaterial* wheelMaterials[NUM_WHEELS];
@@ -325,10 +305,10 @@ void VehiclePhysics::setup(void* userData, PxScene* scene, Mat4 const& transform
     wheels[WHEEL_FRONT_RIGHT].mMaxSteer = radians(tuning.maxSteerAngleDegrees);
 
     PxVehicleTireData tires[NUM_WHEELS] = { };
-    tires[WHEEL_FRONT_LEFT].mType = 0;
-    tires[WHEEL_FRONT_RIGHT].mType = 0;
-    tires[WHEEL_REAR_LEFT].mType = 1;
-    tires[WHEEL_REAR_RIGHT].mType = 1;
+    tires[WHEEL_FRONT_LEFT].mType = tireTypeOffset + 0;
+    tires[WHEEL_FRONT_RIGHT].mType = tireTypeOffset + 0;
+    tires[WHEEL_REAR_LEFT].mType = tireTypeOffset + 1;
+    tires[WHEEL_REAR_RIGHT].mType = tireTypeOffset + 1;
 
     for(PxU32 i = 0; i < NUM_WHEELS; i++)
     {
@@ -507,10 +487,6 @@ VehiclePhysics::~VehiclePhysics()
 {
     vehicle4W->getRigidDynamicActor()->release();
     vehicle4W->free();
-    sceneQueryData->free(g_game.physx.allocator);
-    // TODO: find out why this causes an exception
-    //batchQuery->release();
-    frictionPairs->release();
 }
 
 void VehiclePhysics::reset(Mat4 const& transform)
@@ -524,10 +500,11 @@ void VehiclePhysics::reset(Mat4 const& transform)
     }
 }
 
-void VehiclePhysics::update(PxScene* scene, f32 timestep, bool digital, f32 accel, f32 brake, f32 steer,
+void VehiclePhysics::updateInputs(f32 timestep, bool digital, f32 accel, f32 brake, f32 steer,
             bool handbrake, bool canGo, bool onlyBrake)
 {
     engineThrottle = 0.f;
+    accelInput = accel;
     if (canGo)
     {
         PxVehicleDrive4WRawInputData inputs;
@@ -624,19 +601,12 @@ void VehiclePhysics::update(PxScene* scene, f32 timestep, bool digital, f32 acce
             }
         }
     }
+}
 
-    PxVehicleWheels* vehicles[1] = { vehicle4W };
-    PxSweepQueryResult* sweepResults = sceneQueryData->getSweepQueryResultBuffer(0);
-    const PxU32 sweepResultsSize = sceneQueryData->getQueryResultBufferSize();
-    PxVehicleSuspensionSweeps(batchQuery, 1, vehicles, sweepResultsSize, sweepResults, QUERY_HITS_PER_WHEEL, NULL, 1.0f, 1.01f);
-
-    const PxVec3 grav = scene->getGravity();
-    PxVehicleWheelQueryResult vehicleQueryResults[1] = {
-        { wheelQueryResults, NUM_WHEELS }
-    };
-    PxVehicleUpdates(timestep, grav, *frictionPairs, 1, vehicles, vehicleQueryResults);
-
-    isInAir = PxVehicleIsInAir(vehicleQueryResults[0]);
+void VehiclePhysics::onVehicleUpdated(GroundSpotGrid& groundSpotGrid, f32 timestep)
+{
+    PxVehicleWheelQueryResult vehicleQueryResult = { wheelQueryResults, NUM_WHEELS };
+    isInAir = PxVehicleIsInAir(vehicleQueryResult);
 
     if (!isInAir)
     {
@@ -656,14 +626,14 @@ void VehiclePhysics::update(PxScene* scene, f32 timestep, bool digital, f32 acce
                 maxSlip = max(maxSlip, lateralSlip);
             }
         }
-        f32 driftBoost = min(maxSlip, 1.f) * accel * tuning->driftBoost * 20.f;
+        f32 driftBoost = min(maxSlip, 1.f) * accelInput * tuning->driftBoost * 20.f;
         PxVec3 boostDir = getRigidBody()->getLinearVelocity().getNormalized();
         getRigidBody()->addForce(boostDir * driftBoost, PxForceMode::eACCELERATION);
     }
 
     updateWheelInfo(timestep);
 
-    checkGroundSpots(scene, timestep);
+    checkGroundSpots(groundSpotGrid, timestep);
 }
 
 void VehiclePhysics::updateWheelInfo(f32 deltaTime)
@@ -753,14 +723,14 @@ void VehiclePhysics::updateWheelInfo(f32 deltaTime)
                     f32 amount = clamp(wheelInfo[i].oilCoverage, 0.f, 1.f);
                     // TODO: should this be a percentage of trackTireFriction rather than the hardcoded 0.95?
                     f32 oilFriction = lerp(tuning->trackTireFriction, 0.95f, amount);
-                    frictionPairs->setTypePairFriction(0, 0, oilFriction);
-                    frictionPairs->setTypePairFriction(0, 1,
+                    frictionPairs->setTypePairFriction(0, tireTypeOffset + 0, oilFriction);
+                    frictionPairs->setTypePairFriction(0, tireTypeOffset + 1,
                             oilFriction * tuning->rearTireGripPercent);
                 }
                 else
                 {
-                    frictionPairs->setTypePairFriction(0, 0, tuning->trackTireFriction);
-                    frictionPairs->setTypePairFriction(0, 1,
+                    frictionPairs->setTypePairFriction(0, tireTypeOffset + 0, tuning->trackTireFriction);
+                    frictionPairs->setTypePairFriction(0, tireTypeOffset + 1,
                             tuning->trackTireFriction * tuning->rearTireGripPercent);
                 }
             }
@@ -798,59 +768,24 @@ f32 VehiclePhysics::getAverageWheelRotationSpeed() const
     return rotationSpeed;
 }
 
-void VehiclePhysics::checkGroundSpots(PxScene* physicsScene, f32 deltaTime)
+void VehiclePhysics::checkGroundSpots(GroundSpotGrid& groundSpotGrid, f32 deltaTime)
 {
     groundSpots.clear();
 
-    PxOverlapHit hitBuffer[8];
-    PxOverlapBuffer hit(hitBuffer, ARRAY_SIZE(hitBuffer));
-    PxQueryFilterData filter;
-    filter.flags = PxQueryFlag::eSTATIC;
-    filter.data = PxFilterData(COLLISION_FLAG_DUST | COLLISION_FLAG_OIL | COLLISION_FLAG_GLUE, 0, 0, 0);
-    f32 radius = 1.5f;
-    if (physicsScene->overlap(PxSphereGeometry(radius),
-            PxTransform(convert(getPosition()), PxIdentity), hit, filter))
-    {
-        for (u32 i=0; i<hit.getNbTouches(); ++i)
+    groundSpotGrid.query(getPosition(), 1.5f, [&](GroundSpot const& spot, Entity* e) {
+        if (groundSpots.size() == groundSpots.maximumSize())
         {
-            PxActor* actor = hit.getTouch(i).actor;
-            ActorUserData* userData = (ActorUserData*)actor->userData;
-            u32 groundType = GroundSpot::DUST;
-            if ((hit.getTouch(i).shape->getQueryFilterData().word0 & COLLISION_FLAG_OIL)
-                    == COLLISION_FLAG_OIL)
-            {
-                groundType = GroundSpot::OIL;
-            }
-            else if ((hit.getTouch(i).shape->getQueryFilterData().word0 & COLLISION_FLAG_GLUE)
-                    == COLLISION_FLAG_GLUE)
-            {
-                groundType = GroundSpot::GLUE;
-            }
-            assert(userData);
-
-            bool ignore = false;
-            for (auto& igs : ignoredGroundSpots)
-            {
-                if (igs.e == userData->placeableEntity)
-                {
-                    ignore = true;
-                    break;
-                }
-            }
-            if (ignore)
+            return;
+        }
+        for (auto& igs : ignoredGroundSpots)
+        {
+            if (igs.e == e)
             {
-                continue;
+                return;
             }
-
-            groundSpots.push({
-                groundType,
-                userData->placeableEntity->position,
-                max(
-                        absolute(userData->placeableEntity->scale.x),
-                        max(absolute(userData->placeableEntity->scale.y),
-                            absolute(userData->placeableEntity->scale.z))) * 0.48f });
         }
-    }
+        groundSpots.push(spot);
+    });
 
     for (auto it = ignoredGroundSpots.begin(); it != ignoredGroundSpots.end();)
     {
@@ -864,3 +799,160 @@ void VehiclePhysics::checkGroundSpots(PxScene* physicsScene, f32 deltaTime)
     }
 }
 
+
+void VehicleManager::setup(PxScene* scene, u32 maxVehicles)
+{
+    release();
+
+    this->maxVehicles = maxVehicles;
+    u32 partitionCount = (maxVehicles + VEHICLES_PER_PARTITION - 1) / VEHICLES_PER_PARTITION;
+
+    // allocate enough queries for whole partitions so the last partition has a full buffer
+    sceneQueryData = VehicleSceneQueryData::allocate(partitionCount * VEHICLES_PER_PARTITION,
+            NUM_WHEELS, QUERY_HITS_PER_WHEEL, VEHICLES_PER_PARTITION,
+            &WheelSceneQueryPreFilterNonBlocking, &WheelSceneQueryPostFilterNonBlocking,
+            g_game.physx.allocator);
+    for (u32 i=0; i<partitionCount; ++i)
+    {
+        batchQueries.push(VehicleSceneQueryData::setUpBatchedSceneQuery(i, *sceneQueryData, scene));
+    }
+
+    const PxMaterial* surfaceMaterials[] = {
+        g_game.physx.materials.track,
+        g_game.physx.materials.offroad
+    };
+    frictionPairs = createFrictionPairs(
+            max(maxVehicles, 1u) * TIRE_TYPES_PER_VEHICLE, surfaceMaterials);
+
+    vehicles.reserve(maxVehicles);
+    vehicleQueryResults.reserve(maxVehicles);
+    concurrentUpdates.reserve(maxVehicles);
+    wheelConcurrentUpdates.resize(maxVehicles * NUM_WHEELS);
+}
+
+// The batch queries belong to the physics scene, so this has to be called while the scene is still
+// alive. Releasing them after the scene is what used to crash when each vehicle released its own.
+void VehicleManager::release()
+{
+    for (auto batchQuery : batchQueries)
+    {
+        batchQuery->release();
+    }
+    batchQueries.clear();
+    if (sceneQueryData)
+    {
+        sceneQueryData->free(g_game.physx.allocator);
+        sceneQueryData = nullptr;
+    }
+    if (frictionPairs)
+    {
+        frictionPairs->release();
+        frictionPairs = nullptr;
+    }
+    queuedVehicles.clear();
+    maxVehicles = 0;
+}
+
+void VehicleManager::setTireFriction(u32 vehicleSlot, VehicleTuning const& tuning)
+{
+    assert(vehicleSlot < maxVehicles);
+
+    f32 tireFriction[TIRE_TYPES_PER_VEHICLE] = {
+        1.f,
+        tuning.rearTireGripPercent,
+    };
+
+    f32 frictionTable[NUM_SURFACE_TYPES] = {
+        tuning.trackTireFriction,
+        tuning.offroadTireFriction,
+    };
+
+    for(u32 i = 0; i < NUM_SURFACE_TYPES; i++)
+    {
+        for(u32 j = 0; j < TIRE_TYPES_PER_VEHICLE; j++)
+        {
+            frictionPairs->setTypePairFriction(i, vehicleSlot * TIRE_TYPES_PER_VEHICLE + j,
+                    frictionTable[i] * tireFriction[j]);
+        }
+    }
+}
+
+void VehicleManager::update(PxScene* scene, GroundSpotGrid& groundSpotGrid, f32 timestep)
+{
+    TIMED_BLOCK();
+
+    f64 startTime = getTime();
+
+    vehicles.clear();
+    vehicleQueryResults.clear();
+    for (VehiclePhysics* v : queuedVehicles)
+    {
+        vehicles.push(v->vehicle4W);
+        vehicleQueryResults.push({ v->wheelQueryResults, NUM_WHEELS });
+    }
+
+    u32 vehicleCount = vehicles.size();
+    assert(vehicleCount <= maxVehicles);
+    u32 partitionCount = (vehicleCount + VEHICLES_PER_PARTITION - 1) / VEHICLES_PER_PARTITION;
+    const PxVec3 grav = scene->getGravity();
+
+    auto suspensionSweeps = [&](u32 partition) {
+        u32 first = partition * VEHICLES_PER_PARTITION;
+        u32 count = min(vehicleCount - first, VEHICLES_PER_PARTITION);
+        PxVehicleSuspensionSweeps(batchQueries[partition], count, vehicles.data() + first,
+                count * NUM_WHEELS, sceneQueryData->getSweepQueryResultBuffer(partition),
+                QUERY_HITS_PER_WHEEL, NULL, 1.0f, 1.01f);
+    };
+
+    if (g_game.config.gameplay.parallelVehicleUpdates && partitionCount > 1)
+    {
+        // PxVehicleUpdates only writes to the concurrent update data when it is provided, so each
+        // partition can be updated on a different thread and the results applied afterward
+        concurrentUpdates.resize(vehicleCount);
+        for (u32 i=0; i<vehicleCount; ++i)
+        {
+            concurrentUpdates[i] = PxVehicleConcurrentUpdateData();
+            concurrentUpdates[i].concurrentWheelUpdates = wheelConcurrentUpdates.data() + i * NUM_WHEELS;
+            concurrentUpdates[i].nbConcurrentWheelUpdates = NUM_WHEELS;
+        }
+
+        g_threadPool.parallelFor(partitionCount, 1, [&](u32 begin, u32 end) {
+            for (u32 partition=begin; partition<end; ++partition)
+            {
+                suspensionSweeps(partition);
+                u32 first = partition * VEHICLES_PER_PARTITION;
+                u32 count = min(vehicleCount - first, VEHICLES_PER_PARTITION);
+                PxVehicleUpdates(timestep, grav, *frictionPairs, count, vehicles.data() + first,
+                        vehicleQueryResults.data() + first, concurrentUpdates.data() + first);
+            }
+        });
+
+        PxVehiclePostUpdates(concurrentUpdates.data(), vehicleCount, vehicles.data());
+    }
+    else if (vehicleCount > 0)
+    {
+        for (u32 partition=0; partition<partitionCount; ++partition)
+        {
+            suspensionSweeps(partition);
+        }
+        PxVehicleUpdates(timestep, grav, *frictionPairs, vehicleCount, vehicles.data(),
+                vehicleQueryResults.data());
+    }
+
+    for (VehiclePhysics* v : queuedVehicles)
+    {
+        v->onVehicleUpdated(groundSpotGrid, timestep);
+    }
+    queuedVehicles.clear();
+
+    lastPartitionCount = partitionCount;
+    lastUpdateTime = getTime() - startTime;
+}
+
+void VehicleManager::showDebugInfo()
+{
+    ImGui::Text("Vehicle Physics: %.3fms (%u vehicles, %u partitions%s)",
+            lastUpdateTime * 1000.0, vehicles.size(), lastPartitionCount,
+            g_game.config.gameplay.parallelVehicleUpdates ? ", parallel" : "");
+    ImGui::Checkbox("Parallel Vehicle Updates", &g_game.config.gameplay.parallelVehicleUpdates);
+}
@@ -3,6 +3,7 @@
 #include "math.h"
 #include "vehicle_data.h"
 #include "collision_flags.h"
+#include "ground_spot_grid.h"
 
 class VehicleSceneQueryData
 {
@@ -74,19 +75,6 @@ struct WheelInfo
     bool isInAir = false;
 };
 
-struct GroundSpot
-{
-    enum GroundType
-    {
-        DUST,
-        OIL,
-        GLUE,
-    };
-    u32 groundType;
-    Vec3 p;
-    f32 radius;
-};
-
 struct IgnoredGroundSpot
 {
     class Entity* e;
@@ -96,10 +84,10 @@ struct IgnoredGroundSpot
 class VehiclePhysics
 {
     PxVehicleDrive4W* vehicle4W;
-    VehicleSceneQueryData* sceneQueryData;
-    PxBatchQuery* batchQuery;
     PxVehicleDrivableSurfaceToTireFrictionPairs* frictionPairs;
+    u32 tireTypeOffset = 0;
 	f32 engineThrottle = 0.f;
+	f32 accelInput = 0.f;
 	f32 topSpeedHandicapPercent = 1.f;
 	f32 accelHandicapPercent = 1.f;
 	VehicleTuning* tuning;
@@ -110,16 +98,21 @@ class VehiclePhysics
     SmallArray<GroundSpot, 16> groundSpots;
     SmallArray<IgnoredGroundSpot> ignoredGroundSpots;
 
-    void checkGroundSpots(PxScene* physicsScene, f32 deltaTime);
+    void checkGroundSpots(GroundSpotGrid& groundSpotGrid, f32 deltaTime);
     void updateWheelInfo(f32 deltaTime);
+    void onVehicleUpdated(GroundSpotGrid& groundSpotGrid, f32 timestep);
+
+    friend class VehicleManager;
 
 public:
     WheelInfo wheelInfo[NUM_WHEELS];
 
-    void setup(void* userData, PxScene* scene, Mat4 const& transform, VehicleTuning* tuning);
+    void setup(void* userData, PxScene* scene, Mat4 const& transform, VehicleTuning* tuning,
+            class VehicleManager* vehicleManager, u32 vehicleSlot);
     ~VehiclePhysics();
 
-    void update(PxScene* scene, f32 timestep, bool digital, f32 accel, f32 brake, f32 steer,
+    // sets the inputs for the next vehicle update, which is done by the VehicleManager
+    void updateInputs(f32 timestep, bool digital, f32 accel, f32 brake, f32 steer,
             bool handbrake, bool canGo, bool onlyBrake);
     void reset(Mat4 const& transform);
     f32 getEngineRPM() const { return vehicle4W->mDriveDynData.getEngineRotationSpeed() * 9.5493f + 900.f; }
@@ -142,3 +135,41 @@ public:
         topSpeedHandicapPercent = topSpeedPercent;
     }
 };
+
+// Updates all of the vehicles in a scene with batched suspension sweeps and a single
+// PxVehicleUpdates call. With parallel updates enabled the vehicles are split into partitions
+// that are swept and updated on the worker threads.
+class VehicleManager
+{
+public:
+    static constexpr u32 VEHICLES_PER_PARTITION = 4;
+    static constexpr u32 TIRE_TYPES_PER_VEHICLE = 2;
+
+private:
+    VehicleSceneQueryData* sceneQueryData = nullptr;
+    Array<PxBatchQuery*> batchQueries;
+    PxVehicleDrivableSurfaceToTireFrictionPairs* frictionPairs = nullptr;
+    u32 maxVehicles = 0;
+
+    Array<VehiclePhysics*> queuedVehicles;
+    Array<PxVehicleWheels*> vehicles;
+    Array<PxVehicleWheelQueryResult> vehicleQueryResults;
+    Array<PxVehicleConcurrentUpdateData> concurrentUpdates;
+    Array<PxVehicleWheelConcurrentUpdateData> wheelConcurrentUpdates;
+
+    f64 lastUpdateTime = 0.0;
+    u32 lastPartitionCount = 0;
+
+public:
+    ~VehicleManager() { release(); }
+
+    void setup(PxScene* scene, u32 maxVehicles);
+    void release();
+    void setTireFriction(u32 vehicleSlot, VehicleTuning const& tuning);
+    PxVehicleDrivableSurfaceToTireFrictionPairs* getFrictionPairs() const { return frictionPairs; }
+
+    void queueVehicle(VehiclePhysics* vehicle) { queuedVehicles.push(vehicle); }
+    void update(PxScene* scene, GroundSpotGrid& groundSpotGrid, f32 timestep);
+
+    void showDebugInfo();
+};
@@ -0,0 +1,117 @@
+#include "vehicle_preview.h"
+#include "game.h"
+#include "imgui.h"
+
+VehiclePreviewCache::Entry* VehiclePreviewCache::getEntry(const char* name)
+{
+    for (auto& entry : entries)
+    {
+        if (strcmp(entry->name.data(), name) == 0)
+        {
+            return entry.get();
+        }
+    }
+    Entry* entry = new Entry;
+    entry->name = name;
+    entries.push(OwnedPtr<Entry>(entry));
+    return entry;
+}
+
+u64 VehiclePreviewCache::getSignature(VehicleData* vehicle, VehicleConfiguration const& config,
+        f32 angle, u32 width, u32 height, bool isBloomEnabled) const
+{
+    i64 vehicleGuid = vehicle ? vehicle->guid : 0;
+    u64 hash = fnv1a(&vehicleGuid, sizeof(vehicleGuid));
+    hash = fnv1a(&width, sizeof(width), hash);
+    hash = fnv1a(&height, sizeof(height), hash);
+    hash = fnv1a(&angle, sizeof(angle), hash);
+    hash = fnv1a(&isBloomEnabled, sizeof(isBloomEnabled), hash);
+
+    VehicleCosmeticConfiguration const& c = config.cosmetics;
+    hash = fnv1a(&c.color, sizeof(c.color), hash);
+    hash = fnv1a(&c.paintShininess, sizeof(c.paintShininess), hash);
+    hash = fnv1a(c.vinylGuids, sizeof(c.vinylGuids), hash);
+    hash = fnv1a(c.vinylColors, sizeof(c.vinylColors), hash);
+
+    hash = fnv1a(config.weaponIndices, sizeof(config.weaponIndices), hash);
+    hash = fnv1a(config.weaponUpgradeLevel, sizeof(config.weaponUpgradeLevel), hash);
+    for (auto& upgrade : config.performanceUpgrades)
+    {
+        hash = fnv1a(&upgrade.upgradeIndex, sizeof(upgrade.upgradeIndex), hash);
+        hash = fnv1a(&upgrade.upgradeLevel, sizeof(upgrade.upgradeLevel), hash);
+    }
+
+    // zero is used for previews that have never been rendered
+    return hash | 1;
+}
+
+Texture* VehiclePreviewCache::get(const char* name, u32 width, u32 height, VehicleData* vehicle,
+        VehicleConfiguration const& config, VehicleTuning* tuning, f32 angle,
+        bool isMoving, bool isBloomEnabled)
+{
+    if (currentFrame != g_game.frameCount)
+    {
+        currentFrame = g_game.frameCount;
+        lastRenderCount = renderCount;
+        lastHitCount = hitCount;
+        lastDeferredCount = deferredCount;
+        renderCount = 0;
+        budgetedRenderCount = 0;
+        hitCount = 0;
+        deferredCount = 0;
+    }
+
+    Entry* entry = getEntry(name);
+    u64 signature = getSignature(vehicle, config, angle, width, height, isBloomEnabled);
+    if (isCacheEnabled)
+    {
+        if (entry->signature == signature)
+        {
+            ++hitCount;
+            return entry->rw.getTexture();
+        }
+        if (!isMoving && budgetedRenderCount >= MAX_RENDERS_PER_FRAME)
+        {
+            ++deferredCount;
+            return entry->rw.getTexture();
+        }
+    }
+    entry->signature = signature;
+    if (!isMoving)
+    {
+        ++budgetedRenderCount;
+    }
+    ++renderCount;
+    ++totalRenderCount;
+
+    RenderWorld& rw = entry->rw;
+    rw.setName(entry->name.data());
+    rw.setBloomForceOff(!isBloomEnabled);
+    rw.setSize(width, height);
+    Mesh* quadMesh = g_res.getModel("misc")->getMeshByName("Quad");
+    drawSimple(&rw, quadMesh, &g_res.white, Mat4::scaling(Vec3(20.f)), Vec3(0.02f));
+    if (vehicle)
+    {
+        entry->config = config;
+        if (!tuning)
+        {
+            vehicle->initTuning(entry->config, entry->tuning);
+            tuning = &entry->tuning;
+        }
+        vehicle->render(&rw, Mat4::translation(Vec3(0, 0, tuning->getRestOffset())) *
+                Mat4::rotationZ(angle), nullptr, entry->config, tuning);
+    }
+    rw.setViewportCount(1);
+    rw.addDirectionalLight(Vec3(-0.5f, 0.2f, -1.f), Vec3(1.0));
+    rw.setViewportCamera(0, Vec3(8.f, -8.f, 10.f), Vec3(0.f, 0.f, 1.f), 1.f, 50.f, 30.f);
+    g_game.renderer->addRenderWorld(&rw);
+
+    return rw.getTexture();
+}
+
+void VehiclePreviewCache::showDebugInfo()
+{
+    ImGui::Checkbox("Vehicle Preview Cache", &isCacheEnabled);
+    ImGui::Text("Vehicle Previews: %u cached, %u rendered, %u deferred (%u total renders, %u previews)",
+            lastHitCount, lastRenderCount, lastDeferredCount, (u32)totalRenderCount, entries.size());
+}
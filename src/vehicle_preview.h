@@ -0,0 +1,56 @@
+#pragma once
+
+#include "misc.h"
+#include "renderer.h"
+#include "vehicle_data.h"
+
+// Keeps rendered vehicle previews around between frames. A preview is rendered again only when
+// its signature changes (vehicle, paint, vinyls, weapons, upgrades, angle or size). Previews that
+// are moving are rendered every frame, the rest share a small per-frame budget so that opening a
+// menu full of previews spreads the work over a few frames.
+class VehiclePreviewCache
+{
+public:
+    static constexpr u32 MAX_RENDERS_PER_FRAME = 2;
+
+private:
+    struct Entry
+    {
+        Str64 name;
+        RenderWorld rw;
+        u64 signature = 0;
+
+        // the render items point into these until the end of the frame
+        VehicleConfiguration config;
+        VehicleTuning tuning; // only used when the caller doesn't provide one
+    };
+
+    Array<OwnedPtr<Entry>> entries;
+
+    u64 currentFrame = 0;
+    u32 renderCount = 0;
+    u32 budgetedRenderCount = 0;
+    u32 hitCount = 0;
+    u32 deferredCount = 0;
+    u32 lastRenderCount = 0;
+    u32 lastHitCount = 0;
+    u32 lastDeferredCount = 0;
+    u64 totalRenderCount = 0;
+
+    Entry* getEntry(const char* name);
+    u64 getSignature(VehicleData* vehicle, VehicleConfiguration const& config, f32 angle,
+            u32 width, u32 height, bool isBloomEnabled) const;
+
+public:
+    bool isCacheEnabled = true;
+
+    // Returns the texture of the named preview, rendering it this frame if it is out of date and
+    // either isMoving is set or the budget allows it. Otherwise the previous render is returned.
+    // When tuning is null it is computed from the configuration, otherwise it has to stay alive
+    // until the end of the frame.
+    Texture* get(const char* name, u32 width, u32 height, VehicleData* vehicle,
+            VehicleConfiguration const& config, VehicleTuning* tuning, f32 angle=0.f,
+            bool isMoving=false, bool isBloomEnabled=true);
+
+    void showDebugInfo();
+};
@@ -0,0 +1,249 @@
+#include "vinyl_baker.h"
+#include "game.h"
+#include "renderer.h"
+#include "texture.h"
+#include "imgui.h"
+
+GLuint VinylBaker::get(Vec3 const& color, Texture* const vinylTextures[3],
+        Vec4 const vinylColors[3])
+{
+    if (!isBakingEnabled)
+    {
+        ++layeredDrawCount;
+        return 0;
+    }
+
+    GLuint handles[3] = {};
+    Vec4 colors[3] = { Vec4(0.f), Vec4(0.f), Vec4(0.f) };
+    for (u32 i=0; i<3; ++i)
+    {
+        if (vinylTextures[i])
+        {
+            handles[i] = vinylTextures[i]->handle;
+            colors[i] = vinylColors[i];
+        }
+    }
+    u64 key = fnv1a(&color, sizeof(color));
+    key = fnv1a(handles, sizeof(handles), key);
+    key = fnv1a(colors, sizeof(colors), key);
+
+    for (auto& bake : bakes)
+    {
+        if (bake.key == key)
+        {
+            bake.lastUsedFrame = g_game.frameCount;
+            if (bake.texture)
+            {
+                ++bakedDrawCount;
+                return bake.texture;
+            }
+            ++layeredDrawCount;
+            return 0;
+        }
+    }
+
+    // bake at the resolution of the largest layer so the base level loses nothing
+    u32 width = 4;
+    u32 height = 4;
+    for (u32 i=0; i<3; ++i)
+    {
+        if (vinylTextures[i])
+        {
+            width = max(width, vinylTextures[i]->width);
+            height = max(height, vinylTextures[i]->height);
+        }
+    }
+
+    Bake bake;
+    bake.key = key;
+    bake.lastUsedFrame = g_game.frameCount;
+    bake.texture = 0;
+    bake.width = min(width, MAX_TEXTURE_SIZE);
+    bake.height = min(height, MAX_TEXTURE_SIZE);
+    bake.color = color;
+    for (u32 i=0; i<3; ++i)
+    {
+        bake.vinylTextures[i] = handles[i] ? handles[i] : g_res.white.handle;
+        bake.vinylColors[i] = colors[i];
+    }
+    bakes.push(bake);
+    ++layeredDrawCount;
+    return 0;
+}
+
+void VinylBaker::readGpuTimers()
+{
+    GpuTimers& t = gpuTimers[gpuTimerIndex];
+    u32 queryCount = 2 + t.drawCount * 2;
+    u32 firstQuery = t.hasBake ? 0 : 2;
+    if (firstQuery < queryCount)
+    {
+        GLint isAvailable = 0;
+        glGetQueryObjectiv(t.queries[queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable)
+        {
+            GLuint64 timestamps[2 + MAX_TIMED_DRAWS * 2] = {};
+            for (u32 i=firstQuery; i<queryCount; ++i)
+            {
+                glGetQueryObjectui64v(t.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+            }
+            if (t.hasBake)
+            {
+                lastBakeGpuTime = (timestamps[1] - timestamps[0]) / 1000000000.0;
+            }
+            f64 bakedTime = 0.0;
+            f64 layeredTime = 0.0;
+            u32 bakedCount = 0;
+            for (u32 i=0; i<t.drawCount; ++i)
+            {
+                f64 time = (timestamps[3 + i * 2] - timestamps[2 + i * 2]) / 1000000000.0;
+                if (t.isBaked[i])
+                {
+                    bakedTime += time;
+                    ++bakedCount;
+                }
+                else
+                {
+                    layeredTime += time;
+                }
+            }
+            u32 layeredCount = t.drawCount - bakedCount;
+            lastBakedDrawGpuTime = bakedCount > 0 ? bakedTime / bakedCount : 0.0;
+            lastLayeredDrawGpuTime = layeredCount > 0 ? layeredTime / layeredCount : 0.0;
+        }
+    }
+    t.drawCount = 0;
+    t.hasBake = false;
+}
+
+i32 VinylBaker::beginDrawTimer(bool isBaked)
+{
+    GpuTimers& t = gpuTimers[gpuTimerIndex];
+    if (t.drawCount == MAX_TIMED_DRAWS)
+    {
+        return -1;
+    }
+    t.isBaked[t.drawCount] = isBaked;
+    glQueryCounter(t.queries[2 + t.drawCount * 2], GL_TIMESTAMP);
+    return (i32)t.drawCount++;
+}
+
+void VinylBaker::endDrawTimer(i32 timer)
+{
+    if (timer >= 0)
+    {
+        glQueryCounter(gpuTimers[gpuTimerIndex].queries[3 + timer * 2], GL_TIMESTAMP);
+    }
+}
+
+void VinylBaker::update()
+{
+    gpuTimerIndex = (gpuTimerIndex + 1) % MAX_BUFFERED_FRAMES;
+    if (!gpuTimers[gpuTimerIndex].queries[0])
+    {
+        glCreateQueries(GL_TIMESTAMP, ARRAY_SIZE(gpuTimers[gpuTimerIndex].queries),
+                gpuTimers[gpuTimerIndex].queries);
+    }
+    readGpuTimers();
+
+    lastBakedDrawCount = bakedDrawCount;
+    lastLayeredDrawCount = layeredDrawCount;
+    bakedDrawCount = 0;
+    layeredDrawCount = 0;
+
+    for (u32 i=0; i<bakes.size();)
+    {
+        if (bakes[i].lastUsedFrame + EVICTION_FRAMES < g_game.frameCount)
+        {
+            if (bakes[i].texture)
+            {
+                glDeleteTextures(1, &bakes[i].texture);
+            }
+            bakes.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    f64 startTime = getTime();
+    u32 bakeCount = 0;
+    for (auto& bake : bakes)
+    {
+        if (bake.texture)
+        {
+            continue;
+        }
+        if (bakeCount == MAX_BAKES_PER_FRAME)
+        {
+            break;
+        }
+        if (bakeCount == 0)
+        {
+            if (!framebuffer)
+            {
+                glCreateFramebuffers(1, &framebuffer);
+            }
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 1, -1, "Bake Vinyls");
+            glQueryCounter(gpuTimers[gpuTimerIndex].queries[0], GL_TIMESTAMP);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glEnable(GL_FRAMEBUFFER_SRGB);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_BLEND);
+            glDisable(GL_CULL_FACE);
+            glUseProgram(g_game.renderer->getShaderProgram("vinyl_bake"));
+            glBindVertexArray(emptyVAO);
+        }
+        ++bakeCount;
+
+        u32 mipLevels = 1 + (u32)log2f((f32)max(bake.width, bake.height));
+        glCreateTextures(GL_TEXTURE_2D, 1, &bake.texture);
+        glTextureStorage2D(bake.texture, mipLevels, GL_SRGB8_ALPHA8, bake.width, bake.height);
+        glTextureParameteri(bake.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(bake.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameterf(bake.texture, GL_TEXTURE_MAX_ANISOTROPY,
+                max((f32)g_game.config.graphics.anisotropicFilteringLevel, 1.f));
+
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, bake.texture, 0);
+        glViewport(0, 0, bake.width, bake.height);
+        glUniform3fv(0, 1, (GLfloat*)&bake.color);
+        glUniform4fv(1, 3, (GLfloat*)bake.vinylColors);
+        glBindTextureUnit(6, bake.vinylTextures[0]);
+        glBindTextureUnit(7, bake.vinylTextures[1]);
+        glBindTextureUnit(8, bake.vinylTextures[2]);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glGenerateTextureMipmap(bake.texture);
+        ++totalBakeCount;
+    }
+    if (bakeCount > 0)
+    {
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, 0, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glQueryCounter(gpuTimers[gpuTimerIndex].queries[1], GL_TIMESTAMP);
+        gpuTimers[gpuTimerIndex].hasBake = true;
+        glPopDebugGroup();
+        lastBakeTime = getTime() - startTime;
+    }
+    lastBakeCount = bakeCount;
+}
+
+void VinylBaker::showDebugInfo()
+{
+    ImGui::Checkbox("Bake Vehicle Paint", &isBakingEnabled);
+    u32 memory = 0;
+    for (auto& bake : bakes)
+    {
+        if (bake.texture)
+        {
+            memory += bake.width * bake.height * 4 * 4 / 3;
+        }
+    }
+    ImGui::Text("Vehicle Paint: %u vehicles drawn baked, %u layered",
+            lastBakedDrawCount, lastLayeredDrawCount);
+    ImGui::Text("Paint Bakes: %u (%.1fmb), %u this frame (%.3fms), %u total", bakes.size(),
+            memory / (1024.f * 1024.f), lastBakeCount, lastBakeTime * 1000.0, (u32)totalBakeCount);
+    ImGui::Text("Paint GPU Time: %.3fms last bake, %.3fms per baked draw, %.3fms per layered draw",
+            lastBakeGpuTime * 1000.0, lastBakedDrawGpuTime * 1000.0,
+            lastLayeredDrawGpuTime * 1000.0);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "misc.h"
+#include "math.h"
+#include "gl.h"
+
+// Composites the paint color and vinyl layers of a vehicle into one mipmapped texture, so that
+// drawing a vehicle body samples a single texture instead of blending three vinyl layers for every
+// pixel in every pass. Bakes are requested while drawing and done at the start of the next render,
+// a few per frame, and the vehicle is drawn with the layered shader until its bake is ready.
+// Vehicles with the same paint share a bake, and bakes that aren't used for a while are freed.
+class VinylBaker
+{
+public:
+    static constexpr u32 MAX_BAKES_PER_FRAME = 2;
+    static constexpr u32 MAX_TEXTURE_SIZE = 1024;
+    static constexpr u32 EVICTION_FRAMES = 300;
+    static constexpr u32 MAX_TIMED_DRAWS = 16;
+
+private:
+    struct Bake
+    {
+        u64 key;
+        u64 lastUsedFrame;
+        GLuint texture;
+        u32 width;
+        u32 height;
+        Vec3 color;
+        GLuint vinylTextures[3];
+        Vec4 vinylColors[3];
+    };
+
+    Array<Bake> bakes;
+    GLuint framebuffer = 0;
+
+    u32 bakedDrawCount = 0;
+    u32 layeredDrawCount = 0;
+    u32 lastBakedDrawCount = 0;
+    u32 lastLayeredDrawCount = 0;
+    u32 lastBakeCount = 0;
+    f64 lastBakeTime = 0.0;
+    u64 totalBakeCount = 0;
+
+    // GPU timestamps around the bakes and the opaque vehicle body draws of a frame. They are read
+    // when the frame's slot comes around again, and dropped if the GPU isn't done with them yet.
+    // Draws overlap on the GPU, so the draw times are only a rough per-draw cost.
+    struct GpuTimers
+    {
+        GLuint queries[2 + MAX_TIMED_DRAWS * 2];
+        bool isBaked[MAX_TIMED_DRAWS];
+        u32 drawCount;
+        bool hasBake;
+    };
+    GpuTimers gpuTimers[MAX_BUFFERED_FRAMES] = {};
+    u32 gpuTimerIndex = 0;
+    f64 lastBakeGpuTime = 0.0;
+    f64 lastBakedDrawGpuTime = 0.0;
+    f64 lastLayeredDrawGpuTime = 0.0;
+
+    void readGpuTimers();
+
+public:
+    bool isBakingEnabled = true;
+
+    // Returns the baked texture for the paint, or 0 if it isn't baked yet. Vinyl layers with a
+    // null texture are skipped.
+    GLuint get(Vec3 const& color, struct Texture* const vinylTextures[3], Vec4 const vinylColors[3]);
+    // bakes what was requested since the last call and frees unused bakes
+    void update();
+    // Wrap the opaque color draw of a vehicle body. Returns -1 when too many draws are timed
+    // this frame, which endDrawTimer() ignores.
+    i32 beginDrawTimer(bool isBaked);
+    void endDrawTimer(i32 timer);
+    void showDebugInfo();
+};
@@ -2,7 +2,7 @@
 
 #include "../weapon.h"
 #include "../vehicle.h"
-#include "../entities/projectile.h"
+#include "../projectile_system.h"
 
 class WBlaster : public Weapon
 {
@@ -57,10 +57,10 @@ public:
 
         Vec3 pos1 = Vec3(transform * mountTransform * Vec4(projectileSpawnPoints[0], 1.f));
         Vec3 pos2 = Vec3(transform * mountTransform * Vec4(projectileSpawnPoints[1], 1.f));
-        scene->addEntity(new Projectile(pos1, vel, transform.zAxis(), vehicle->vehicleIndex,
-                    Projectile::BLASTER));
-        scene->addEntity(new Projectile(pos2, vel, transform.zAxis(), vehicle->vehicleIndex,
-                    Projectile::BLASTER));
+        scene->projectiles.spawn(pos1, vel, transform.zAxis(), vehicle->vehicleIndex,
+                    ProjectileSystem::BLASTER);
+        scene->projectiles.spawn(pos2, vel, transform.zAxis(), vehicle->vehicleIndex,
+                    ProjectileSystem::BLASTER);
         g_audio.playSound3D(g_res.getSound("blaster"),
                 SoundType::GAME_SFX, vehicle->getPosition(), false,
                 random(scene->randomSeries, 0.95f, 1.05f), 1.f);
@@ -2,7 +2,7 @@
 
 #include "../weapon.h"
 #include "../vehicle.h"
-#include "../entities/projectile.h"
+#include "../projectile_system.h"
 #include "../billboard.h"
 
 class WBouncer : public Weapon
@@ -55,8 +55,8 @@ public:
             vel = normalize(vel) * minSpeed;
         }
         Vec3 pos = Vec3(transform * mountTransform * Vec4(projectileSpawnPoints[0], 1.f));
-        scene->addEntity(new Projectile(pos,
-                vel, transform.zAxis(), vehicle->vehicleIndex, Projectile::BOUNCER));
+        scene->projectiles.spawn(pos,
+                vel, transform.zAxis(), vehicle->vehicleIndex, ProjectileSystem::BOUNCER);
         g_audio.playSound3D(g_res.getSound("bouncer_fire"),
                 SoundType::GAME_SFX, vehicle->getPosition(), false,
                 random(scene->randomSeries, 0.95f, 1.05f), 0.9f);
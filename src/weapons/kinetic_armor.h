@@ -2,7 +2,7 @@
 
 #include "../weapon.h"
 #include "../vehicle.h"
-#include "../entities/projectile.h"
+#include "../projectile_system.h"
 
 class WKineticArmor : public Weapon
 {
@@ -2,7 +2,7 @@
 
 #include "../weapon.h"
 #include "../vehicle.h"
-#include "../entities/projectile.h"
+#include "../projectile_system.h"
 
 class WMachineGun : public Weapon
 {
@@ -70,8 +70,8 @@ public:
             vel = normalize(vel) * minSpeed;
         }
         Vec3 pos = Vec3(transform * mountTransform * Vec4(projectileSpawnPoints[0], 1.f));
-        scene->addEntity(new Projectile(pos,
-                vel, transform.zAxis(), vehicle->vehicleIndex, Projectile::BULLET));
+        scene->projectiles.spawn(pos,
+                vel, transform.zAxis(), vehicle->vehicleIndex, ProjectileSystem::BULLET);
 
         g_audio.playSound3D(g_res.getSound("mg2"),
                 SoundType::GAME_SFX, vehicle->getPosition(), false,
@@ -2,7 +2,7 @@
 
 #include "../weapon.h"
 #include "../vehicle.h"
-#include "../entities/projectile.h"
+#include "../projectile_system.h"
 
 class WScatterGun : public Weapon
 {
@@ -58,8 +58,8 @@ public:
             v += vel + vehicle->getUpVector() * random(scene->randomSeries, -4.f, 4.f);
             v += vehicle->getForwardVector() * random(scene->randomSeries, 0, 10.f);
             Vec3 pos = Vec3(transform * mountTransform * Vec4(projectileSpawnPoints[0], 1.f));
-            scene->addEntity(new Projectile(pos,
-                    v, transform.zAxis(), vehicle->vehicleIndex, Projectile::BULLET_SMALL));
+            scene->projectiles.spawn(pos,
+                    v, transform.zAxis(), vehicle->vehicleIndex, ProjectileSystem::BULLET_SMALL);
         }
         g_audio.playSound3D(g_res.getSound("scattergun"),
                 SoundType::GAME_SFX, vehicle->getPosition(), false,